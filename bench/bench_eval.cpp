@@ -0,0 +1,123 @@
+#include "bench_harness.h"
+#include "board.h"
+#include "evaluate.h"
+#include "move_generation.h"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Static evaluation throughput: one evaluate() call per position against evaluateBatch.
+// Usage: bench_eval [--positions N] [--threads N] [--min-time <ms>] [--json <path|->]
+
+namespace {
+    const char* const kStartPositions[] = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        "r1bq1rk1/pp2ppbp/2np1np1/8/3NP3/2N1BP2/PPPQ2PP/R3KB1R b KQ - 3 9",
+        "2r3k1/pp3ppp/4p3/3n4/3P4/P4N2/1P3PPP/2R3K1 b - - 0 24",
+    };
+
+    // Fixed-seed random walks from the start positions, so every run scores the same set
+    std::vector<Board> generatePositions(size_t count) {
+        std::vector<Board> positions;
+        positions.reserve(count);
+        uint64_t state = 0x9E3779B97F4A7C15ULL;
+        auto random = [&state]() {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            return state;
+        };
+
+        while (positions.size() < count) {
+            for (const char* fen : kStartPositions) {
+                Board board;
+                board.loadFen(fen);
+                for (int ply = 0; ply < 40 && positions.size() < count; ++ply) {
+                    bool isWhite = board.isWhiteToMove();
+                    std::vector<Move> moves = MoveGeneration::filterLegalMoves(board, board.generateMoves(isWhite), isWhite);
+                    if (moves.empty()) {
+                        break;
+                    }
+                    board.makeMove(moves[random() % moves.size()]);
+                    positions.push_back(board);
+                }
+            }
+        }
+        return positions;
+    }
+}
+
+int main(int argc, char** argv) {
+    size_t count = 1 << 16;
+    int maxThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    double minSeconds = 0.25;
+    std::string jsonPath;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--positions" && i + 1 < argc) {
+            count = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            maxThreads = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--min-time" && i + 1 < argc) {
+            minSeconds = std::atof(argv[++i]) / 1000.0;
+        } else if (arg == "--json" && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else {
+            std::cerr << "usage: bench_eval [--positions N] [--threads N] [--min-time <ms>] [--json <path|->]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<Board> positions = generatePositions(count);
+    std::vector<int> scores(positions.size());
+
+    // The batch path must agree with the scalar evaluator before it is worth timing
+    Evaluation::evaluateBatch(positions.data(), positions.size(), scores.data(), maxThreads);
+    for (size_t i = 0; i < positions.size(); ++i) {
+        if (scores[i] != Evaluation::evaluate(positions[i])) {
+            std::cerr << "bench_eval: batch score mismatch at position " << i << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<Bench::Result> results;
+    results.push_back(Bench::run("Evaluation::evaluate per position", minSeconds, [&]() -> uint64_t {
+        for (size_t i = 0; i < positions.size(); ++i) {
+            scores[i] = Evaluation::evaluate(positions[i]);
+        }
+        Bench::sink += scores.back();
+        return positions.size();
+    }));
+
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads < maxThreads; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(maxThreads);
+    for (int threads : threadCounts) {
+        results.push_back(Bench::run("Evaluation::evaluateBatch " + std::to_string(threads) + " thread(s)", minSeconds,
+                                     [&]() -> uint64_t {
+            Evaluation::evaluateBatch(positions.data(), positions.size(), scores.data(), threads);
+            Bench::sink += scores.back();
+            return positions.size();
+        }));
+    }
+
+    // ops/sec is positions/sec
+    if (jsonPath == "-") {
+        Bench::printJson(std::cout, "bench_eval", results);
+    } else {
+        Bench::printTable(std::cout, results);
+        if (!jsonPath.empty()) {
+            std::ofstream jsonFile(jsonPath);
+            Bench::printJson(jsonFile, "bench_eval", results);
+        }
+    }
+    return 0;
+}
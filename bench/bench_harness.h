@@ -0,0 +1,77 @@
+#ifndef BENCH_HARNESS_H
+#define BENCH_HARNESS_H
+
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Minimal timing harness shared by the benchmark executables
+namespace Bench {
+    // Results are folded into this so the optimiser cannot drop the measured calls
+    inline volatile uint64_t sink = 0;
+
+    struct Result {
+        std::string name;
+        uint64_t ops;
+        double seconds;
+
+        double nsPerOp() const { return ops ? seconds * 1e9 / static_cast<double>(ops) : 0.0; }
+        double opsPerSec() const { return seconds > 0.0 ? static_cast<double>(ops) / seconds : 0.0; }
+    };
+
+    // Repeats one pass of fn (which returns the number of operations it performed)
+    // until at least minSeconds have elapsed, after a single untimed warm-up pass
+    template <typename Fn>
+    Result run(const std::string& name, double minSeconds, Fn&& fn) {
+        using Clock = std::chrono::steady_clock;
+        fn();
+
+        uint64_t ops = 0;
+        double elapsed = 0.0;
+        Clock::time_point start = Clock::now();
+        do {
+            ops += fn();
+            elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        } while (elapsed < minSeconds);
+
+        return Result{name, ops, elapsed};
+    }
+
+    // Discards everything written to it; used to silence debug output while timing
+    class NullBuffer : public std::streambuf {
+    protected:
+        int overflow(int c) override { return c; }
+    };
+
+    inline void printTable(std::ostream& out, const std::vector<Result>& results) {
+        out << std::left << std::setw(48) << "benchmark"
+            << std::right << std::setw(14) << "ns/op"
+            << std::setw(16) << "ops/sec"
+            << std::setw(14) << "ops" << "\n";
+        for (const Result& result : results) {
+            out << std::left << std::setw(48) << result.name
+                << std::right << std::fixed << std::setprecision(1) << std::setw(14) << result.nsPerOp()
+                << std::setprecision(0) << std::setw(16) << result.opsPerSec()
+                << std::setw(14) << result.ops << "\n";
+        }
+    }
+
+    inline void printJson(std::ostream& out, const std::string& suite, const std::vector<Result>& results) {
+        out << "{\n  \"suite\": \"" << suite << "\",\n  \"results\": [\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result& result = results[i];
+            out << "    {\"name\": \"" << result.name << "\""
+                << ", \"ops\": " << result.ops
+                << std::fixed << std::setprecision(6) << ", \"seconds\": " << result.seconds
+                << std::setprecision(3) << ", \"ns_per_op\": " << result.nsPerOp()
+                << std::setprecision(1) << ", \"ops_per_sec\": " << result.opsPerSec() << "}"
+                << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        out << "  ]\n}\n";
+    }
+}
+
+#endif // BENCH_HARNESS_H
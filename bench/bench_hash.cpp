@@ -0,0 +1,100 @@
+#include "bench_harness.h"
+#include "large_pages.h"
+#include "transposition_table.h"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Transposition table probe cost with the table on each page size the system can provide.
+// "dependent" probes chain each key on the previous result, so they measure latency; the
+// independent ones let the CPU overlap misses and measure throughput.
+// Usage: bench_hash [--hash MB] [--probes N] [--min-time <ms>] [--json <path|->]
+
+namespace {
+    uint64_t nextKey(uint64_t& state) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+}
+
+int main(int argc, char** argv) {
+    size_t megabytes = 256;
+    uint64_t probes = 1 << 20;
+    double minSeconds = 0.25;
+    std::string jsonPath;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--hash" && i + 1 < argc) {
+            megabytes = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--probes" && i + 1 < argc) {
+            probes = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--min-time" && i + 1 < argc) {
+            minSeconds = std::atof(argv[++i]) / 1000.0;
+        } else if (arg == "--json" && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else {
+            std::cerr << "usage: bench_hash [--hash MB] [--probes N] [--min-time <ms>] [--json <path|->]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<Bench::Result> results;
+    for (LargePages::Mode request : {LargePages::Mode::Normal, LargePages::Mode::Transparent, LargePages::Mode::Explicit}) {
+        TranspositionTable table(megabytes, request);
+
+        // A request the system cannot meet falls back; skip it rather than time a mode twice
+        if (table.pageMode() != request) {
+            std::cerr << "bench_hash: " << LargePages::modeName(request) << " unavailable, got "
+                      << LargePages::modeName(table.pageMode()) << std::endl;
+            continue;
+        }
+
+        // Fill about half the slots so probes see a realistic mix of hits and misses
+        uint64_t state = 0x9E3779B97F4A7C15ULL;
+        for (uint64_t i = 0; i < megabytes * 1024 * 1024 / 32; ++i) {
+            uint64_t key = nextKey(state);
+            table.store(key, static_cast<int>(key & 31), static_cast<int>(key >> 48) - 32768, BoundExact,
+                        static_cast<uint16_t>(key >> 16));
+        }
+
+        std::string mode = LargePages::modeName(request);
+        results.push_back(Bench::run("probe dependent, " + mode, minSeconds, [&]() -> uint64_t {
+            uint64_t key = 0x2545F4914F6CDD1DULL;
+            uint64_t found = 0;
+            TTEntry entry;
+            for (uint64_t i = 0; i < probes; ++i) {
+                found += table.probe(key, entry);
+                key = (key ^ (key >> 29) ^ entry.move) * 0xBF58476D1CE4E5B9ULL + found;
+            }
+            Bench::sink += found;
+            return probes;
+        }));
+        results.push_back(Bench::run("probe independent, " + mode, minSeconds, [&]() -> uint64_t {
+            uint64_t keyState = 0x2545F4914F6CDD1DULL;
+            uint64_t found = 0;
+            TTEntry entry;
+            for (uint64_t i = 0; i < probes; ++i) {
+                found += table.probe(nextKey(keyState), entry);
+            }
+            Bench::sink += found;
+            return probes;
+        }));
+    }
+
+    // ops/sec is probes/sec
+    if (jsonPath == "-") {
+        Bench::printJson(std::cout, "bench_hash", results);
+    } else {
+        Bench::printTable(std::cout, results);
+        if (!jsonPath.empty()) {
+            std::ofstream jsonFile(jsonPath);
+            Bench::printJson(jsonFile, "bench_hash", results);
+        }
+    }
+    return 0;
+}
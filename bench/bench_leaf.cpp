@@ -0,0 +1,144 @@
+#include "bench_harness.h"
+#include "board.h"
+#include "leaf_kernel.h"
+#include "move_generation.h"
+#include "perft.h"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Legal move counting at the leaves: generate-and-filter per position against the multi-board
+// kernel on each SIMD width, then whole perft runs with the kernel counting the last ply.
+// Usage: bench_leaf [--positions N] [--depth N] [--min-time <ms>] [--json <path|->]
+
+namespace {
+    const char* const kStartPositions[] = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    };
+
+    // Fixed-seed random walks from the start positions, so every run counts the same set
+    std::vector<Board> generatePositions(size_t count) {
+        std::vector<Board> positions;
+        positions.reserve(count);
+        uint64_t state = 0x9E3779B97F4A7C15ULL;
+        auto random = [&state]() {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            return state;
+        };
+
+        while (positions.size() < count) {
+            for (const char* fen : kStartPositions) {
+                Board board;
+                board.loadFen(fen);
+                for (int ply = 0; ply < 40 && positions.size() < count; ++ply) {
+                    bool isWhite = board.isWhiteToMove();
+                    std::vector<Move> moves = MoveGeneration::filterLegalMoves(board, board.generateMoves(isWhite), isWhite);
+                    if (moves.empty()) {
+                        break;
+                    }
+                    board.makeMove(moves[random() % moves.size()]);
+                    positions.push_back(board);
+                }
+            }
+        }
+        return positions;
+    }
+}
+
+int main(int argc, char** argv) {
+    size_t count = 1 << 14;
+    int depth = 4;
+    double minSeconds = 0.25;
+    std::string jsonPath;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--positions" && i + 1 < argc) {
+            count = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--depth" && i + 1 < argc) {
+            depth = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--min-time" && i + 1 < argc) {
+            minSeconds = std::atof(argv[++i]) / 1000.0;
+        } else if (arg == "--json" && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else {
+            std::cerr << "usage: bench_leaf [--positions N] [--depth N] [--min-time <ms>] [--json <path|->]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<Board> positions = generatePositions(count);
+    std::vector<uint32_t> expected(positions.size()), counts(positions.size());
+    for (size_t i = 0; i < positions.size(); ++i) {
+        bool isWhite = positions[i].isWhiteToMove();
+        MoveList moves;
+        positions[i].generateMoves(isWhite, moves);
+        for (const Move& move : moves) {
+            expected[i] += MoveGeneration::isMoveLegal(positions[i], move, isWhite);
+        }
+    }
+
+    const LeafKernel::Path paths[] = {LeafKernel::Path::Scalar, LeafKernel::Path::Avx2, LeafKernel::Path::Avx512};
+    std::vector<Bench::Result> results;
+    results.push_back(Bench::run("legal count, generate + isMoveLegal", minSeconds, [&]() -> uint64_t {
+        uint64_t total = 0;
+        for (const Board& board : positions) {
+            bool isWhite = board.isWhiteToMove();
+            MoveList moves;
+            board.generateMoves(isWhite, moves);
+            for (const Move& move : moves) {
+                total += MoveGeneration::isMoveLegal(board, move, isWhite);
+            }
+        }
+        Bench::sink += total;
+        return positions.size();
+    }));
+    for (LeafKernel::Path path : paths) {
+        if (!LeafKernel::available(path)) {
+            continue;
+        }
+        // The kernel must agree with move generation before it is worth timing
+        LeafKernel::countLegalMoves(positions.data(), positions.size(), counts.data(), path);
+        if (counts != expected) {
+            std::cerr << "bench_leaf: " << LeafKernel::pathName(path) << " count mismatch" << std::endl;
+            return 1;
+        }
+        results.push_back(Bench::run(std::string("legal count, kernel ") + LeafKernel::pathName(path), minSeconds,
+                                     [&]() -> uint64_t {
+            LeafKernel::countLegalMoves(positions.data(), positions.size(), counts.data(), path);
+            Bench::sink += counts.back();
+            return positions.size();
+        }));
+    }
+
+    Board start;
+    start.loadFen(kStartPositions[1]);
+    results.push_back(Bench::run("perft " + std::to_string(depth) + " kiwipete, perftCopyMake", minSeconds, [&]() -> uint64_t {
+        return Perft::perftCopyMake(start, depth);
+    }));
+    for (LeafKernel::Path path : paths) {
+        if (LeafKernel::available(path)) {
+            results.push_back(Bench::run("perft " + std::to_string(depth) + " kiwipete, kernel " + LeafKernel::pathName(path),
+                                         minSeconds, [&]() -> uint64_t { return LeafKernel::perft(start, depth, path); }));
+        }
+    }
+
+    // ops/sec is positions/sec for the counts and leaf nodes/sec for perft
+    if (jsonPath == "-") {
+        Bench::printJson(std::cout, "bench_leaf", results);
+    } else {
+        Bench::printTable(std::cout, results);
+        if (!jsonPath.empty()) {
+            std::ofstream jsonFile(jsonPath);
+            Bench::printJson(jsonFile, "bench_leaf", results);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,283 @@
+#include "bench_harness.h"
+#include "attacks.h"
+#include "board.h"
+#include "move_generation.h"
+#include "move.h"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Microbenchmarks for the move generation hot path.
+// Usage: bench_movegen [--min-time <ms>] [--filter <substring>] [--json <path|->]
+
+namespace {
+    // Opening, middlegame and endgame positions, including the standard perft suite
+    const char* const kPositions[] = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        "rnbqkbnr/pp1ppppp/8/2p5/4P3/5N2/PPPP1PPP/RNBQKB1R b KQkq - 1 2",
+        "r1bq1rk1/pp2ppbp/2np1np1/8/3NP3/2N1BP2/PPPQ2PP/R3KB1R b KQ - 3 9",
+        "2r3k1/pp3ppp/4p3/3n4/3P4/P4N2/1P3PPP/2R3K1 b - - 0 24",
+        "8/8/4k3/3p4/3P4/4K3/8/8 w - - 0 60",
+    };
+
+    struct Position {
+        Board board;
+        bool isWhite;
+        std::vector<Move> moves;
+    };
+
+    std::vector<Position> loadPositions() {
+        std::vector<Position> positions;
+        for (const char* fen : kPositions) {
+            Position position;
+            if (!position.board.loadFen(fen)) {
+                std::cerr << "bench_movegen: bad FEN " << fen << std::endl;
+                std::exit(1);
+            }
+            position.isWhite = position.board.isWhiteToMove();
+            position.moves = position.board.generateMoves(position.isWhite);
+            positions.push_back(position);
+        }
+        return positions;
+    }
+}
+
+int main(int argc, char** argv) {
+    double minSeconds = 0.25;
+    std::string filter;
+    std::string jsonPath;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--min-time" && i + 1 < argc) {
+            minSeconds = std::atof(argv[++i]) / 1000.0;
+        } else if (arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (arg == "--json" && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else {
+            std::cerr << "usage: bench_movegen [--min-time <ms>] [--filter <substring>] [--json <path|->]" << std::endl;
+            return 1;
+        }
+    }
+
+    // Debug output from the generators is discarded while positions are loaded and timed
+    Bench::NullBuffer nullBuffer;
+    std::streambuf* coutBuffer = std::cout.rdbuf(&nullBuffer);
+
+    std::vector<Position> positions = loadPositions();
+    std::vector<Bench::Result> results;
+
+    // Moves to validate, as hash moves would arrive: every position's own moves, some legal
+    // here and most not
+    std::vector<uint16_t> candidates;
+    for (const Position& position : positions) {
+        for (const Move& move : position.moves) {
+            candidates.push_back(move.pack());
+        }
+    }
+
+    auto bench = [&](const std::string& name, auto&& fn) {
+        if (filter.empty() || name.find(filter) != std::string::npos) {
+            results.push_back(Bench::run(name, minSeconds, fn));
+        }
+    };
+
+    bench("Board::generateMoves", [&]() -> uint64_t {
+        for (const Position& position : positions) {
+            Bench::sink += position.board.generateMoves(position.isWhite).size();
+        }
+        return positions.size();
+    });
+
+    bench("MoveGeneration::filterLegalMoves", [&]() -> uint64_t {
+        for (const Position& position : positions) {
+            Bench::sink += MoveGeneration::filterLegalMoves(position.board, position.moves, position.isWhite).size();
+        }
+        return positions.size();
+    });
+
+    bench("Board::makeMove+undoMove", [&]() -> uint64_t {
+        uint64_t ops = 0;
+        for (const Position& position : positions) {
+            Board board = position.board;
+            for (const Move& move : position.moves) {
+                board.makeMove(move);
+                Bench::sink += board.getOccupiedSquares();
+                board.undoMove(move);
+            }
+            ops += position.moves.size();
+        }
+        return ops;
+    });
+
+    // The copy-make alternative: copy the parent into a child slot and play the move there
+    bench("Board copy+makeMove", [&]() -> uint64_t {
+        uint64_t ops = 0;
+        Board child;
+        for (const Position& position : positions) {
+            for (const Move& move : position.moves) {
+                child = position.board;
+                child.makeMove(move);
+                Bench::sink += child.getOccupiedSquares();
+            }
+            ops += position.moves.size();
+        }
+        return ops;
+    });
+
+    // One move checked on its own, against generating, filtering and searching the move list
+    bench("Board::isLegal", [&]() -> uint64_t {
+        for (const Position& position : positions) {
+            for (uint16_t move : candidates) {
+                Bench::sink += position.board.isLegal(move);
+            }
+        }
+        return positions.size() * candidates.size();
+    });
+
+    bench("generateMoves+filterLegalMoves+find", [&]() -> uint64_t {
+        for (const Position& position : positions) {
+            for (uint16_t move : candidates) {
+                const Board& board = position.board;
+                for (const Move& legal : MoveGeneration::filterLegalMoves(board, board.generateMoves(position.isWhite), position.isWhite)) {
+                    if (legal.pack() == move) {
+                        ++Bench::sink;
+                        break;
+                    }
+                }
+            }
+        }
+        return positions.size() * candidates.size();
+    });
+
+    // Whether each move checks: the check info of the position plus one query per move,
+    // against playing the move on a copy and looking at the king
+    bench("Board::checkInfo+givesCheck", [&]() -> uint64_t {
+        uint64_t ops = 0;
+        for (const Position& position : positions) {
+            CheckInfo info = position.board.checkInfo();
+            for (const Move& move : position.moves) {
+                Bench::sink += position.board.givesCheck(move, info);
+            }
+            ops += position.moves.size();
+        }
+        return ops;
+    });
+
+    bench("Board copy+makeMove+isInCheck", [&]() -> uint64_t {
+        uint64_t ops = 0;
+        Board child;
+        for (const Position& position : positions) {
+            for (const Move& move : position.moves) {
+                child = position.board;
+                child.makeMove(move);
+                Bench::sink += child.isInCheck();
+            }
+            ops += position.moves.size();
+        }
+        return ops;
+    });
+
+    bench("MoveGeneration::isSquareAttacked", [&]() -> uint64_t {
+        for (const Position& position : positions) {
+            for (int square = 0; square < 64; ++square) {
+                Bench::sink += MoveGeneration::isSquareAttacked(square, position.board, !position.isWhite);
+            }
+        }
+        return positions.size() * 64;
+    });
+
+    bench("Board::generateOpponentAttacks", [&]() -> uint64_t {
+        for (const Position& position : positions) {
+            Bench::sink += position.board.generateOpponentAttacks(position.isWhite);
+        }
+        return positions.size();
+    });
+
+    // Per-piece-type maps for one side, default kernel (AVX2 when built with it) and scalar fills
+    bench(Attacks::simdEnabled ? "Attacks::attackMap (AVX2)" : "Attacks::attackMap (scalar)", [&]() -> uint64_t {
+        for (const Position& position : positions) {
+            Bench::sink += Attacks::attackMap(position.board, position.isWhite ? White : Black).all;
+        }
+        return positions.size();
+    });
+
+    bench("Attacks::sliderAttacksScalar", [&]() -> uint64_t {
+        for (const Position& position : positions) {
+            const Board& board = position.board;
+            PieceColor side = position.isWhite ? White : Black;
+            uint64_t bishops, rooks, queens;
+            Attacks::sliderAttacksScalar(board.getPieces(side, Bishop), board.getPieces(side, Rook),
+                                         board.getPieces(side, Queen), board.getOccupiedSquares(), bishops, rooks, queens);
+            Bench::sink += bishops | rooks | queens;
+        }
+        return positions.size();
+    });
+
+    bench("Attacks::sliderAttacks", [&]() -> uint64_t {
+        for (const Position& position : positions) {
+            const Board& board = position.board;
+            PieceColor side = position.isWhite ? White : Black;
+            uint64_t bishops, rooks, queens;
+            Attacks::sliderAttacks(board.getPieces(side, Bishop), board.getPieces(side, Rook),
+                                   board.getPieces(side, Queen), board.getOccupiedSquares(), bishops, rooks, queens);
+            Bench::sink += bishops | rooks | queens;
+        }
+        return positions.size();
+    });
+
+    bench("MoveGeneration::generateBishopMovesFromSquare", [&]() -> uint64_t {
+        for (const Position& position : positions) {
+            uint64_t occupied = position.board.getOccupiedSquares();
+            for (int square = 0; square < 64; ++square) {
+                Bench::sink += MoveGeneration::generateBishopMovesFromSquare(square, occupied);
+            }
+        }
+        return positions.size() * 64;
+    });
+
+    bench("MoveGeneration::generateRookMovesFromSquare", [&]() -> uint64_t {
+        for (const Position& position : positions) {
+            uint64_t occupied = position.board.getOccupiedSquares();
+            for (int square = 0; square < 64; ++square) {
+                Bench::sink += MoveGeneration::generateRookMovesFromSquare(square, occupied);
+            }
+        }
+        return positions.size() * 64;
+    });
+
+    bench("MoveGeneration::generateQueenMoves", [&]() -> uint64_t {
+        for (const Position& position : positions) {
+            const Board& board = position.board;
+            uint64_t moves, captures;
+            bool white = position.isWhite;
+            MoveGeneration::generateQueenMoves(white ? board.getWhiteQueens() : board.getBlackQueens(),
+                                               white ? board.getWhitePieces() : board.getBlackPieces(),
+                                               white ? board.getBlackPieces() : board.getWhitePieces(),
+                                               board.getOccupiedSquares(), moves, captures);
+            Bench::sink += moves ^ captures;
+        }
+        return positions.size();
+    });
+
+    std::cout.rdbuf(coutBuffer);
+
+    if (jsonPath == "-") {
+        Bench::printJson(std::cout, "bench_movegen", results);
+    } else {
+        Bench::printTable(std::cout, results);
+        if (!jsonPath.empty()) {
+            std::ofstream jsonFile(jsonPath);
+            Bench::printJson(jsonFile, "bench_movegen", results);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,110 @@
+#include "bench_harness.h"
+#include "board.h"
+#include "move_generation.h"
+#include "search.h"
+#include "transposition_table.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Time to depth on a repeated workload with a file-backed transposition table: a pass with a
+// private table for reference, one with a new (empty) file, then passes that each map the file
+// afresh with a new searcher, as a following process would. ns/op is the mean time to depth
+// per position.
+// Usage: bench_tt_file [--depth N] [--hash MB] [--runs N] [--file PATH] [--json <path|->]
+
+namespace {
+    const char* const kPositions[] = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "rnbqkbnr/pppp1ppp/8/4p3/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 2",
+        "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3",
+        "r1bqkbnr/pppp1ppp/2n5/1B2p3/4P3/5N2/PPPP1PPP/RNBQK2R b KQkq - 3 3",
+        "rnbqkb1r/pppppppp/5n2/8/2PP4/8/PP2PPPP/RNBQKBNR b KQkq c3 0 2",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        "2r3k1/pp3ppp/4p3/3n4/3P4/P4N2/1P3PPP/2R3K1 b - - 0 24",
+    };
+
+    // One pass over every position with a table mapped from path, or a private one if path is empty
+    bool runPass(const std::string& path, size_t megabytes, int depth, double& seconds, uint64_t& nodes) {
+        TranspositionTable table(path.empty() ? megabytes : 1);
+        std::string error;
+        if (!path.empty() && !table.mapFile(path, megabytes, error)) {
+            std::cerr << "bench_tt_file: " << error << std::endl;
+            return false;
+        }
+        Search::Searcher searcher(table);
+        Search::Limits limits;
+        limits.depth = depth;
+
+        seconds = 0.0;
+        nodes = 0;
+        for (const char* fen : kPositions) {
+            Board board;
+            board.loadFen(fen);
+            searcher.clear();
+            auto start = std::chrono::steady_clock::now();
+            Search::Result result = searcher.search(board, limits);
+            seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            nodes += result.nodes;
+        }
+        return true;
+    }
+}
+
+int main(int argc, char** argv) {
+    int depth = 8;
+    size_t megabytes = 64;
+    int runs = 2;
+    std::string path = "bench_tt_file.tt";
+    std::string jsonPath;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--depth" && i + 1 < argc) {
+            depth = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--hash" && i + 1 < argc) {
+            megabytes = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--runs" && i + 1 < argc) {
+            runs = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--file" && i + 1 < argc) {
+            path = argv[++i];
+        } else if (arg == "--json" && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else {
+            std::cerr << "usage: bench_tt_file [--depth N] [--hash MB] [--runs N] [--file PATH] [--json <path|->]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::remove(path.c_str());
+
+    std::vector<Bench::Result> results;
+    for (int run = -1; run <= runs; ++run) {
+        double seconds = 0.0;
+        uint64_t nodes = 0;
+        if (!runPass(run < 0 ? std::string() : path, megabytes, depth, seconds, nodes)) {
+            return 1;
+        }
+        std::string name = run < 0 ? "private table, depth " + std::to_string(depth)
+                         : run == 0 ? "cold file, depth " + std::to_string(depth)
+                                    : "warm file run " + std::to_string(run) + ", depth " + std::to_string(depth);
+        std::cerr << name << ": " << nodes << " nodes, " << static_cast<uint64_t>(seconds * 1000) << " ms" << std::endl;
+        results.push_back(Bench::Result{name, std::size(kPositions), seconds});
+    }
+    std::remove(path.c_str());
+
+    if (jsonPath == "-") {
+        Bench::printJson(std::cout, "bench_tt_file", results);
+    } else {
+        Bench::printTable(std::cout, results);
+        if (!jsonPath.empty()) {
+            std::ofstream jsonFile(jsonPath);
+            Bench::printJson(jsonFile, "bench_tt_file", results);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,128 @@
+#ifndef ATTACKS_H
+#define ATTACKS_H
+
+#include <cstdint>
+#include "board.h"
+#include "move.h"
+#include "move_generation.h"
+
+// Set-wise attack generation: every piece of a kind is handled at once with shifts and
+// Kogge-Stone occluded fills, instead of walking rays square by square. With ENGINE_AVX2
+// the slider fills run four directions per instruction in AVX2 lanes; otherwise (or when
+// Attacks::simdEnabled is false) the scalar fills below are used.
+namespace Attacks {
+#ifdef ENGINE_AVX2
+    constexpr bool simdEnabled = true;
+#else
+    constexpr bool simdEnabled = false;
+#endif
+
+    // Attack maps of one side, per piece type (indexed by PieceType, [0] unused) and combined
+    struct AttackMap {
+        uint64_t byPiece[7];
+        uint64_t all;
+    };
+
+    inline uint64_t knightAttacks(uint64_t knights) {
+        constexpr uint64_t NotFileAB = 0xFCFCFCFCFCFCFCFCULL;
+        constexpr uint64_t NotFileGH = 0x3F3F3F3F3F3F3F3FULL;
+        uint64_t oneFile = ((knights << 1) & MoveGeneration::NotFileA) | ((knights >> 1) & MoveGeneration::NotFileH);
+        uint64_t twoFiles = ((knights << 2) & NotFileAB) | ((knights >> 2) & NotFileGH);
+        return (oneFile << 16) | (oneFile >> 16) | (twoFiles << 8) | (twoFiles >> 8);
+    }
+
+    inline uint64_t kingAttacks(uint64_t king) {
+        uint64_t attacks = ((king << 1) & MoveGeneration::NotFileA) | ((king >> 1) & MoveGeneration::NotFileH);
+        uint64_t row = king | attacks;
+        return attacks | (row << 8) | (row >> 8);
+    }
+
+    // Squares a move in Direction from a set can land on without wrapping round the board edge
+    template <int Direction>
+    constexpr uint64_t wrapMask() {
+        return (Direction == 1 || Direction == 9 || Direction == -7) ? MoveGeneration::NotFileA
+             : (Direction == -1 || Direction == -9 || Direction == 7) ? MoveGeneration::NotFileH
+             : ~0ULL;
+    }
+
+    // Kogge-Stone occluded fill: every square the generators reach in Direction through
+    // empty squares, plus the first blocker on each ray
+    template <int Direction>
+    inline uint64_t slide(uint64_t generators, uint64_t empty) {
+        using MoveGeneration::shift;
+        constexpr uint64_t mask = wrapMask<Direction>();
+        uint64_t propagators = empty & mask;
+        generators |= propagators & shift<Direction>(generators);
+        propagators &= shift<Direction>(propagators);
+        generators |= propagators & shift<2 * Direction>(generators);
+        propagators &= shift<2 * Direction>(propagators);
+        generators |= propagators & shift<4 * Direction>(generators);
+        return shift<Direction>(generators) & mask;
+    }
+
+    // For every pair of squares on a shared rank, file or diagonal: the squares strictly
+    // between them, and the whole line through both, edge to edge. Pairs that share no line
+    // have neither.
+    struct LineTables {
+        uint64_t between[64][64];
+        uint64_t line[64][64];
+    };
+
+    constexpr LineTables generateLineTables() {
+        constexpr int directions[4][2] = {{0, 1}, {1, 0}, {1, 1}, {1, -1}};
+        LineTables tables{};
+        for (int square = 0; square < 64; ++square) {
+            for (const auto& direction : directions) {
+                // The full line through square in this direction and the opposite one
+                uint64_t line = 1ULL << square;
+                for (int sign = -1; sign <= 1; sign += 2) {
+                    int rank = square / 8 + sign * direction[0], file = square % 8 + sign * direction[1];
+                    for (; rank >= 0 && rank < 8 && file >= 0 && file < 8; rank += sign * direction[0], file += sign * direction[1]) {
+                        line |= 1ULL << (rank * 8 + file);
+                    }
+                }
+                for (int sign = -1; sign <= 1; sign += 2) {
+                    uint64_t between = 0;
+                    int rank = square / 8 + sign * direction[0], file = square % 8 + sign * direction[1];
+                    for (; rank >= 0 && rank < 8 && file >= 0 && file < 8; rank += sign * direction[0], file += sign * direction[1]) {
+                        int target = rank * 8 + file;
+                        tables.between[square][target] = between;
+                        tables.line[square][target] = line;
+                        between |= 1ULL << target;
+                    }
+                }
+            }
+        }
+        return tables;
+    }
+
+    inline constexpr LineTables lineTables = generateLineTables();
+
+    inline uint64_t between(int from, int to) { return lineTables.between[from][to]; }
+    inline uint64_t line(int from, int to) { return lineTables.line[from][to]; }
+
+    inline uint64_t diagonalAttacksScalar(uint64_t sliders, uint64_t empty) {
+        return slide<9>(sliders, empty) | slide<7>(sliders, empty) | slide<-7>(sliders, empty) | slide<-9>(sliders, empty);
+    }
+
+    inline uint64_t straightAttacksScalar(uint64_t sliders, uint64_t empty) {
+        return slide<8>(sliders, empty) | slide<-8>(sliders, empty) | slide<1>(sliders, empty) | slide<-1>(sliders, empty);
+    }
+
+    // Slider attacks for bishops, rooks and queens of one side, each set filled separately
+    void sliderAttacks(uint64_t bishops, uint64_t rooks, uint64_t queens, uint64_t occupied,
+                       uint64_t& bishopAttacks, uint64_t& rookAttacks, uint64_t& queenAttacks);
+    void sliderAttacksScalar(uint64_t bishops, uint64_t rooks, uint64_t queens, uint64_t occupied,
+                             uint64_t& bishopAttacks, uint64_t& rookAttacks, uint64_t& queenAttacks);
+
+    // Union of the slider attacks, with queens folded into both direction groups
+    uint64_t sliderAttacks(uint64_t diagonal, uint64_t straight, uint64_t occupied);
+
+    // Full per-piece-type map, for mobility and king safety terms
+    AttackMap attackMap(const Board& board, PieceColor side);
+
+    // Every square attacked by side (no per-type split); what legality and castling need
+    uint64_t allAttacks(const Board& board, PieceColor side);
+}
+
+#endif // ATTACKS_H
@@ -3,53 +3,208 @@
 
 #include <cstdint>
 #include <iostream>
+#include <string>
+#include <type_traits>
 #include <vector>
+#include "key_history.h"
 #include "move_generation.h"
 #include "move.h"
 
-class Board {
+// Index of the least significant set bit, or -1 if none
+int firstSetBit(uint64_t x);
+
+// Castling rights bitmask
+enum CastlingRight {
+    WhiteKingSide = 1,
+    WhiteQueenSide = 2,
+    BlackKingSide = 4,
+    BlackQueenSide = 8
+};
+
+// What giving check takes for the side to move, worked out once per position (Board::checkInfo)
+struct CheckInfo {
+    uint64_t checkSquares[7];      // Squares a piece of each type (PieceType, [0] unused) attacks the enemy king from
+    uint64_t discoveredCheckers;   // Our pieces that are the only thing between one of our sliders and that king
+    int enemyKing;                 // Its square, or -1 if there is none
+};
+
+// The whole position lives in one trivially copyable, cache-line aligned object, so search can
+// copy it onto a stack of positions (copy-make) instead of undoing moves
+class alignas(64) Board {
 public:
     Board();
 
     void initializePosition();
+    bool loadFen(const std::string& fen);
+    // Sets up the board from bitboards indexed [PieceColor][PieceType - Pawn]; the
+    // en passant square is a bitboard as returned by getEnPassantSquare
+    void loadPosition(const uint64_t bitboards[2][6], bool isWhiteToMove, int castling, uint64_t enPassant,
+                      int halfmoves);
     void setPiece(int square, uint64_t& bitboard);
     void clearPiece(int square, uint64_t& bitboard);
     void makeMove(const Move& move);
     void undoMove(const Move& move);
     bool isSquareOccupied(int square, const uint64_t& bitboard) const;
     std::vector<Move> generateMoves(bool isWhite) const;
+    void generateMoves(bool isWhite, MoveList& moves) const;  // Same moves, without allocating
     static void displayBitboard(const uint64_t& bitboard);
 
-    uint64_t generateOpponentAttacks(bool isWhite) const;
-    uint64_t getOccupiedSquares() const;
-    uint64_t getWhitePawns() const { return white_pawns; }
-    uint64_t getBlackPawns() const { return black_pawns; }
-    uint64_t getWhiteKnights() const { return white_knights; }
-    uint64_t getBlackKnights() const { return black_knights; }
-    uint64_t getWhiteBishops() const { return white_bishops; }
-    uint64_t getBlackBishops() const { return black_bishops; }
-    uint64_t getWhiteRooks() const { return white_rooks; }
-    uint64_t getBlackRooks() const { return black_rooks; }
-    uint64_t getWhiteQueens() const { return white_queens; }
-    uint64_t getBlackQueens() const { return black_queens; }
-    uint64_t getWhiteKing() const { return white_king; }
-    uint64_t getBlackKing() const { return black_king; }
-
-    uint64_t getWhitePieces() const { return white_pieces; }
-    uint64_t getBlackPieces() const { return black_pieces; }
+    uint64_t generateOpponentAttacks(bool isWhite) const; // Squares attacked by the side opposing isWhite
+    uint64_t getOccupiedSquares() const { return occupied; }
+    uint64_t getWhitePawns() const { return pieces[White][Pawn - Pawn]; }
+    uint64_t getBlackPawns() const { return pieces[Black][Pawn - Pawn]; }
+    uint64_t getWhiteKnights() const { return pieces[White][Knight - Pawn]; }
+    uint64_t getBlackKnights() const { return pieces[Black][Knight - Pawn]; }
+    uint64_t getWhiteBishops() const { return pieces[White][Bishop - Pawn]; }
+    uint64_t getBlackBishops() const { return pieces[Black][Bishop - Pawn]; }
+    uint64_t getWhiteRooks() const { return pieces[White][Rook - Pawn]; }
+    uint64_t getBlackRooks() const { return pieces[Black][Rook - Pawn]; }
+    uint64_t getWhiteQueens() const { return pieces[White][Queen - Pawn]; }
+    uint64_t getBlackQueens() const { return pieces[Black][Queen - Pawn]; }
+    uint64_t getWhiteKing() const { return pieces[White][King - Pawn]; }
+    uint64_t getBlackKing() const { return pieces[Black][King - Pawn]; }
+
+    uint64_t getWhitePieces() const { return colors[White]; }
+    uint64_t getBlackPieces() const { return colors[Black]; }
+
+    // Indexed access by color and piece type (Pawn..King)
+    uint64_t getPieces(PieceColor color, int pieceType) const { return pieces[color][pieceType - Pawn]; }
+    uint64_t getColorPieces(PieceColor color) const { return colors[color]; }
+    template <PieceColor C>
+    uint64_t getPieces(int pieceType) const { return pieces[C][pieceType - Pawn]; }
+    template <PieceColor C>
+    uint64_t getColorPieces() const { return colors[C]; }
+    template <PieceColor Us>
+    uint64_t generateOpponentAttacks() const;
     uint64_t getEnPassantSquare() const { return enPassantSquare; }
-    bool canWhiteCastleKingSide() const { return whiteCanCastleKingSide; }
-    bool canWhiteCastleQueenSide() const { return whiteCanCastleQueenSide; }
-    bool canBlackCastleKingSide() const { return blackCanCastleKingSide; }
-    bool canBlackCastleQueenSide() const { return blackCanCastleQueenSide; }
+    int getCastlingRights() const { return castlingRights; }
+    bool canWhiteCastleKingSide() const { return castlingRights & WhiteKingSide; }
+    bool canWhiteCastleQueenSide() const { return castlingRights & WhiteQueenSide; }
+    bool canBlackCastleKingSide() const { return castlingRights & BlackKingSide; }
+    bool canBlackCastleQueenSide() const { return castlingRights & BlackQueenSide; }
+    bool isWhiteToMove() const { return whiteToMove; }
+
+    // Piece type (PieceType) of the given color on a square, or 0 if there is none
+    int getPieceAt(int square, bool isWhite) const;
+
+    // Passes the turn without moving; returns the state to hand back to undoNullMove
+    struct NullMoveState {
+        uint64_t enPassantSquare;
+        int halfmoveClock;
+        int pliesFromNull;
+    };
+    NullMoveState makeNullMove();
+    void undoNullMove(const NullMoveState& state);
+
+    // Plies since the last capture or pawn move (the 50-move rule counter)
+    int getHalfmoveClock() const { return halfmoveClock; }
+
+    // Key history pushed by makeMove and popped by undoMove. Detached (nullptr) by default;
+    // copies of a board share the history they were copied with.
+    void setKeyHistory(KeyHistory* newHistory) { history = newHistory; }
+    KeyHistory* getKeyHistory() const { return history; }
+
+    // Draw detection against the attached history. isRepetition looks for the current
+    // position among earlier ones since the last irreversible move or null move, two plies
+    // at a time. hasUpcomingRepetition reports that the side to move has a reversible move
+    // back into such a position (cuckoo tables); only cycles inside the last ply plies count.
+    bool isRepetition() const;
+    bool hasUpcomingRepetition(int ply) const;
+    bool isFiftyMoveDraw() const { return halfmoveClock >= 100; }
+    // Bare kings, or a single minor piece against a bare king
+    bool isInsufficientMaterial() const;
+
+    // Zobrist key, maintained incrementally by makeMove/undoMove
+    uint64_t getKey() const { return key; }
+    uint64_t computeKey() const;
+
+    // Attack maps, maintained incrementally by makeMove/undoMove: the squares each side
+    // attacks and how many of its pieces attack each square (x-rays not included)
+    uint64_t getAttacks(PieceColor side) const { return attacked[side]; }
+    int getAttackerCount(PieceColor side, int square) const { return attackerCounts[side][square]; }
+    bool isAttacked(int square, PieceColor by) const { return (attacked[by] >> square) & 1; }
+    bool isInCheck() const {
+        PieceColor us = whiteToMove ? White : Black;
+        return (attacked[us == White ? Black : White] & pieces[us][King - Pawn]) != 0;
+    }
+
+    // Checks one packed move (Move::pack), such as a hash move, without generating the rest:
+    // isPseudoLegal accepts exactly the moves generateMoves produces, isLegal those of them
+    // MoveGeneration::isMoveLegal accepts. Both work from the attack maps and line tables;
+    // only en passant captures are played out on a copy.
+    bool isPseudoLegal(uint16_t move) const;
+    bool isLegal(uint16_t move) const;
+    // The move generateMoves produces for a pseudo-legal packed move, flags and undo state included
+    Move decodeMove(uint16_t move) const;
+
+    // Whether a pseudo-legal move of the side to move checks the enemy king, without playing
+    // it: a lookup in the check squares of the piece it lands as, a discovered check test,
+    // and a short recomputation for the moves that clear two squares (en passant, castling)
+    // or promote
+    CheckInfo checkInfo() const;
+    bool givesCheck(const Move& move, const CheckInfo& info) const;
+    bool givesCheck(const Move& move) const { return givesCheck(move, checkInfo()); }
+
+    // Rebuilds the attack maps from the pieces; the position loaders call it
+    void computeAttacks();
 
 private:
-    uint64_t white_pawns, white_knights, white_bishops, white_rooks, white_queens, white_king;
-    uint64_t black_pawns, black_knights, black_bishops, black_rooks, black_queens, black_king;
-    uint64_t white_pieces, black_pieces, occupied;
+    void updateUnions();
+
+    template <PieceColor Us, typename MoveContainer>
+    void generateMoves(MoveContainer& moves) const;
+    template <PieceColor Us>
+    void makeMove(const Move& move);
+    template <PieceColor Us>
+    void undoMove(const Move& move);
+    template <PieceColor Us>
+    bool isPseudoLegal(uint16_t move) const;
+    template <PieceColor Us>
+    bool isLegal(uint16_t move) const;
+
+    template <PieceColor C>
+    void addPiece(int pieceType, int square);
+    template <PieceColor C>
+    void removePiece(int pieceType, int square);
+    template <PieceColor C>
+    void movePiece(int pieceType, int sourceSquare, int targetSquare);
+
+    // Incremental attack map update around a change to the pieces on the touched squares:
+    // beginAttackUpdate removes the attacks of the pieces standing there and notes the sliders
+    // whose rays reach them; endAttackUpdate, after the change, adds the attacks of whatever
+    // now stands there and corrects those sliders' rays for the new occupancy
+    struct AttackUpdate {
+        uint64_t touched;
+        uint64_t empty;        // Before the change
+        uint64_t diagonal[2];  // Sliders to correct, per color
+        uint64_t straight[2];
+    };
+    AttackUpdate beginAttackUpdate(uint64_t touched);
+    void endAttackUpdate(const AttackUpdate& update);
+    template <int Direction, PieceColor C>
+    void updateRay(uint64_t sliders, uint64_t oldEmpty);
+    template <PieceColor C>
+    void updateRays(uint64_t diagonal, uint64_t straight, uint64_t oldEmpty);
+    template <PieceColor C, int Delta>
+    void applyAttacks(uint64_t refresh);
+    template <PieceColor C, int Delta>
+    void countAttacks(uint64_t squares);
+
+    // Bitboards per color (PieceColor) and piece type (PieceType - Pawn), then the per-color unions
+    uint64_t pieces[2][6];
+    uint64_t colors[2];
+    uint64_t occupied;
+    uint64_t attacked[2];
+    uint8_t attackerCounts[2][64];
     uint64_t enPassantSquare;
-    bool whiteCanCastleKingSide, whiteCanCastleQueenSide;
-    bool blackCanCastleKingSide, blackCanCastleQueenSide;
+    uint64_t key;
+    int castlingRights;
+    int halfmoveClock;
+    int pliesFromNull;
+    KeyHistory* history;
+    bool whiteToMove;
 };
 
+static_assert(std::is_trivially_copyable<Board>::value, "copy-make relies on Board being copied bytewise");
+
 #endif // BOARD_H
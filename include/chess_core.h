@@ -0,0 +1,132 @@
+#ifndef CHESS_CORE_H
+#define CHESS_CORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// C interface for embedding the engine (the chess_core library). A handle owns its board,
+// game history, searcher and hash table; the engine's own tables (attacks, Zobrist keys,
+// cuckoo and evaluation tables) are immutable once built, so any number of handles can be
+// used on different threads at once without locks. A single handle is not synchronised:
+// only chess_engine_stop may be called on it while another thread is inside a call.
+// Nothing here throws; failures are reported as chess_status codes.
+
+#define CHESS_CORE_API_VERSION 1
+
+#if defined(__GNUC__)
+#define CHESS_CORE_API __attribute__((visibility("default")))
+#else
+#define CHESS_CORE_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct chess_engine chess_engine;
+
+typedef enum chess_status {
+    CHESS_OK = 0,
+    CHESS_INVALID_ARGUMENT = -1,
+    CHESS_INVALID_FEN = -2,
+    CHESS_ILLEGAL_MOVE = -3,
+    CHESS_BUFFER_TOO_SMALL = -4,
+    CHESS_OUT_OF_MEMORY = -5,
+    CHESS_INTERNAL_ERROR = -6
+} chess_status;
+
+// The engine's 16-bit move encoding: source | target << 6 | promotion << 12, with squares
+// numbered a1 = 0 .. h8 = 63 and promotions 2 knight, 3 bishop, 4 rook, 5 queen (0 if none).
+// 0 is never a legal move and stands for "no move".
+typedef uint16_t chess_move;
+
+// No position has more legal moves than this, so a buffer this long always suffices
+#define CHESS_MAX_MOVES 256
+
+// Long algebraic length of a move plus the terminator ("e7e8q")
+#define CHESS_MOVE_STRING_SIZE 6
+
+typedef struct chess_limits {
+    int depth;                // 0 = no depth limit
+    uint64_t nodes;           // 0 = unlimited
+    int64_t movetime_ms;      // 0 = unlimited
+    int64_t time_ms[2];       // Remaining clock time, white and black; 0 = no clock
+    int64_t increment_ms[2];
+    int moves_to_go;          // 0 = sudden death
+    int multipv;              // Lines reported per iteration, 1 or more
+} chess_limits;
+
+// Reported after every completed iteration, once per line with multipv > 1
+typedef struct chess_search_info {
+    int depth;
+    int seldepth;
+    int multipv;              // Line number, 1 = best
+    int score_cp;             // From the side to move's point of view; 0 for mate scores
+    int mate;                 // Moves to mate, negative when being mated, 0 if not a mate score
+    uint64_t nodes;
+    int64_t time_ms;
+    int hashfull;             // Per mille
+    const chess_move* pv;     // Only valid during the callback
+    int pv_length;
+} chess_search_info;
+
+// Called on the searching thread. A nonzero return stops the search, which then returns
+// the best move of the iterations already completed.
+typedef int (*chess_info_callback)(const chess_search_info* info, void* user_data);
+
+typedef struct chess_search_result {
+    chess_move best_move;     // 0 when the side to move has no legal move
+    int score_cp;
+    int mate;
+    int depth;                // Last completed iteration
+    uint64_t nodes;
+} chess_search_result;
+
+// CHESS_CORE_API_VERSION of the library actually loaded, to check against the header
+CHESS_CORE_API int chess_core_api_version(void);
+
+// A new engine at the starting position with a hash table of the given size (0 = 16 MB);
+// NULL if the memory cannot be allocated
+CHESS_CORE_API chess_engine* chess_engine_create(size_t hash_megabytes);
+CHESS_CORE_API void chess_engine_destroy(chess_engine* engine);
+
+// Forgets the hash table, killers and history, as before a new game
+CHESS_CORE_API void chess_engine_clear(chess_engine* engine);
+
+// Sets the position from a FEN (NULL = the starting position) followed by space-separated
+// long algebraic moves (NULL or "" for none), which are kept for repetition detection. On
+// any error the previous position is left in place.
+CHESS_CORE_API chess_status chess_engine_set_position(chess_engine* engine, const char* fen, const char* moves);
+
+// Plays one move on the current position; CHESS_ILLEGAL_MOVE if it is not legal there
+CHESS_CORE_API chess_status chess_engine_make_move(chess_engine* engine, chess_move move);
+
+// Nonzero when white is to move
+CHESS_CORE_API int chess_engine_white_to_move(const chess_engine* engine);
+
+// Writes the legal moves of the current position into moves and returns how many there
+// are, or CHESS_BUFFER_TOO_SMALL (nothing written) when capacity is less than that.
+// Allocates nothing.
+CHESS_CORE_API int chess_engine_legal_moves(const chess_engine* engine, chess_move* moves, size_t capacity);
+
+// Long algebraic notation of a move into buffer (at least CHESS_MOVE_STRING_SIZE bytes);
+// returns the length written, or CHESS_INVALID_ARGUMENT
+CHESS_CORE_API int chess_move_to_string(chess_move move, char* buffer, size_t size);
+
+// Fills limits with no limits at all and a single line
+CHESS_CORE_API void chess_limits_init(chess_limits* limits);
+
+// Searches the current position (limits NULL = chess_limits_init's) and blocks until it
+// is done; callback may be NULL. result may be NULL when only the callbacks are wanted.
+CHESS_CORE_API chess_status chess_engine_search(chess_engine* engine, const chess_limits* limits,
+                                                chess_info_callback callback, void* user_data,
+                                                chess_search_result* result);
+
+// Asks a running chess_engine_search on this handle to return; safe from any thread
+CHESS_CORE_API void chess_engine_stop(chess_engine* engine);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CHESS_CORE_H
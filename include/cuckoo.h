@@ -0,0 +1,21 @@
+#ifndef CUCKOO_H
+#define CUCKOO_H
+
+#include <cstdint>
+
+// Cuckoo tables of every reversible move, keyed by the Zobrist difference it makes to a
+// position (both piece-square keys and the side key). If the difference between the current
+// key and the key an odd number of plies back is in the table, a single move by the side
+// to move (once the path is clear) returns to that earlier position: an upcoming repetition.
+// The tables are built once, on first use, and are read-only afterwards.
+namespace Cuckoo {
+    constexpr int Size = 8192;
+
+    // True when moveKey belongs to a reversible move; its squares are returned through from/to
+    bool lookup(uint64_t moveKey, int& from, int& to);
+
+    // Number of moves stored (3668 for standard chess pieces)
+    int entryCount();
+}
+
+#endif // CUCKOO_H
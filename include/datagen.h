@@ -0,0 +1,127 @@
+#ifndef DATAGEN_H
+#define DATAGEN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "board.h"
+
+// Self-play training data: fixed-node games from randomized openings, with every recorded
+// position stored as (position, search score, game result) in a 32-byte record.
+namespace Datagen {
+    enum GameResult : uint8_t {
+        BlackWin = 0,
+        Draw = 1,
+        WhiteWin = 2
+    };
+
+    // Occupancy bitboard, then one 4-bit code per occupied square in square order (low nibble
+    // first): color << 3 | PieceType. At most 32 pieces fit, which every legal position meets.
+    // Score and result are from White's point of view. Written in host (little-endian) order.
+    struct PackedPosition {
+        uint64_t occupancy;
+        uint8_t pieces[16];
+        int16_t score;
+        uint8_t result;           // GameResult
+        uint8_t sideToMove;       // PieceColor
+        uint8_t castlingRights;
+        uint8_t enPassantSquare;  // Square index, 64 if none
+        uint8_t halfmoveClock;
+        uint8_t reserved;
+    };
+    static_assert(sizeof(PackedPosition) == 32, "records are 32 bytes on disk");
+
+    PackedPosition pack(const Board& board, int score, GameResult result);
+    void unpack(const PackedPosition& record, Board& board);
+
+    // Buffered record output to a file that several writers may share; each writer fills its
+    // own fixed buffer and appends it whole under a lock, so records are never split
+    class Writer {
+    public:
+        static constexpr size_t BufferRecords = 4096;
+
+        Writer(std::FILE* file, std::mutex* fileMutex);
+        ~Writer() { flush(); }
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+
+        void write(const PackedPosition& record) {
+            buffer[count++] = record;
+            if (count == BufferRecords) {
+                flush();
+            }
+        }
+        bool flush();
+
+    private:
+        std::FILE* file;
+        std::mutex* fileMutex;
+        std::unique_ptr<PackedPosition[]> buffer;
+        size_t count;
+    };
+
+    // Sequential reader, refilling a fixed buffer with large fread calls
+    class Reader {
+    public:
+        static constexpr size_t BufferRecords = 65536;
+
+        explicit Reader(const std::string& path);
+        ~Reader();
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+
+        bool isOpen() const { return file != nullptr; }
+
+        // Points record at the next position; false at end of file. The pointer stays valid
+        // until the following call.
+        bool next(const PackedPosition*& record) {
+            if (position == count && !refill()) {
+                return false;
+            }
+            record = &buffer[position++];
+            return true;
+        }
+
+    private:
+        bool refill();
+
+        std::FILE* file;
+        std::unique_ptr<PackedPosition[]> buffer;
+        size_t position;
+        size_t count;
+    };
+
+    struct Options {
+        int games = 100;
+        int threads = 1;
+        uint64_t nodes = 5000;       // Per move
+        int randomPlies = 8;         // Uniformly random legal moves before search takes over
+        int maxPlies = 400;          // Games still running are adjudicated drawn
+        size_t hashMegabytes = 8;    // Per thread
+        uint64_t seed = 1;
+        std::string output = "datagen.bin";
+    };
+
+    struct Summary {
+        uint64_t games;
+        uint64_t positions;
+        uint64_t results[3];  // Indexed by GameResult
+        double seconds;
+    };
+
+    // Plays the games on a pool of threads, each with its own table and searcher, and
+    // appends the records to options.output. Game i uses seed + i, so the set of records
+    // does not depend on the thread count, only their order does. Returns false if the
+    // output cannot be opened or written.
+    bool generate(const Options& options, Summary& summary);
+
+    // "datagen [--games N] [--threads N] [--nodes N] [--random-plies N] [--max-plies N] [--hash MB]
+    //  [--seed N] [--out FILE]" or "datagen --read FILE" to summarize an existing file
+    int runCommand(const std::vector<std::string>& args);
+}
+
+#endif // DATAGEN_H
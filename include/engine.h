@@ -1,6 +1,16 @@
 #ifndef ENGINE_H
 #define ENGINE_H
 
+#include <string>
+#include <vector>
+
 void startEngine();
 
-#endif //ENGINE_
\ No newline at end of file
+// Reads UCI commands from stdin until "quit" or end of input
+void uciLoop();
+
+// "bench [depth] [hashMB] [makeunmake|copymake]": fixed-depth search over the built-in positions;
+// prints the total node count (a signature that speed-only changes must not alter), time and nps
+int runBench(const std::vector<std::string>& args);
+
+#endif //ENGINE_H
@@ -0,0 +1,28 @@
+#ifndef EVALUATE_H
+#define EVALUATE_H
+
+#include <cstddef>
+#include "board.h"
+
+namespace Evaluation {
+    // Nominal piece values indexed by PieceType, used for move ordering
+    constexpr int PieceValues[7] = {0, 100, 320, 330, 500, 900, 20000};
+
+    // Game phase contribution per piece type; MaxPhase is a full middlegame
+    constexpr int PhaseWeight[7] = {0, 0, 1, 1, 2, 4, 0};
+    constexpr int MaxPhase = 24;
+
+    // Static evaluation in centipawns from the side to move's point of view.
+    // Material plus piece-square tables, tapered between middlegame and endgame by phase.
+    int evaluate(const Board& board);
+
+    // Scores count positions stored contiguously, with scores[i] == evaluate(positions[i]).
+    // Positions are taken in blocks of BatchLanes; within a block the piece-square lookups
+    // are gathered across positions and the tapering is done for all lanes at once (AVX2
+    // when built with ENGINE_AVX2). threads > 1 splits the batch into chunks that a pool of
+    // threads drains.
+    constexpr size_t BatchLanes = 8;
+    void evaluateBatch(const Board* positions, size_t count, int* scores, int threads = 1);
+}
+
+#endif // EVALUATE_H
@@ -0,0 +1,98 @@
+#ifndef EVALUATE_PARAMS_H
+#define EVALUATE_PARAMS_H
+
+// Evaluation weights read by evaluate.cpp. "ChessEngine tune" writes this file in the same
+// layout, so tuned values are compiled in by replacing it.
+namespace Evaluation {
+    namespace Params {
+        // Material indexed by PieceType
+        constexpr int MaterialMg[7] = {0, 82, 337, 365, 477, 1025, 0};
+        constexpr int MaterialEg[7] = {0, 94, 281, 297, 512, 936, 0};
+
+        // Piece-square tables from White's point of view, laid out as the board is drawn
+        // (a8 first, h1 last). White squares are mirrored with square ^ 56 to index them.
+        // Knights, bishops, rooks and queens use one table for both phases.
+        constexpr int PawnMgPst[64] = {
+              0,   0,   0,   0,   0,   0,   0,   0,
+             50,  50,  50,  50,  50,  50,  50,  50,
+             10,  10,  20,  30,  30,  20,  10,  10,
+              5,   5,  10,  25,  25,  10,   5,   5,
+              0,   0,   0,  20,  20,   0,   0,   0,
+              5,  -5, -10,   0,   0, -10,  -5,   5,
+              5,  10,  10, -20, -20,  10,  10,   5,
+              0,   0,   0,   0,   0,   0,   0,   0
+        };
+        constexpr int PawnEgPst[64] = {
+              0,   0,   0,   0,   0,   0,   0,   0,
+             80,  80,  80,  80,  80,  80,  80,  80,
+             50,  50,  50,  50,  50,  50,  50,  50,
+             30,  30,  30,  30,  30,  30,  30,  30,
+             20,  20,  20,  20,  20,  20,  20,  20,
+             10,  10,  10,  10,  10,  10,  10,  10,
+             10,  10,  10,  10,  10,  10,  10,  10,
+              0,   0,   0,   0,   0,   0,   0,   0
+        };
+        constexpr int KnightPst[64] = {
+            -50, -40, -30, -30, -30, -30, -40, -50,
+            -40, -20,   0,   0,   0,   0, -20, -40,
+            -30,   0,  10,  15,  15,  10,   0, -30,
+            -30,   5,  15,  20,  20,  15,   5, -30,
+            -30,   0,  15,  20,  20,  15,   0, -30,
+            -30,   5,  10,  15,  15,  10,   5, -30,
+            -40, -20,   0,   5,   5,   0, -20, -40,
+            -50, -40, -30, -30, -30, -30, -40, -50
+        };
+        constexpr int BishopPst[64] = {
+            -20, -10, -10, -10, -10, -10, -10, -20,
+            -10,   0,   0,   0,   0,   0,   0, -10,
+            -10,   0,   5,  10,  10,   5,   0, -10,
+            -10,   5,   5,  10,  10,   5,   5, -10,
+            -10,   0,  10,  10,  10,  10,   0, -10,
+            -10,  10,  10,  10,  10,  10,  10, -10,
+            -10,   5,   0,   0,   0,   0,   5, -10,
+            -20, -10, -10, -10, -10, -10, -10, -20
+        };
+        constexpr int RookPst[64] = {
+              0,   0,   0,   0,   0,   0,   0,   0,
+              5,  10,  10,  10,  10,  10,  10,   5,
+             -5,   0,   0,   0,   0,   0,   0,  -5,
+             -5,   0,   0,   0,   0,   0,   0,  -5,
+             -5,   0,   0,   0,   0,   0,   0,  -5,
+             -5,   0,   0,   0,   0,   0,   0,  -5,
+             -5,   0,   0,   0,   0,   0,   0,  -5,
+              0,   0,   0,   5,   5,   0,   0,   0
+        };
+        constexpr int QueenPst[64] = {
+            -20, -10, -10,  -5,  -5, -10, -10, -20,
+            -10,   0,   0,   0,   0,   0,   0, -10,
+            -10,   0,   5,   5,   5,   5,   0, -10,
+             -5,   0,   5,   5,   5,   5,   0,  -5,
+              0,   0,   5,   5,   5,   5,   0,  -5,
+            -10,   5,   5,   5,   5,   5,   0, -10,
+            -10,   0,   5,   0,   0,   0,   0, -10,
+            -20, -10, -10,  -5,  -5, -10, -10, -20
+        };
+        constexpr int KingMgPst[64] = {
+            -30, -40, -40, -50, -50, -40, -40, -30,
+            -30, -40, -40, -50, -50, -40, -40, -30,
+            -30, -40, -40, -50, -50, -40, -40, -30,
+            -30, -40, -40, -50, -50, -40, -40, -30,
+            -20, -30, -30, -40, -40, -30, -30, -20,
+            -10, -20, -20, -20, -20, -20, -20, -10,
+             20,  20,   0,   0,   0,   0,  20,  20,
+             20,  30,  10,   0,   0,  10,  30,  20
+        };
+        constexpr int KingEgPst[64] = {
+            -50, -40, -30, -20, -20, -30, -40, -50,
+            -30, -20, -10,   0,   0, -10, -20, -30,
+            -30, -10,  20,  30,  30,  20, -10, -30,
+            -30, -10,  30,  40,  40,  30, -10, -30,
+            -30, -10,  30,  40,  40,  30, -10, -30,
+            -30, -10,  20,  30,  30,  20, -10, -30,
+            -30, -30,   0,   0,   0,   0, -30, -30,
+            -50, -30, -30, -30, -30, -30, -30, -50
+        };
+    }
+}
+
+#endif // EVALUATE_PARAMS_H
@@ -0,0 +1,86 @@
+#ifndef GAME_HOST_H
+#define GAME_HOST_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "large_pages.h"
+#include "transposition_table.h"
+
+// Hosting many low-depth games at once on a few threads. Each game's search for its next
+// move is a resumable task: a step runs at most a slice of nodes, starting from the first
+// iteration the game has not completed, and everything that has to survive to the next step
+// lives in the game itself (position, history, the best move so far and its own small hash
+// table). Any worker can take the next step of any game. Workers always step the game whose
+// move deadline is nearest. A move is played when its target depth is reached, or at the
+// first step after the deadline with the best move so far.
+namespace GameHost {
+    struct Options {
+        int games = 2000;              // Games played in total
+        int concurrent = 1000;         // Games in progress at once, each holding a pooled table
+        int threads = 1;               // Workers time-slicing the games
+        int depth = 4;                 // Target depth of every move
+        int64_t moveTimeMs = 200;      // Deadline per move, from when it falls due
+        uint64_t sliceNodes = 2048;    // Nodes per step before the game goes back in the queue
+        size_t tableKilobytes = 64;    // Hash table of each running game
+        int randomPlies = 8;           // Random opening moves, so the games differ
+        int maxPlies = 200;            // Longer games are adjudicated drawn
+        uint64_t seed = 1;
+    };
+
+    struct Summary {
+        uint64_t games;
+        uint64_t moves;
+        uint64_t steps;
+        uint64_t nodes;
+        uint64_t whiteWins;
+        uint64_t draws;
+        uint64_t blackWins;
+        uint64_t cutShort;     // Moves played at their deadline, below the target depth
+        uint64_t late;         // Moves played after their deadline
+        uint64_t signature;    // Combines every game's final position; unless a move was cut
+                               // short, the same for any thread count or schedule
+        double seconds;
+        double gamesPerSecond;
+        double p50Ms;          // Move latency: from the move falling due to it being played
+        double p90Ms;
+        double p99Ms;
+        double maxMs;
+    };
+
+    // Equal hash tables carved out of one allocation, so thousands of games cost a single
+    // mapping and a table is recycled, not freed, when its game ends
+    class TablePool {
+    public:
+        TablePool(size_t tables, size_t kilobytesEach);
+        TablePool(const TablePool&) = delete;
+        TablePool& operator=(const TablePool&) = delete;
+
+        // A cleared table, or nullptr when every one is in use
+        TranspositionTable* acquire();
+        void release(TranspositionTable* table);
+
+        size_t capacity() const { return tables.size(); }
+        size_t available() const;
+
+    private:
+        LargePages::Buffer memory;
+        std::vector<std::unique_ptr<TranspositionTable>> tables;
+        std::vector<TranspositionTable*> idle;
+        mutable std::mutex mutex;
+    };
+
+    // Plays options.games games, options.concurrent at a time. Game i opens with random
+    // moves seeded by seed + i.
+    Summary play(const Options& options);
+
+    // "host [--games N] [--concurrent N] [--threads N] [--depth N] [--movetime MS] [--slice NODES]
+    //  [--table KB] [--random-plies N] [--max-plies N] [--seed N]": plays the games and prints
+    // games/s, move latency percentiles and deadline statistics
+    int runCommand(const std::vector<std::string>& args);
+}
+
+#endif // GAME_HOST_H
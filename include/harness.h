@@ -0,0 +1,48 @@
+#ifndef HARNESS_H
+#define HARNESS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "board.h"
+#include "key_history.h"
+#include "move_generation.h"
+
+// Helpers shared by the drivers that run many searches at once: data generation, the game
+// host and the analysis server
+namespace Harness {
+    // Nearest-rank percentile of an unsorted sample, which is partially reordered
+    inline double percentile(std::vector<double>& samples, double fraction) {
+        if (samples.empty()) {
+            return 0.0;
+        }
+        size_t rank = std::min(samples.size() - 1, static_cast<size_t>(fraction * samples.size()));
+        std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+        return samples[rank];
+    }
+
+    // Random legal moves from the start position, with board attached to history; an opening
+    // that runs into mate or stalemate is thrown away and drawn again from the same generator.
+    // next() returns the next 64 random bits.
+    template <typename Next>
+    void playRandomOpening(Board& board, KeyHistory& history, int plies, Next&& next) {
+        while (true) {
+            history.clear();
+            board.initializePosition();
+            board.setKeyHistory(&history);
+            int ply = 0;
+            for (; ply < plies; ++ply) {
+                std::vector<Move> moves = MoveGeneration::legalMoves(board);
+                if (moves.empty()) {
+                    break;
+                }
+                board.makeMove(moves[next() % moves.size()]);
+            }
+            if (ply == plies && !MoveGeneration::legalMoves(board).empty()) {
+                return;
+            }
+        }
+    }
+}
+
+#endif // HARNESS_H
@@ -0,0 +1,28 @@
+#ifndef KEY_HISTORY_H
+#define KEY_HISTORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Zobrist keys of the positions before each move of the current line (game moves followed
+// by search moves), oldest first. A Board pushes onto its attached history in makeMove and
+// pops in undoMove, so the stack always ends just before the current position.
+class KeyHistory {
+public:
+    KeyHistory() { keys.reserve(1024); }
+
+    void push(uint64_t key) { keys.push_back(key); }
+    void pop() { keys.pop_back(); }
+    void clear() { keys.clear(); }
+    void reserve(size_t capacity) { keys.reserve(capacity); }
+    size_t size() const { return keys.size(); }
+
+    // Key of the position the given number of plies before the current one (1 = previous)
+    uint64_t pliesAgo(int plies) const { return keys[keys.size() - plies]; }
+
+private:
+    std::vector<uint64_t> keys;
+};
+
+#endif // KEY_HISTORY_H
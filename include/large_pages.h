@@ -0,0 +1,46 @@
+#ifndef LARGE_PAGES_H
+#define LARGE_PAGES_H
+
+#include <cstddef>
+
+// Page-size aware allocation for the large tables that are probed at random (the search
+// and perft hash tables). Backing them with 2MB pages lets one TLB entry cover 512 times
+// as much of the table, so most probes no longer pay for a page walk as well as a cache miss.
+namespace LargePages {
+    // Best first. A request for one mode falls back to the ones after it.
+    enum class Mode {
+        Explicit,     // Reserved hugetlbfs pages via MAP_HUGETLB (vm.nr_hugepages must be set)
+        Transparent,  // 2MB-aligned mapping advised with MADV_HUGEPAGE for the kernel to back with THP
+        Normal        // Base pages; THP is advised off so this stays a true baseline
+    };
+
+    const char* modeName(Mode mode);
+
+    // Owns one zero-filled block; the memory is released on destruction
+    class Buffer {
+    public:
+        Buffer() = default;
+        Buffer(size_t bytes, Mode request = Mode::Explicit);
+        ~Buffer();
+        Buffer(Buffer&& other) noexcept;
+        Buffer& operator=(Buffer&& other) noexcept;
+        Buffer(const Buffer&) = delete;
+        Buffer& operator=(const Buffer&) = delete;
+
+        void* data() const { return memory; }
+        size_t size() const { return bytes; }
+
+        // The mode actually obtained, which may be below the one requested
+        Mode mode() const { return obtained; }
+
+    private:
+        void release();
+
+        void* memory = nullptr;
+        size_t bytes = 0;
+        size_t mappedBytes = 0;
+        Mode obtained = Mode::Normal;
+    };
+}
+
+#endif // LARGE_PAGES_H
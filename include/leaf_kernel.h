@@ -0,0 +1,39 @@
+#ifndef LEAF_KERNEL_H
+#define LEAF_KERNEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include "board.h"
+
+// Multi-board leaf kernel: counts the legal moves of several independent positions at once,
+// one position per vector lane (4 with AVX2, 8 with AVX-512). Each position is packed
+// side-to-move first and flipped so the side to move is always White, so every lane runs the
+// same shifts. The count is built from per-direction shifts and Kogge-Stone fills:
+// pawn pushes and captures, knight and king steps, slider rays, with checks, pins, castling
+// and en passant resolved set-wise, without generating or making a single move.
+//
+// Meant for the last ply of perft-style counting, where nearly all the time goes into
+// sibling positions that are only counted. The scalar path runs the same code one lane wide.
+namespace LeafKernel {
+    enum class Path {
+        Scalar,  // One position at a time
+        Avx2,    // Four positions per instruction (ENGINE_AVX2)
+        Avx512   // Eight positions per instruction (ENGINE_AVX512)
+    };
+
+    const char* pathName(Path path);
+
+    // Whether this build contains the path
+    bool available(Path path);
+
+    // The widest path in this build
+    Path widest();
+
+    // counts[i] = number of legal moves for the side to move in positions[i]
+    void countLegalMoves(const Board* positions, size_t count, uint32_t* counts, Path path = widest());
+
+    // Perft with the last ply counted by the kernel, over all children of each depth-2 node at once
+    uint64_t perft(const Board& board, int depth, Path path = widest());
+}
+
+#endif // LEAF_KERNEL_H
@@ -0,0 +1,109 @@
+#ifndef MATE_SEARCH_H
+#define MATE_SEARCH_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "board.h"
+#include "move.h"
+#include "search.h"
+
+// Depth-first proof-number search (df-pn) for forced mates. The side to move at the root is
+// the attacker: its nodes are proven by one mating move (OR), the defender's only when every
+// reply is (AND). Proof and disproof numbers, the minimum number of leaves still to prove or
+// refute a node, steer the search into the cheapest part of the tree, so a narrow forcing line
+// is followed to any depth instead of being searched full width.
+namespace MateSearch {
+    struct Limits {
+        int mateIn = 0;               // Moves; 0 = any mate the ply limit allows
+        uint64_t nodes = 0;           // 0 = unlimited
+        int64_t moveTime = 0;         // Milliseconds, 0 = unlimited
+        bool checksOnly = false;      // Attacker nodes only try checking moves
+    };
+
+    struct Result {
+        bool proven;                  // The attacker mates
+        bool disproven;               // No mate within the limits (neither: ran out of budget)
+        int mateIn;                   // Moves to mate along pv
+        std::vector<Move> pv;         // Attacker moves and the longest defences the proof holds
+        uint64_t nodes;
+        int64_t timeMs;
+    };
+
+    class Solver {
+    public:
+        static constexpr uint32_t Infinity = 1u << 30;
+
+        explicit Solver(size_t megabytes = 16);
+
+        // The mate found is the one the proof tree holds: within mateIn when that is set,
+        // but not necessarily the shortest. Draws by repetition along the current line count
+        // as refutations; their parents are stored regardless (the usual df-pn shortcut).
+        Result solve(const Board& board, const Limits& limits);
+
+        // Safe to call from another thread while solve() runs
+        void stop() { stopRequested.store(true, std::memory_order_relaxed); }
+
+        void clear();
+
+    private:
+        // A proof holds at any depth with room for its distance; a disproof only at depths no
+        // greater than the one it was found at, since it may just have hit the ply limit.
+        struct Entry {
+            uint64_t key;
+            uint32_t proof;
+            uint32_t disproof;
+            uint32_t work;        // Nodes searched below the entry, for replacement
+            uint16_t distance;    // Plies to mate when proven
+            uint16_t remaining;   // Plies the limit left when stored
+        };
+        static constexpr int BucketSize = 4;
+
+        // Children of a node on the current line
+        struct Frame {
+            MoveList moves;
+            uint64_t keys[MoveList::Capacity];
+            uint32_t proof[MoveList::Capacity];
+            uint32_t disproof[MoveList::Capacity];
+            uint16_t distance[MoveList::Capacity];
+            uint32_t estimate[MoveList::Capacity];  // Proof number of a child not yet searched
+            uint64_t key;
+        };
+
+        void mid(Board& board, int ply, uint32_t proofThreshold, uint32_t disproofThreshold);
+        int expand(Board& board, int ply);
+        bool lookup(uint64_t key, int remaining, uint32_t& proof, uint32_t& disproof, uint16_t& distance) const;
+        void store(uint64_t key, int remaining, uint32_t proof, uint32_t disproof, uint16_t distance, uint64_t work);
+        bool shouldStop();
+
+        std::vector<Entry> entries;
+        uint64_t mask;
+        std::unique_ptr<Frame[]> frames;  // Indexed by ply
+        std::atomic<bool> stopRequested;
+        bool stopped;
+        Limits limits;
+        int maxPly;
+        std::chrono::steady_clock::time_point startTime;
+        uint64_t nodes;
+    };
+
+    // Built-in problems for "mate" without --fen: a position with the attacker to move and a
+    // mate in mateIn moves or fewer (the shortest, except for the queen ending's 7)
+    struct Problem {
+        const char* name;
+        const char* fen;
+        int mateIn;
+    };
+    const std::vector<Problem>& suite();
+
+    // "mate [--fen FEN] [--mate N] [--checks-only] [--nodes N] [--movetime MS] [--hash MB]
+    //  [--compare]": solves one position, or the built-in suite without --fen; --compare also
+    // times the main search on each until it reports the same mate
+    int runCommand(const std::vector<std::string>& args);
+}
+
+#endif // MATE_SEARCH_H
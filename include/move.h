@@ -14,9 +14,20 @@ struct Move {
     bool isPromotion;         // True if this is a promotion move
     bool isDoublePawnPush;    // True if this is a double pawn push
     int previousEnPassantSquare; // To store the en passant square before the move
+    int capturedPiece = 0;       // Piece type captured (0 if none), filled in by Board::generateMoves
+    int previousCastlingRights = 0; // Castling rights before the move, filled in by Board::generateMoves
+    int previousHalfmoveClock = 0;  // Halfmove clock before the move, filled in by Board::generateMoves
 
     std::string toString() const;
 
+    // 16-bit encoding (source | target << 6 | promotion piece << 12) used by the hash tables
+    uint16_t pack() const {
+        return static_cast<uint16_t>(sourceSquare | (targetSquare << 6) | ((isPromotion ? promotionPiece : 0) << 12));
+    }
+
+    // Leaves the fields unset; for preallocated move lists that are filled before use
+    Move() = default;
+
     // Constructor
     Move(int source, int target, int promotion = 0, bool capture = false, bool enPassant = false,
          bool castling = false, bool promotionMove = false, bool doublePawnPush = false, int prevEnPassant = -1)
@@ -25,6 +36,38 @@ struct Move {
           isDoublePawnPush(doublePawnPush), previousEnPassantSquare(prevEnPassant) {}
 };
 
+// Packed move (Move::pack) named by the text: UCI coordinates ("e2e4", "e7e8q") or long
+// algebraic notation ("Ng1-f3", "e4xd5", "e7e8=Q+"). Castling is written as the king's move.
+// Returns 0 for anything else; whether the move is possible is up to Board::isLegal.
+uint16_t parseMove(const std::string& text);
+
+// Fixed-capacity move list, so move generation can fill preallocated storage instead of a
+// std::vector; 256 is above the largest number of pseudo-legal moves in any position
+class MoveList {
+public:
+    static constexpr int Capacity = 256;
+
+    MoveList() : count(0) {}
+
+    void push_back(const Move& move) { moves[count++] = move; }
+    void emplace_back(const Move& move) { moves[count++] = move; }
+    void clear() { count = 0; }
+    void resize(int size) { count = size; }
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    Move& operator[](int index) { return moves[index]; }
+    const Move& operator[](int index) const { return moves[index]; }
+    Move* begin() { return moves; }
+    Move* end() { return moves + count; }
+    const Move* begin() const { return moves; }
+    const Move* end() const { return moves + count; }
+
+private:
+    Move moves[Capacity];
+    int count;
+};
+
 enum PieceType {
     Pawn = 1,
     Knight = 2,
@@ -1,17 +1,63 @@
 #ifndef MOVE_GENERATION_H
 #define MOVE_GENERATION_H
 
+#include <array>
 #include <cstdint>
 #include <vector>
 class Board;
 #include "move.h"
 
 namespace MoveGeneration {
-    extern uint64_t knightAttacks[64];
+    constexpr uint64_t NotFileA = 0xFEFEFEFEFEFEFEFEULL;
+    constexpr uint64_t NotFileH = 0x7F7F7F7F7F7F7F7FULL;
 
-    void precomputeKnightAttacks();
+    // Shifts a bitboard by a square offset fixed at compile time (positive is towards h8)
+    template <int Direction>
+    constexpr uint64_t shift(uint64_t bitboard) {
+        return Direction > 0 ? bitboard << Direction : bitboard >> -Direction;
+    }
+
+    // Per-side constants, so the templated generators resolve directions and ranks at compile time
+    template <PieceColor Us>
+    struct ColorTraits {
+        static constexpr PieceColor Them = Us == White ? Black : White;
+        static constexpr bool IsWhite = Us == White;
+        static constexpr int Up = Us == White ? 8 : -8;
+        static constexpr int UpLeft = Us == White ? 7 : -9;   // Towards the a-file
+        static constexpr int UpRight = Us == White ? 9 : -7;  // Towards the h-file
+        static constexpr uint64_t SinglePushRank = Us == White ? 0x0000000000FF0000ULL : 0x0000FF0000000000ULL;  // Where a double push passes through
+        static constexpr uint64_t PromotionRank = Us == White ? 0xFF00000000000000ULL : 0x00000000000000FFULL;
+        static constexpr int KingStart = Us == White ? 4 : 60;
+    };
+
+    // Squares attacked by a set of pawns of one side
+    template <PieceColor Us>
+    constexpr uint64_t pawnAttacks(uint64_t pawns) {
+        return shift<ColorTraits<Us>::UpLeft>(pawns & NotFileA) | shift<ColorTraits<Us>::UpRight>(pawns & NotFileH);
+    }
+
+    constexpr std::array<uint64_t, 64> generateKnightAttacks() {
+        constexpr int offsets[8][2] = {{2, 1}, {1, 2}, {-1, 2}, {-2, 1}, {-2, -1}, {-1, -2}, {1, -2}, {2, -1}};
+        std::array<uint64_t, 64> table{};
+        for (int square = 0; square < 64; ++square) {
+            for (const auto& offset : offsets) {
+                int rank = square / 8 + offset[0];
+                int file = square % 8 + offset[1];
+                if (rank >= 0 && rank < 8 && file >= 0 && file < 8) {
+                    table[square] |= 1ULL << (rank * 8 + file);
+                }
+            }
+        }
+        return table;
+    }
+
+    // Knight attacks from each square. Generated at compile time like the Zobrist keys, so
+    // there is no initialisation call and concurrent readers need no synchronisation.
+    inline constexpr std::array<uint64_t, 64> knightAttacks = generateKnightAttacks();
 
     // Pawn moves
+    template <PieceColor Us>
+    void generatePawnMoves(const uint64_t& pawns, const uint64_t& emptySquares, const uint64_t& opponentPieces, uint64_t enPassantSquare, uint64_t& moves, uint64_t& captures);
     void generatePawnMoves(const uint64_t& pawns, const uint64_t& emptySquares, const uint64_t& opponentPieces, uint64_t enPassantSquare, uint64_t& moves, uint64_t& captures, bool isWhite);
     void generatePawnCapturesWithEnPassant(const uint64_t& pawns, const uint64_t& opponentPawns, const uint64_t& enPassantSquare, uint64_t& captures);
 
@@ -29,19 +75,35 @@ namespace MoveGeneration {
     // Queen moves
     void generateQueenMoves(const uint64_t& queens, const uint64_t& ownPieces, const uint64_t& opponentPieces, const uint64_t& occupied, uint64_t& moves, uint64_t& captures);
 
+    uint64_t generateQueenMovesFromSquare(int square, uint64_t blockers);
+
     // King moves
     void generateKingMoves(const uint64_t& king, const uint64_t& ownPieces, const uint64_t& opponentPieces, const uint64_t& occupied, uint64_t& moves, uint64_t& captures);
     uint64_t generateKingMovesFromSquare(int square, uint64_t blockers);  // Updated
 
     // Castling moves
+    template <PieceColor Us, typename MoveContainer>
+    void generateCastlingMoves(const Board& board, MoveContainer& moves);  // std::vector<Move> or MoveList
     void generateCastlingMoves(const Board& board, std::vector<Move>& moves, bool isWhite);
 
-    // Legal moves
+    // Legal moves. The templated forms are fixed to one side; the bool forms dispatch to them.
+    template <PieceColor By>
+    bool isSquareAttacked(int square, const Board& board);
+    template <PieceColor Us>
+    bool isKingSafe(const Board& board);
+    template <PieceColor Us>
+    bool isMoveLegal(const Board& board, const Move& move);
+    template <PieceColor Us>
+    std::vector<Move> filterLegalMoves(const Board& board, const std::vector<Move>& moves);
+
     bool isSquareAttacked(int square, const Board& board, bool byWhite);
     bool isKingSafe(const Board& board, bool isWhite);
     bool isMoveLegal(const Board& board, const Move& move, bool isWhite);
     std::vector<Move> filterLegalMoves(const Board& board, const std::vector<Move>& moves, bool isWhite);
 
+    // Every legal move of the side to move
+    std::vector<Move> legalMoves(const Board& board);
+
     // Generate all moves for a given board state
     void generateAllMoves(const Board& board);
 
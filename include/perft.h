@@ -0,0 +1,55 @@
+#ifndef PERFT_H
+#define PERFT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "board.h"
+#include "large_pages.h"
+
+namespace Perft {
+    // Shared (key, depth) -> node count table. Entries are written without locks: each
+    // slot stores the key xored with its data word, so a torn write from a racing
+    // thread fails the key check on probe and is treated as a miss.
+    class HashTable {
+    public:
+        explicit HashTable(size_t megabytes, LargePages::Mode request = LargePages::Mode::Explicit);
+
+        bool probe(uint64_t key, int depth, uint64_t& nodes) const;
+        void store(uint64_t key, int depth, uint64_t nodes);
+        void clear();
+
+        LargePages::Mode pageMode() const { return memory.mode(); }
+
+    private:
+        struct Entry {
+            std::atomic<uint64_t> check;
+            std::atomic<uint64_t> data;
+        };
+
+        LargePages::Buffer memory;
+        Entry* entries;
+        uint64_t mask;
+    };
+
+    // Single-threaded perft; the table is optional
+    uint64_t perft(Board& board, int depth, HashTable* table = nullptr);
+
+    // Same count using copy-make: each child is a copy of its parent with the move made, nothing is undone
+    uint64_t perftCopyMake(const Board& board, int depth, HashTable* table = nullptr);
+
+    // Splits the tree splitDepth plies below the root into work items that a pool of
+    // threads drains; per-root-move counts are returned through divide when given
+    uint64_t parallelPerft(const Board& board, int depth, int threads, int splitDepth, HashTable* table,
+                           std::vector<std::pair<std::string, uint64_t>>* divide = nullptr, bool copyMake = false);
+
+    // "perft <depth> [--threads N] [--split D] [--hash MB] [--fen FEN] [--divide] [--scaling] [--copy-make]
+    //  [--leaf-kernel]"
+    int runCommand(const std::vector<std::string>& args);
+}
+
+#endif // PERFT_H
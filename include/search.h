@@ -0,0 +1,134 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "board.h"
+#include "key_history.h"
+#include "move.h"
+#include "search_profile.h"
+#include "transposition_table.h"
+
+namespace Search {
+    constexpr int MaxPly = 128;
+    constexpr int Infinity = 32001;
+    constexpr int MateScore = 32000;
+    constexpr int MateBound = MateScore - MaxPly;  // Scores beyond this are mates
+    static_assert(ProfilePlies == MaxPly, "a profile has a slot for every ply and depth");
+
+    struct Limits {
+        int depth = MaxPly - 1;
+        uint64_t nodes = 0;           // 0 = unlimited
+        int64_t moveTime = 0;         // Milliseconds, 0 = unlimited
+        int64_t time[2] = {0, 0};     // Remaining clock time per color (PieceColor index)
+        int64_t increment[2] = {0, 0};
+        int movesToGo = 0;
+        bool infinite = false;
+        int multiPV = 1;              // Root lines searched and reported per iteration
+        int mate = 0;                 // "go mate N": the UCI loop hands these to the mate solver
+        int startDepth = 1;           // First iteration; a search resumed from its table can skip the ones already done
+    };
+
+    // Reported after every completed iteration, once per line in MultiPV mode
+    struct Info {
+        int depth;
+        int multiPV;  // Line number, 1 = best
+        int selDepth;
+        int score;
+        uint64_t nodes;
+        int64_t timeMs;
+        int hashfull;
+        std::vector<Move> pv;
+    };
+
+    struct Result {
+        bool hasMove;
+        Move bestMove;
+        int score;
+        int depth;
+        uint64_t nodes;
+    };
+
+    // Iterative-deepening principal variation search with a quiescence search,
+    // transposition table cutoffs, null-move pruning and late-move reductions.
+    // With Limits::multiPV = K each iteration searches the root K times, every search
+    // excluding the best moves of the earlier lines; the table and ordering state carry
+    // over, so the later lines mostly replay entries the first one left behind.
+    class Searcher {
+    public:
+        explicit Searcher(TranspositionTable& table);
+
+        Result search(const Board& board, const Limits& limits,
+                      const std::function<void(const Info&)>& onIteration = nullptr);
+
+        // Safe to call from another thread while search() runs
+        void stop() { stopRequested.store(true, std::memory_order_relaxed); }
+
+        // Forgets killers and history, e.g. on ucinewgame
+        void clear();
+
+        // Searches into another table from now on, e.g. when one searcher serves many games
+        void setTable(TranspositionTable& table) { tt = &table; }
+
+        // Copy-make: each ply plays its moves on a copy of the parent in a position stack, so
+        // nothing is undone. Off by default (make/unmake on a single board).
+        void setCopyMake(bool enabled) { copyMake = enabled; }
+
+        // Cut to a draw score when the side to move can force a repetition (on by default)
+        void setUpcomingRepetition(bool enabled) { upcomingRepetition = enabled; }
+
+        // Records the tree shape of every search into profile from now on; nullptr (the
+        // default) turns profiling off
+        void setProfile(Profile* newProfile) { profile = newProfile; }
+
+    private:
+        int alphaBeta(Board& board, int depth, int ply, int alpha, int beta, bool allowNull);
+        int quiesce(Board& board, int ply, int alpha, int beta);
+        void scoreMoves(const Board& board, const MoveList& moves, uint16_t ttMove, int ply, int* scores) const;
+        bool shouldStop();
+        Board& playMove(Board& board, const Move& move, int ply);
+        void takeBack(Board& board, const Move& move);
+
+        TranspositionTable* tt;
+        std::atomic<bool> stopRequested;
+        bool stopped;
+        Limits limits;
+        std::chrono::steady_clock::time_point startTime;
+        int64_t timeBudget;
+        uint64_t nodes;
+        int selDepth;
+
+        // Per-ply search stack: everything a node keeps while its children are searched
+        struct Frame {
+            MoveList moves;
+            int scores[MoveList::Capacity];
+            uint16_t killers[2];
+            int staticEval;                 // -Infinity when the node did not evaluate
+            Board::NullMoveState nullMove;  // Undo state of the null move tried here
+            Move pv[MaxPly + 1];            // Principal variation from this ply
+            int pvLength;
+        };
+
+        int history[2][64][64];
+        std::unique_ptr<Frame[]> frames;  // Indexed by ply, allocated with the searcher
+        Info info;                        // Reused for every report, pv capacity reserved
+
+        bool copyMake;
+        bool upcomingRepetition;
+        Board positions[MaxPly + 1];  // Copy-make stack, indexed by ply
+        KeyHistory keyHistory;        // Game history of the root position, then the current line
+        std::vector<uint16_t> excludedRootMoves;  // Best moves of the earlier MultiPV lines this iteration
+        std::vector<uint16_t> previousLines;      // The same moves from the previous iteration
+        uint16_t rootMoveHint;                    // Ordered first at the root in place of the table move
+        Profile* profile;
+    };
+
+    // Formats a score for UCI: "cp 25" or "mate -3"
+    std::string scoreToUci(int score);
+}
+
+#endif // SEARCH_H
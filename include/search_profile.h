@@ -0,0 +1,62 @@
+#ifndef SEARCH_PROFILE_H
+#define SEARCH_PROFILE_H
+
+#include <cstdint>
+#include <ostream>
+
+// Shape of the search tree, for tuning search speed: where the nodes go by ply and by
+// iteration, how early cutoffs come, and how often the table, reductions and extensions fire.
+// A profile is attached to a Searcher with setProfile and accumulates over every search it
+// runs until cleared, so one profile can cover a whole bench run. When none is attached the
+// search pays one predictable branch per hook.
+namespace Search {
+    constexpr int ProfilePlies = 128;        // Same as MaxPly
+    constexpr int ProfileCutoffSlots = 16;   // Cutoffs at move 1..15 each, then all later ones
+
+    // Counters of the nodes searched at one ply
+    struct PlyProfile {
+        uint64_t nodes;          // Main search nodes
+        uint64_t qnodes;         // Quiescence nodes
+        uint64_t ttProbes;
+        uint64_t ttHits;
+        uint64_t ttCuts;         // Hits that ended the node
+        uint64_t cutoffs;        // Beta cutoffs in the main search
+        uint64_t firstMoveCutoffs;
+        uint64_t nullMoves;      // Null-move searches tried
+        uint64_t nullMoveCuts;
+        uint64_t reductions;     // Late moves searched at reduced depth
+        uint64_t researches;     // Reduced searches that had to be repeated at full depth
+        uint64_t extensions;     // Check extensions
+    };
+
+    // One iteration of iterative deepening, summed over the searches that reached it
+    struct DepthProfile {
+        uint64_t searches;
+        uint64_t nodes;          // Nodes of this iteration alone, not the running total
+        uint64_t qnodes;
+        uint64_t microseconds;
+    };
+
+    struct Profile {
+        uint64_t searches;
+        PlyProfile plies[ProfilePlies];
+        DepthProfile depths[ProfilePlies];
+        uint64_t cutoffIndex[ProfileCutoffSlots];  // Main search cutoffs by the legal move that caused them
+
+        Profile() { clear(); }
+        void clear();
+
+        // Sums over all plies
+        PlyProfile total() const;
+
+        // Ratio of the nodes at the next ply (or iteration) to this one; 0 where undefined
+        double plyBranchingFactor(int ply) const;
+        double depthBranchingFactor(int depth) const;
+
+        // One JSON object: totals, rates, then "depths" and "plies" arrays trimmed to the
+        // ones reached, and the cutoff index histogram
+        void writeJson(std::ostream& out) const;
+    };
+}
+
+#endif // SEARCH_PROFILE_H
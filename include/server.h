@@ -0,0 +1,84 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Local analysis service. Clients connect over a Unix domain socket or localhost TCP and send
+// one JSON object per line:
+//   {"id": "a1", "fen": "<fen>", "depth": 12, "nodes": 0, "movetime": 500, "multipv": 1}
+//   {"cancel": "a1"}
+//   {"stats": true}
+// Every request is answered on the same connection, one JSON object per line, tagged with its
+// id: "info" lines as iterations complete, then exactly one of "bestmove", "rejected" (the
+// queue is full), "cancelled" (cancelled before it started) or "error". A search cancelled
+// while running still ends with its "bestmove", marked "cancelled": true.
+//
+// Requests wait in one queue served by a fixed pool of search workers that share a single
+// transposition table.
+namespace Server {
+    struct Options {
+        std::string socketPath = "chess_engine.sock";  // Used when port is 0
+        int port = 0;                                  // Localhost TCP port
+        int threads = 1;                               // Search workers
+        size_t hashMegabytes = 64;                     // Shared by all workers
+        std::string hashFile;                          // Backs the table with this file when set
+        int maxQueued = 64;                            // Waiting requests beyond this are rejected
+        int64_t maxTimeMs = 10000;                     // Cap (and default) for a request's search time
+    };
+
+    struct Metrics {
+        uint64_t accepted;
+        uint64_t rejected;
+        uint64_t cancelled;
+        uint64_t completed;
+        uint64_t nodes;
+        int queued;
+        int running;
+        double p50Ms;        // Latency from request receipt to its final response, over the
+        double p99Ms;        // last 4096 completed requests
+        double uptimeSeconds;
+        double throughput;   // Completed requests per second of uptime
+    };
+
+    class AnalysisServer {
+    public:
+        explicit AnalysisServer(const Options& options);
+        ~AnalysisServer();
+        AnalysisServer(const AnalysisServer&) = delete;
+        AnalysisServer& operator=(const AnalysisServer&) = delete;
+
+        // Binds the socket and starts the acceptor and the workers; false with a reason on failure
+        bool start(std::string& error);
+
+        // Stops running searches, closes every connection and joins all threads
+        void stop();
+
+        Metrics metrics() const;
+
+    private:
+        struct State;
+        std::unique_ptr<State> state;
+    };
+
+    std::string metricsToJson(const Metrics& metrics);
+
+    // Parses one flat JSON object (string, number, boolean and null values) into raw value
+    // strings, with string values unescaped; false if the text is not such an object
+    bool parseJsonObject(const std::string& text, std::map<std::string, std::string>& fields);
+
+    // "server [--socket PATH | --port N] [--threads N] [--hash MB] [--hash-file PATH] [--queue N]
+    //  [--max-time MS]"
+    int runCommand(const std::vector<std::string>& args);
+
+    // "loadtest [--socket PATH | --port N] [--requests N] [--concurrency N] [--depth N | --nodes N]
+    //  [--fen FEN]": concurrent clients, each sending requests one after another; prints
+    // client-side latency percentiles and throughput, then the server's own metrics
+    int runLoadTest(const std::vector<std::string>& args);
+}
+
+#endif // SERVER_H
@@ -0,0 +1,82 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+// Hot-path counters. They are only compiled in when ENGINE_STATS is defined (Debug builds,
+// or -DENGINE_STATS=ON); otherwise STATS_INC expands to nothing and the reporting
+// functions return an empty snapshot.
+#ifndef ENGINE_STATS
+#define ENGINE_STATS 0
+#endif
+
+namespace Stats {
+    enum Counter {
+        Nodes,
+        QNodes,
+        MoveGenCalls,
+        LegalityChecks,
+        TTProbes,
+        TTHits,
+        Cutoffs,
+        FirstMoveCutoffs,
+        NullMoveSuccesses,
+        CounterCount
+    };
+
+    constexpr bool enabled = ENGINE_STATS != 0;
+
+    const char* counterName(Counter counter);
+
+    // One block per thread, on its own cache line, so increments never contend.
+    // Blocks register themselves on construction and fold their totals into a
+    // global "retired" block when their thread exits.
+    struct alignas(64) ThreadCounters {
+        std::atomic<uint64_t> values[CounterCount];
+
+        ThreadCounters();
+        ~ThreadCounters();
+        ThreadCounters(const ThreadCounters&) = delete;
+        ThreadCounters& operator=(const ThreadCounters&) = delete;
+    };
+
+    inline ThreadCounters& local() {
+        thread_local ThreadCounters counters;
+        return counters;
+    }
+
+    // Only the owning thread writes its block, so a relaxed load/store pair is enough
+    inline void increment(Counter counter, uint64_t amount = 1) {
+        std::atomic<uint64_t>& value = local().values[counter];
+        value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    struct Snapshot {
+        uint64_t values[CounterCount] = {};
+
+        uint64_t operator[](Counter counter) const { return values[counter]; }
+    };
+
+    // Sums every live thread's block plus the retired totals
+    Snapshot collect();
+
+    // Zeroes all counters; call while no search is running
+    void reset();
+
+    // Single UCI line: "info string stats nodes 123 qnodes 45 ..."
+    std::string infoString(const Snapshot& snapshot);
+    void writeJson(std::ostream& out, const Snapshot& snapshot);
+}
+
+#if ENGINE_STATS
+#define STATS_INC(counter) ::Stats::increment(::Stats::counter)
+#define STATS_ADD(counter, amount) ::Stats::increment(::Stats::counter, (amount))
+#else
+#define STATS_INC(counter) ((void)0)
+#define STATS_ADD(counter, amount) ((void)0)
+#endif
+
+#endif // STATS_H
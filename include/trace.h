@@ -0,0 +1,24 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Compile-time debug tracing. Statements wrapped in ENGINE_TRACE are discarded by the
+// compiler unless ENGINE_TRACE_LEVEL is at least the requested level, so hot paths pay
+// nothing for them in normal builds.
+//   0 - off (default)
+//   1 - per-call summaries
+//   2 - full bitboard dumps from the move generators
+#ifndef ENGINE_TRACE_LEVEL
+#define ENGINE_TRACE_LEVEL 0
+#endif
+
+#define TRACE_SUMMARY 1
+#define TRACE_BITBOARDS 2
+
+#define ENGINE_TRACE(level, ...)                      \
+    do {                                              \
+        if constexpr ((level) <= ENGINE_TRACE_LEVEL) { \
+            __VA_ARGS__;                              \
+        }                                             \
+    } while (0)
+
+#endif // TRACE_H
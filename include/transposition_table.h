@@ -0,0 +1,79 @@
+#ifndef TRANSPOSITION_TABLE_H
+#define TRANSPOSITION_TABLE_H
+
+#include "large_pages.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+enum Bound : uint8_t {
+    BoundNone = 0,
+    BoundUpper = 1,  // Score is at most the stored value (fail low)
+    BoundLower = 2,  // Score is at least the stored value (fail high)
+    BoundExact = 3
+};
+
+struct TTEntry {
+    uint16_t move;   // Move::pack() of the best move, 0 if none
+    int16_t score;
+    int8_t depth;
+    Bound bound;
+};
+
+// Search hash table. Each slot holds the key xored with a packed data word, so
+// concurrent writers need no locks: a torn entry fails the key check and reads as a miss.
+// The same check makes a file-backed table safe to share between processes and to reload
+// after a crash: any slot that was half written, or written by a different build, misses.
+class TranspositionTable {
+public:
+    // Bump whenever the slot layout or the meaning of a data word changes; files written
+    // with another version are discarded when mapped
+    static constexpr uint32_t FileVersion = 1;
+
+    explicit TranspositionTable(size_t megabytes = 16, LargePages::Mode request = LargePages::Mode::Explicit);
+
+    // Slots in caller-owned memory, e.g. one of many small tables carved from a pool; the
+    // memory must outlive the table. resize() and mapFile() move it to memory of its own.
+    TranspositionTable(void* memory, size_t bytes);
+    ~TranspositionTable();
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+    // Reallocates (and clears) the table, backed by the best page size available up to request
+    void resize(size_t megabytes, LargePages::Mode request = LargePages::Mode::Explicit);
+    void clear();
+
+    // Backs the table with a shared mapping of path, so entries outlive the process and are
+    // seen by every other process mapping the same file. A file with a valid header keeps its
+    // own size and entries; anything else is replaced by an empty file of megabytes of slots,
+    // renamed into place so processes still mapping the old one are unaffected. false with a
+    // reason if the file cannot be opened, locked or mapped. resize() returns to private memory.
+    bool mapFile(const std::string& path, size_t megabytes, std::string& error);
+    bool isMapped() const { return mapping != nullptr; }
+
+    bool probe(uint64_t key, TTEntry& entry) const;
+    void store(uint64_t key, int depth, int score, Bound bound, uint16_t move);
+
+    // Permille of sampled slots in use, as reported by UCI "hashfull"
+    int hashfull() const;
+    size_t sizeInMegabytes() const { return megabytes; }
+    LargePages::Mode pageMode() const { return mapping ? LargePages::Mode::Normal : memory.mode(); }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> check;
+        std::atomic<uint64_t> data;
+    };
+
+    void unmapFile();
+
+    LargePages::Buffer memory;
+    void* mapping;        // Whole file mapping (header and slots) when file backed
+    size_t mappingBytes;
+    Slot* slots;
+    uint64_t mask;
+    size_t megabytes;
+};
+
+#endif // TRANSPOSITION_TABLE_H
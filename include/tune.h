@@ -0,0 +1,115 @@
+#ifndef TUNE_H
+#define TUNE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include "board.h"
+
+// Texel-style tuning of the evaluation weights: fit them so that a sigmoid of the static
+// evaluation predicts the game results of a set of labelled positions.
+namespace Tune {
+    // The tuned weights, flattened: middlegame then endgame material for Pawn..Queen, then the
+    // tables in evaluate_params.h order (PawnMg, PawnEg, Knight, Bishop, Rook, Queen, KingMg,
+    // KingEg), 64 squares each
+    constexpr int MaterialTerms = 5;
+    constexpr int TableCount = 8;
+    constexpr int ParameterCount = 2 * MaterialTerms + TableCount * 64;
+
+    // The weights the engine is compiled with
+    std::vector<double> defaultParameters();
+
+    // Writes the weights, rounded, as a replacement for include/evaluate_params.h
+    void writeHeader(std::ostream& out, const std::vector<double>& parameters);
+
+    // Labelled positions reduced to what the evaluation reads. The evaluation is linear in the
+    // weights of each phase, so a position is kept as its net piece counts per (piece type,
+    // square) feature (White minus Black, mirrored to White's view; nearly always +1 or -1)
+    // and its phase. Positions are stored in blocks of Lanes, feature rows interleaved across
+    // the lanes, so the tuner can gather a row of weights for a whole block at once.
+    class Dataset {
+    public:
+        static constexpr size_t Lanes = 8;
+        static constexpr int FeatureCount = 6 * 64;
+
+        Dataset() : count(0) {}
+
+        // result is from White's point of view: 1 win, 0.5 draw, 0 loss
+        void add(const Board& board, float result);
+
+        // Appends the positions of a file: "FEN result" lines, the result as 1-0, 0-1, 1/2-1/2
+        // or 1.0, 0.5, 0.0 and optionally quoted or bracketed (so EPD c9 "1-0"; lines work),
+        // or datagen records for a path ending in .bin. Lines that do not parse are counted in
+        // skipped. False with error set if the file cannot be read.
+        bool load(const std::string& path, size_t& skipped, std::string& error);
+
+        size_t size() const { return count; }
+        size_t bytes() const;
+
+    private:
+        friend class Tuner;
+
+        struct Block {
+            size_t offset;          // First row in features and counts; a row is Lanes entries
+            uint32_t rows;
+            uint32_t lanes;
+            float phase[Lanes];     // Middlegame share of the evaluation, phase / MaxPhase
+            float result[Lanes];
+        };
+
+        std::vector<Block> blocks;
+        std::vector<int16_t> features;  // Unused entries point at feature 0 with count 0
+        std::vector<int8_t> counts;
+        size_t count;
+    };
+
+    // Full-batch optimisation of the mean squared error between the results and
+    // 1 / (1 + 10^(-scale * eval / 400)). Each pass splits the blocks evenly over the threads;
+    // every thread sums the loss and the feature gradients of its share, which are added up in
+    // thread order, so a pass gives the same answer every time for a given thread count.
+    class Tuner {
+    public:
+        Tuner(const Dataset& data, std::vector<double> parameters, int threads = 1);
+
+        // Loss for the current weights; with gradient, also fills gradient()
+        double loss(double scale, bool gradient = false);
+
+        // Scale minimising the loss for the current weights, by golden-section search
+        double fitScale();
+
+        // One optimiser step over the whole dataset; return the loss before the step
+        double stepAdam(double scale, double learningRate);
+        double stepGradientDescent(double scale, double learningRate);
+
+        const std::vector<double>& parameters() const { return weights; }
+        void setParameters(const std::vector<double>& parameters) { weights = parameters; }
+        const std::vector<double>& gradient() const { return gradients; }
+
+        // Evaluation of position index from White's point of view, as the tuner models it
+        double evaluate(size_t index);
+
+    private:
+        struct Accumulator;
+
+        void refreshFeatures();
+        void passRange(size_t firstBlock, size_t lastBlock, double k, bool gradient, Accumulator& sum) const;
+
+        const Dataset& data;
+        std::vector<double> weights;
+        std::vector<double> gradients;
+        std::vector<float> featureMg;   // Per feature weight, material and table folded together
+        std::vector<float> featureEg;
+        std::vector<double> moment;     // Adam first and second moment estimates
+        std::vector<double> variance;
+        int steps;
+        int threads;
+    };
+
+    // "tune --data FILE [--data FILE ...] [--threads N] [--epochs N] [--optimizer adam|gd]
+    //  [--lr X] [--scale K] [--report N] [--out FILE]"
+    int runCommand(const std::vector<std::string>& args);
+}
+
+#endif // TUNE_H
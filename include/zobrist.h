@@ -0,0 +1,47 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <cstdint>
+
+// Zobrist hashing keys. The table is generated at compile time, so it is immutable and
+// needs no initialisation call before use.
+namespace Zobrist {
+    struct Keys {
+        uint64_t pieces[2][7][64];   // [color][piece type][square], piece types start at 1
+        uint64_t castling[16];       // Indexed by the castling rights bitmask
+        uint64_t enPassantFile[8];
+        uint64_t side;               // Xored in when black is to move
+    };
+
+    constexpr uint64_t splitMix64(uint64_t& state) {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    constexpr Keys generateKeys() {
+        Keys keys{};
+        uint64_t state = 0x2545F4914F6CDD1DULL;
+        for (int color = 0; color < 2; ++color) {
+            for (int piece = 0; piece < 7; ++piece) {
+                for (int square = 0; square < 64; ++square) {
+                    keys.pieces[color][piece][square] = splitMix64(state);
+                }
+            }
+        }
+        // No rights hashes to zero so a bare position hashes to just its pieces
+        for (int rights = 1; rights < 16; ++rights) {
+            keys.castling[rights] = splitMix64(state);
+        }
+        for (int file = 0; file < 8; ++file) {
+            keys.enPassantFile[file] = splitMix64(state);
+        }
+        keys.side = splitMix64(state);
+        return keys;
+    }
+
+    inline constexpr Keys keys = generateKeys();
+}
+
+#endif // ZOBRIST_H
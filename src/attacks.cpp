@@ -0,0 +1,112 @@
+#include "attacks.h"
+
+#ifdef ENGINE_AVX2
+#include <immintrin.h>
+#endif
+
+namespace Attacks {
+    void sliderAttacksScalar(uint64_t bishops, uint64_t rooks, uint64_t queens, uint64_t occupied,
+                             uint64_t& bishopAttacks, uint64_t& rookAttacks, uint64_t& queenAttacks) {
+        uint64_t empty = ~occupied;
+        bishopAttacks = diagonalAttacksScalar(bishops, empty);
+        rookAttacks = straightAttacksScalar(rooks, empty);
+        queenAttacks = diagonalAttacksScalar(queens, empty) | straightAttacksScalar(queens, empty);
+    }
+
+#ifdef ENGINE_AVX2
+    namespace {
+        // Lane layout: north (8), east (1), north-east (9), north-west (7) for left shifts, and
+        // the opposite rays south, west, south-west, south-east for right shifts by the same amounts.
+        // Lanes 0-1 are straight rays, lanes 2-3 diagonal ones.
+        const __m256i Shift1 = _mm256_setr_epi64x(8, 1, 9, 7);
+        const __m256i Shift2 = _mm256_setr_epi64x(16, 2, 18, 14);
+        const __m256i Shift4 = _mm256_setr_epi64x(32, 4, 36, 28);
+        const __m256i UpMask = _mm256_setr_epi64x(-1, MoveGeneration::NotFileA, MoveGeneration::NotFileA, MoveGeneration::NotFileH);
+        const __m256i DownMask = _mm256_setr_epi64x(-1, MoveGeneration::NotFileH, MoveGeneration::NotFileH, MoveGeneration::NotFileA);
+
+        template <bool Up>
+        inline __m256i shiftLanes(__m256i bitboards, __m256i amounts) {
+            return Up ? _mm256_sllv_epi64(bitboards, amounts) : _mm256_srlv_epi64(bitboards, amounts);
+        }
+
+        // The scalar slide<Direction> for four directions at once
+        template <bool Up>
+        inline __m256i slideLanes(__m256i generators, __m256i empty) {
+            const __m256i mask = Up ? UpMask : DownMask;
+            __m256i propagators = _mm256_and_si256(empty, mask);
+            generators = _mm256_or_si256(generators, _mm256_and_si256(propagators, shiftLanes<Up>(generators, Shift1)));
+            propagators = _mm256_and_si256(propagators, shiftLanes<Up>(propagators, Shift1));
+            generators = _mm256_or_si256(generators, _mm256_and_si256(propagators, shiftLanes<Up>(generators, Shift2)));
+            propagators = _mm256_and_si256(propagators, shiftLanes<Up>(propagators, Shift2));
+            generators = _mm256_or_si256(generators, _mm256_and_si256(propagators, shiftLanes<Up>(generators, Shift4)));
+            return _mm256_and_si256(shiftLanes<Up>(generators, Shift1), mask);
+        }
+
+        // All eight rays of the generators in each lane, still split by lane
+        inline __m256i slideAll(__m256i generators, __m256i empty) {
+            return _mm256_or_si256(slideLanes<true>(generators, empty), slideLanes<false>(generators, empty));
+        }
+
+        inline uint64_t orLanes(__m256i bitboards) {
+            __m128i halves = _mm_or_si128(_mm256_castsi256_si128(bitboards), _mm256_extracti128_si256(bitboards, 1));
+            return static_cast<uint64_t>(_mm_cvtsi128_si64(halves) | _mm_extract_epi64(halves, 1));
+        }
+    }
+
+    void sliderAttacks(uint64_t bishops, uint64_t rooks, uint64_t queens, uint64_t occupied,
+                       uint64_t& bishopAttacks, uint64_t& rookAttacks, uint64_t& queenAttacks) {
+        const __m256i empty = _mm256_set1_epi64x(static_cast<long long>(~occupied));
+        __m256i pieces = slideAll(_mm256_setr_epi64x(rooks, rooks, bishops, bishops), empty);
+        __m256i queenRays = slideAll(_mm256_set1_epi64x(static_cast<long long>(queens)), empty);
+
+        __m128i straight = _mm256_castsi256_si128(pieces);
+        __m128i diagonal = _mm256_extracti128_si256(pieces, 1);
+        rookAttacks = static_cast<uint64_t>(_mm_cvtsi128_si64(straight) | _mm_extract_epi64(straight, 1));
+        bishopAttacks = static_cast<uint64_t>(_mm_cvtsi128_si64(diagonal) | _mm_extract_epi64(diagonal, 1));
+        queenAttacks = orLanes(queenRays);
+    }
+
+    uint64_t sliderAttacks(uint64_t diagonal, uint64_t straight, uint64_t occupied) {
+        const __m256i empty = _mm256_set1_epi64x(static_cast<long long>(~occupied));
+        return orLanes(slideAll(_mm256_setr_epi64x(straight, straight, diagonal, diagonal), empty));
+    }
+#else
+    void sliderAttacks(uint64_t bishops, uint64_t rooks, uint64_t queens, uint64_t occupied,
+                       uint64_t& bishopAttacks, uint64_t& rookAttacks, uint64_t& queenAttacks) {
+        sliderAttacksScalar(bishops, rooks, queens, occupied, bishopAttacks, rookAttacks, queenAttacks);
+    }
+
+    uint64_t sliderAttacks(uint64_t diagonal, uint64_t straight, uint64_t occupied) {
+        uint64_t empty = ~occupied;
+        return diagonalAttacksScalar(diagonal, empty) | straightAttacksScalar(straight, empty);
+    }
+#endif
+
+    AttackMap attackMap(const Board& board, PieceColor side) {
+        AttackMap map;
+        map.byPiece[0] = 0ULL;
+        map.byPiece[Pawn] = side == White ? MoveGeneration::pawnAttacks<White>(board.getPieces(White, Pawn))
+                                          : MoveGeneration::pawnAttacks<Black>(board.getPieces(Black, Pawn));
+        map.byPiece[Knight] = knightAttacks(board.getPieces(side, Knight));
+        sliderAttacks(board.getPieces(side, Bishop), board.getPieces(side, Rook), board.getPieces(side, Queen),
+                      board.getOccupiedSquares(), map.byPiece[Bishop], map.byPiece[Rook], map.byPiece[Queen]);
+        map.byPiece[King] = kingAttacks(board.getPieces(side, King));
+
+        map.all = 0ULL;
+        for (int pieceType = Pawn; pieceType <= King; ++pieceType) {
+            map.all |= map.byPiece[pieceType];
+        }
+        return map;
+    }
+
+    uint64_t allAttacks(const Board& board, PieceColor side) {
+        uint64_t queens = board.getPieces(side, Queen);
+        uint64_t pawns = side == White ? MoveGeneration::pawnAttacks<White>(board.getPieces(White, Pawn))
+                                       : MoveGeneration::pawnAttacks<Black>(board.getPieces(Black, Pawn));
+        return pawns
+             | knightAttacks(board.getPieces(side, Knight))
+             | sliderAttacks(board.getPieces(side, Bishop) | queens, board.getPieces(side, Rook) | queens,
+                             board.getOccupiedSquares())
+             | kingAttacks(board.getPieces(side, King));
+    }
+}
@@ -1,43 +1,135 @@
 #include "board.h"
+#include "attacks.h"
 #include "move_generation.h"
+#include "cuckoo.h"
 #include "move.h"
+#include "stats.h"
+#include "trace.h"
+#include "zobrist.h"
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
+#include <sstream>
 #include <vector>
 
+int firstSetBit(uint64_t x) {
+    for (int i = 0; i < 64; i++) {
+        if (x & (1ULL << i)) return i;
+    }
+    return -1; // No bits set
+}
+
 // Constructor: Initializes bitboards to zero
 Board::Board()
-    : white_pawns(0ULL), white_knights(0ULL), white_bishops(0ULL), white_rooks(0ULL), white_queens(0ULL), white_king(0ULL),
-      black_pawns(0ULL), black_knights(0ULL), black_bishops(0ULL), black_rooks(0ULL), black_queens(0ULL), black_king(0ULL),
-      white_pieces(0ULL), black_pieces(0ULL), occupied(0ULL),
-      enPassantSquare(0ULL), whiteCanCastleKingSide(true), whiteCanCastleQueenSide(true),
-      blackCanCastleKingSide(true), blackCanCastleQueenSide(true) {}
+    : pieces{}, colors{}, occupied(0ULL), attacked{}, attackerCounts{},
+      enPassantSquare(0ULL), key(0ULL), castlingRights(WhiteKingSide | WhiteQueenSide | BlackKingSide | BlackQueenSide),
+      halfmoveClock(0), pliesFromNull(0), history(nullptr), whiteToMove(true) {}
+
+// Recomputes the color and occupancy unions from the piece bitboards
+void Board::updateUnions() {
+    for (int color = White; color <= Black; ++color) {
+        colors[color] = 0ULL;
+        for (uint64_t bitboard : pieces[color]) {
+            colors[color] |= bitboard;
+        }
+    }
+    occupied = colors[White] | colors[Black];
+}
 
 // Sets up the starting position for the board
 void Board::initializePosition() {
-    white_pieces = black_pieces = occupied = 0ULL;
-
     // Initialize individual pieces and update aggregate bitboards
-    white_pawns = 0x000000000000FF00ULL;
-    white_knights = 0x0000000000000042ULL;
-    white_bishops = 0x0000000000000024ULL;
-    white_rooks = 0x0000000000000081ULL;
-    white_queens = 0x0000000000000008ULL;
-    white_king = 0x0000000000000010ULL;
-    black_pawns = 0x00FF000000000000ULL;
-    black_knights = 0x4200000000000000ULL;
-    black_bishops = 0x2400000000000000ULL;
-    black_rooks = 0x8100000000000000ULL;
-    black_queens = 0x0800000000000000ULL;
-    black_king = 0x1000000000000000ULL;
-
-    white_pieces = white_pawns | white_knights | white_bishops | white_rooks | white_queens | white_king;
-    black_pieces = black_pawns | black_knights | black_bishops | black_rooks | black_queens | black_king;
-    occupied = white_pieces | black_pieces;
+    pieces[White][Pawn - Pawn] = 0x000000000000FF00ULL;
+    pieces[White][Knight - Pawn] = 0x0000000000000042ULL;
+    pieces[White][Bishop - Pawn] = 0x0000000000000024ULL;
+    pieces[White][Rook - Pawn] = 0x0000000000000081ULL;
+    pieces[White][Queen - Pawn] = 0x0000000000000008ULL;
+    pieces[White][King - Pawn] = 0x0000000000000010ULL;
+    pieces[Black][Pawn - Pawn] = 0x00FF000000000000ULL;
+    pieces[Black][Knight - Pawn] = 0x4200000000000000ULL;
+    pieces[Black][Bishop - Pawn] = 0x2400000000000000ULL;
+    pieces[Black][Rook - Pawn] = 0x8100000000000000ULL;
+    pieces[Black][Queen - Pawn] = 0x0800000000000000ULL;
+    pieces[Black][King - Pawn] = 0x1000000000000000ULL;
+    updateUnions();
+    computeAttacks();
 
     // Reset advanced move state
     enPassantSquare = 0ULL;
-    whiteCanCastleKingSide = whiteCanCastleQueenSide = true;
-    blackCanCastleKingSide = blackCanCastleQueenSide = true;
+    castlingRights = WhiteKingSide | WhiteQueenSide | BlackKingSide | BlackQueenSide;
+    halfmoveClock = pliesFromNull = 0;
+    whiteToMove = true;
+    key = computeKey();
+}
+
+// Sets up the board from a FEN string; returns false if the placement field is malformed
+bool Board::loadFen(const std::string& fen) {
+    std::istringstream stream(fen);
+    std::string placement, side, castling, enPassant;
+    int halfmoves = 0;
+    stream >> placement >> side >> castling >> enPassant >> halfmoves;
+
+    uint64_t* bitboards[128] = {nullptr};
+    const char* letters = "PNBRQK";
+    for (int pieceType = Pawn; pieceType <= King; ++pieceType) {
+        char letter = letters[pieceType - Pawn];
+        bitboards[static_cast<int>(letter)] = &pieces[White][pieceType - Pawn];
+        bitboards[static_cast<int>(letter - 'A' + 'a')] = &pieces[Black][pieceType - Pawn];
+        pieces[White][pieceType - Pawn] = pieces[Black][pieceType - Pawn] = 0ULL;
+    }
+
+    // Placement runs from a8 to h1, rank by rank
+    int rank = 7, file = 0;
+    for (char c : placement) {
+        if (c == '/') {
+            --rank;
+            file = 0;
+        } else if (c >= '1' && c <= '8') {
+            file += c - '0';
+        } else if (c > 0 && bitboards[static_cast<int>(c)] && rank >= 0 && file < 8) {
+            setPiece(rank * 8 + file, *bitboards[static_cast<int>(c)]);
+            ++file;
+        } else {
+            return false;
+        }
+    }
+
+    updateUnions();
+    computeAttacks();
+
+    whiteToMove = side != "b";
+    castlingRights = 0;
+    if (castling.find('K') != std::string::npos) castlingRights |= WhiteKingSide;
+    if (castling.find('Q') != std::string::npos) castlingRights |= WhiteQueenSide;
+    if (castling.find('k') != std::string::npos) castlingRights |= BlackKingSide;
+    if (castling.find('q') != std::string::npos) castlingRights |= BlackQueenSide;
+
+    // En passant target is kept as a bitboard, matching generatePawnMoves
+    enPassantSquare = 0ULL;
+    if (enPassant.size() == 2 && enPassant[0] >= 'a' && enPassant[0] <= 'h' && enPassant[1] >= '1' && enPassant[1] <= '8') {
+        enPassantSquare = 1ULL << ((enPassant[1] - '1') * 8 + (enPassant[0] - 'a'));
+    }
+    halfmoveClock = halfmoves > 0 ? halfmoves : 0;
+    pliesFromNull = 0;
+    key = computeKey();
+    return true;
+}
+
+void Board::loadPosition(const uint64_t bitboards[2][6], bool isWhiteToMove, int castling, uint64_t enPassant,
+                         int halfmoves) {
+    for (int color = White; color <= Black; ++color) {
+        for (int index = 0; index < 6; ++index) {
+            pieces[color][index] = bitboards[color][index];
+        }
+    }
+    updateUnions();
+    computeAttacks();
+    whiteToMove = isWhiteToMove;
+    castlingRights = castling;
+    enPassantSquare = enPassant;
+    halfmoveClock = halfmoves;
+    pliesFromNull = 0;
+    key = computeKey();
 }
 
 // Sets a piece at a specific square in the given bitboard
@@ -67,387 +159,864 @@ void Board::displayBitboard(const uint64_t& bitboard) {
     std::cout << std::endl;
 }
 
-void Board::makeMove(const Move& move) {
-    // Extract source and target squares from the move
-    int sourceSquare = move.sourceSquare;
-    int targetSquare = move.targetSquare;
-    uint64_t sourceBit = (1ULL << sourceSquare);
-    uint64_t targetBit = (1ULL << targetSquare);
+int Board::getPieceAt(int square, bool isWhite) const {
+    uint64_t bit = 1ULL << square;
+    const uint64_t* own = pieces[isWhite ? White : Black];
+    if (!(colors[isWhite ? White : Black] & bit)) return 0;
+    for (int pieceType = Pawn; pieceType < King; ++pieceType) {
+        if (own[pieceType - Pawn] & bit) return pieceType;
+    }
+    return King;
+}
 
-    // Determine the piece color based on the source square
-    bool isWhite = white_pieces & sourceBit;
+// Piece helpers keep the piece, color and occupancy bitboards and the key in step
+template <PieceColor C>
+void Board::addPiece(int pieceType, int square) {
+    uint64_t bit = 1ULL << square;
+    pieces[C][pieceType - Pawn] |= bit;
+    colors[C] |= bit;
+    occupied |= bit;
+    key ^= Zobrist::keys.pieces[C][pieceType][square];
+}
 
-    // Remove the piece from the source square
-    if (isWhite) {
-        white_pieces &= ~sourceBit;
-    } else {
-        black_pieces &= ~sourceBit;
+template <PieceColor C>
+void Board::removePiece(int pieceType, int square) {
+    uint64_t bit = 1ULL << square;
+    pieces[C][pieceType - Pawn] &= ~bit;
+    colors[C] &= ~bit;
+    occupied &= ~bit;
+    key ^= Zobrist::keys.pieces[C][pieceType][square];
+}
+
+template <PieceColor C>
+void Board::movePiece(int pieceType, int sourceSquare, int targetSquare) {
+    uint64_t bits = (1ULL << sourceSquare) | (1ULL << targetSquare);
+    pieces[C][pieceType - Pawn] ^= bits;
+    colors[C] ^= bits;
+    occupied ^= bits;
+    key ^= Zobrist::keys.pieces[C][pieceType][sourceSquare] ^ Zobrist::keys.pieces[C][pieceType][targetSquare];
+}
+
+void Board::computeAttacks() {
+    attacked[White] = attacked[Black] = 0ULL;
+    std::fill(&attackerCounts[0][0], &attackerCounts[0][0] + 2 * 64, 0);
+    applyAttacks<White, 1>(colors[White]);
+    applyAttacks<Black, 1>(colors[Black]);
+}
+
+// Adds (Delta = 1) or removes (Delta = -1) one attacker of side C on each of the squares
+template <PieceColor C, int Delta>
+void Board::countAttacks(uint64_t squares) {
+    if (Delta > 0) {
+        attacked[C] |= squares;
+    }
+    while (squares) {
+        int square = __builtin_ctzll(squares);
+        attackerCounts[C][square] += Delta;
+        if (Delta < 0 && attackerCounts[C][square] == 0) {
+            attacked[C] &= ~(1ULL << square);
+        }
+        squares &= squares - 1;
     }
-    occupied &= ~sourceBit;
+}
 
-    // Move the piece to the target square
-    if (isWhite) {
-        white_pieces |= targetBit;
-    } else {
-        black_pieces |= targetBit;
+// Counts the attacks of C's pieces on the refresh squares with the current occupancy. Each
+// direction is done set-wise: one direction's steps or rays from different pieces never land
+// on the same square (a ray stops at the first piece), so every attacker is counted once.
+template <PieceColor C, int Delta>
+void Board::applyAttacks(uint64_t refresh) {
+    using MoveGeneration::NotFileA;
+    using MoveGeneration::NotFileH;
+    using MoveGeneration::shift;
+    using Traits = MoveGeneration::ColorTraits<C>;
+    constexpr uint64_t NotFileAB = 0xFCFCFCFCFCFCFCFCULL;
+    constexpr uint64_t NotFileGH = 0x3F3F3F3F3F3F3F3FULL;
+
+    uint64_t pawns = refresh & pieces[C][Pawn - Pawn];
+    if (pawns) {
+        countAttacks<C, Delta>(shift<Traits::UpLeft>(pawns & NotFileA));
+        countAttacks<C, Delta>(shift<Traits::UpRight>(pawns & NotFileH));
     }
-    occupied |= targetBit;
 
-    // Handle captures
-    if (move.isCapture) {
-        uint64_t captureMask = targetBit;
-        if (isWhite) {
-            black_pieces &= ~captureMask;
-        } else {
-            white_pieces &= ~captureMask;
-        }
+    uint64_t knights = refresh & pieces[C][Knight - Pawn];
+    if (knights) {
+        countAttacks<C, Delta>((knights << 17) & NotFileA);
+        countAttacks<C, Delta>((knights << 15) & NotFileH);
+        countAttacks<C, Delta>((knights << 10) & NotFileAB);
+        countAttacks<C, Delta>((knights << 6) & NotFileGH);
+        countAttacks<C, Delta>((knights >> 6) & NotFileAB);
+        countAttacks<C, Delta>((knights >> 10) & NotFileGH);
+        countAttacks<C, Delta>((knights >> 15) & NotFileA);
+        countAttacks<C, Delta>((knights >> 17) & NotFileH);
     }
 
-    // Handle promotions
-    if (move.isPromotion) {
-        uint64_t promotionMask = targetBit;
-        if (isWhite) {
-            white_pawns &= ~promotionMask;
-            white_queens |= promotionMask;
-        } else {
-            black_pawns &= ~promotionMask;
-            black_queens |= promotionMask;
-        }
+    uint64_t empty = ~occupied;
+    uint64_t diagonal = refresh & (pieces[C][Bishop - Pawn] | pieces[C][Queen - Pawn]);
+    if (diagonal) {
+        countAttacks<C, Delta>(Attacks::slide<9>(diagonal, empty));
+        countAttacks<C, Delta>(Attacks::slide<7>(diagonal, empty));
+        countAttacks<C, Delta>(Attacks::slide<-7>(diagonal, empty));
+        countAttacks<C, Delta>(Attacks::slide<-9>(diagonal, empty));
+    }
+    uint64_t straight = refresh & (pieces[C][Rook - Pawn] | pieces[C][Queen - Pawn]);
+    if (straight) {
+        countAttacks<C, Delta>(Attacks::slide<8>(straight, empty));
+        countAttacks<C, Delta>(Attacks::slide<-8>(straight, empty));
+        countAttacks<C, Delta>(Attacks::slide<1>(straight, empty));
+        countAttacks<C, Delta>(Attacks::slide<-1>(straight, empty));
     }
 
-    // Handle en passant
-    if (move.isEnPassant) {
-        int epCapturedSquare = isWhite ? targetSquare - 8 : targetSquare + 8;
-        uint64_t epCaptureMask = (1ULL << epCapturedSquare);
-        if (isWhite) {
-            black_pawns &= ~epCaptureMask;
-        } else {
-            white_pawns &= ~epCaptureMask;
-        }
-        occupied &= ~epCaptureMask;
+    uint64_t king = refresh & pieces[C][King - Pawn];
+    if (king) {
+        countAttacks<C, Delta>(Attacks::kingAttacks(king));
     }
+}
 
-    // Update castling rights
-    if (move.isCastling) {
-        if (isWhite) {
-            if (targetSquare == 6) { // White king-side castling
-                white_rooks &= ~(1ULL << 7);
-                white_rooks |= (1ULL << 5);
-            } else if (targetSquare == 2) { // White queen-side castling
-                white_rooks &= ~(1ULL);
-                white_rooks |= (1ULL << 3);
-            }
-        } else {
-            if (targetSquare == 62) { // Black king-side castling
-                black_rooks &= ~(1ULL << 63);
-                black_rooks |= (1ULL << 61);
-            } else if (targetSquare == 58) { // Black queen-side castling
-                black_rooks &= ~(1ULL << 56);
-                black_rooks |= (1ULL << 59);
+// Only the pieces on the touched squares and the sliders whose rays reach one of them can
+// change what they attack. A slider sees the nearest touched square on its ray both before
+// and after the change, so the same sliders are refreshed on both sides of it. Pieces on
+// the touched squares are removed here and added back in endAttackUpdate; the sliders stay
+// put and only the squares their rays gain or lose are counted.
+Board::AttackUpdate Board::beginAttackUpdate(uint64_t touched) {
+    uint64_t diagonalRays, straightRays, unused;
+    Attacks::sliderAttacks(touched, touched, 0ULL, occupied, diagonalRays, straightRays, unused);
+
+    AttackUpdate update;
+    update.touched = touched;
+    update.empty = ~occupied;
+    for (int color = White; color <= Black; ++color) {
+        const uint64_t* own = pieces[color];
+        update.diagonal[color] = diagonalRays & (own[Bishop - Pawn] | own[Queen - Pawn]) & ~touched;
+        update.straight[color] = straightRays & (own[Rook - Pawn] | own[Queen - Pawn]) & ~touched;
+    }
+    applyAttacks<White, -1>(colors[White] & touched);
+    applyAttacks<Black, -1>(colors[Black] & touched);
+    return update;
+}
+
+void Board::endAttackUpdate(const AttackUpdate& update) {
+    updateRays<White>(update.diagonal[White], update.straight[White], update.empty);
+    updateRays<Black>(update.diagonal[Black], update.straight[Black], update.empty);
+    applyAttacks<White, 1>(colors[White] & update.touched);
+    applyAttacks<Black, 1>(colors[Black] & update.touched);
+}
+
+// Counts the squares each ray of the sliders gained or lost since the occupancy was
+// oldEmpty's complement; a direction's rays are disjoint, so their differences are too
+template <int Direction, PieceColor C>
+void Board::updateRay(uint64_t sliders, uint64_t oldEmpty) {
+    uint64_t before = Attacks::slide<Direction>(sliders, oldEmpty);
+    uint64_t after = Attacks::slide<Direction>(sliders, ~occupied);
+    countAttacks<C, -1>(before & ~after);
+    countAttacks<C, 1>(after & ~before);
+}
+
+template <PieceColor C>
+void Board::updateRays(uint64_t diagonal, uint64_t straight, uint64_t oldEmpty) {
+    if (diagonal) {
+        updateRay<9, C>(diagonal, oldEmpty);
+        updateRay<7, C>(diagonal, oldEmpty);
+        updateRay<-7, C>(diagonal, oldEmpty);
+        updateRay<-9, C>(diagonal, oldEmpty);
+    }
+    if (straight) {
+        updateRay<8, C>(straight, oldEmpty);
+        updateRay<-8, C>(straight, oldEmpty);
+        updateRay<1, C>(straight, oldEmpty);
+        updateRay<-1, C>(straight, oldEmpty);
+    }
+}
+
+// Computes the Zobrist key from scratch
+uint64_t Board::computeKey() const {
+    uint64_t result = 0ULL;
+    for (int square = 0; square < 64; ++square) {
+        for (int color = White; color <= Black; ++color) {
+            int piece = getPieceAt(square, color == White);
+            if (piece) {
+                result ^= Zobrist::keys.pieces[color][piece][square];
             }
         }
     }
+    result ^= Zobrist::keys.castling[castlingRights];
+    if (enPassantSquare) {
+        result ^= Zobrist::keys.enPassantFile[firstSetBit(enPassantSquare) % 8];
+    }
+    if (!whiteToMove) {
+        result ^= Zobrist::keys.side;
+    }
+    return result;
+}
+
+// Castling rights that survive a move touching each square (king and rook home squares clear theirs)
+static int castlingRightsMask(int square) {
+    switch (square) {
+        case 0: return ~WhiteQueenSide;
+        case 4: return ~(WhiteKingSide | WhiteQueenSide);
+        case 7: return ~WhiteKingSide;
+        case 56: return ~BlackQueenSide;
+        case 60: return ~(BlackKingSide | BlackQueenSide);
+        case 63: return ~BlackKingSide;
+        default: return ~0;
+    }
+}
 
-    // Update en passant square
-    enPassantSquare = move.isDoublePawnPush ? (isWhite ? targetSquare - 8 : targetSquare + 8) : 0;
+static uint64_t enPassantKey(uint64_t enPassantSquare) {
+    return enPassantSquare ? Zobrist::keys.enPassantFile[firstSetBit(enPassantSquare) % 8] : 0ULL;
+}
+
+// The side to move is taken from the piece on the source square; the rest is resolved at compile time
+void Board::makeMove(const Move& move) {
+    if (colors[White] & (1ULL << move.sourceSquare)) {
+        makeMove<White>(move);
+    } else {
+        makeMove<Black>(move);
+    }
 }
 
 void Board::undoMove(const Move& move) {
+    if (colors[White] & (1ULL << move.targetSquare)) {
+        undoMove<White>(move);
+    } else {
+        undoMove<Black>(move);
+    }
+}
+
+// Squares whose occupant a move changes: source, target, the en passant victim and the castling rook
+template <PieceColor Us>
+static uint64_t touchedSquares(const Move& move) {
+    uint64_t touched = (1ULL << move.sourceSquare) | (1ULL << move.targetSquare);
+    if (move.isEnPassant) {
+        touched |= 1ULL << (move.targetSquare - MoveGeneration::ColorTraits<Us>::Up);
+    }
+    if (move.isCastling) {
+        touched |= move.targetSquare > move.sourceSquare ? (0xA0ULL << (move.sourceSquare - 4))
+                                                         : (0x09ULL << (move.sourceSquare - 4));
+    }
+    return touched;
+}
+
+template <PieceColor Us>
+void Board::makeMove(const Move& move) {
+    using Traits = MoveGeneration::ColorTraits<Us>;
+    constexpr PieceColor Them = Traits::Them;
+
     // Extract source and target squares from the move
     int sourceSquare = move.sourceSquare;
     int targetSquare = move.targetSquare;
-    uint64_t sourceBit = (1ULL << sourceSquare);
-    uint64_t targetBit = (1ULL << targetSquare);
-
-    // Determine the piece color based on the target square
-    bool isWhite = white_pieces & targetBit;
+    int movingPiece = getPieceAt(sourceSquare, Traits::IsWhite);
 
-    // Move the piece back to the source square
-    if (isWhite) {
-        white_pieces |= sourceBit;
-        white_pieces &= ~targetBit;
-    } else {
-        black_pieces |= sourceBit;
-        black_pieces &= ~targetBit;
+    if (history) {
+        history->push(key);
     }
-    occupied &= ~targetBit;
-    occupied |= sourceBit;
+    halfmoveClock = (movingPiece == Pawn || move.isCapture) ? 0 : halfmoveClock + 1;
+    ++pliesFromNull;
 
-    // Restore captures
-    if (move.isCapture) {
-        uint64_t captureMask = targetBit;
-        if (isWhite) {
-            black_pieces |= captureMask;
-        } else {
-            white_pieces |= captureMask;
-        }
-        occupied |= captureMask;
+    key ^= Zobrist::keys.castling[castlingRights] ^ enPassantKey(enPassantSquare);
+    AttackUpdate attackUpdate = beginAttackUpdate(touchedSquares<Us>(move));
+
+    // Handle captures (the en passant victim is not on the target square)
+    if (move.isEnPassant) {
+        removePiece<Them>(Pawn, targetSquare - Traits::Up);
+    } else if (move.isCapture) {
+        removePiece<Them>(move.capturedPiece, targetSquare);
     }
 
-    // Undo promotions
+    // Move the piece, replacing it on promotion
     if (move.isPromotion) {
-        uint64_t promotionMask = targetBit;
-        if (isWhite) {
-            white_queens &= ~promotionMask;
-            white_pawns |= promotionMask;
-        } else {
-            black_queens &= ~promotionMask;
-            black_pawns |= promotionMask;
-        }
+        removePiece<Us>(Pawn, sourceSquare);
+        addPiece<Us>(move.promotionPiece ? move.promotionPiece : Queen, targetSquare);
+    } else {
+        movePiece<Us>(movingPiece, sourceSquare, targetSquare);
     }
 
-    // Undo en passant
-    if (move.isEnPassant) {
-        int epCapturedSquare = isWhite ? targetSquare - 8 : targetSquare + 8;
-        uint64_t epCaptureMask = (1ULL << epCapturedSquare);
-        if (isWhite) {
-            black_pawns |= epCaptureMask;
-        } else {
-            white_pawns |= epCaptureMask;
+    // Castling also moves the rook
+    if (move.isCastling) {
+        if (targetSquare > sourceSquare) { // King-side castling
+            movePiece<Us>(Rook, sourceSquare + 3, sourceSquare + 1);
+        } else { // Queen-side castling
+            movePiece<Us>(Rook, sourceSquare - 4, sourceSquare - 1);
         }
-        occupied |= epCaptureMask;
     }
+    endAttackUpdate(attackUpdate);
+
+    // Update castling rights and the en passant square
+    castlingRights &= castlingRightsMask(sourceSquare) & castlingRightsMask(targetSquare);
+    enPassantSquare = move.isDoublePawnPush ? (1ULL << (targetSquare - Traits::Up)) : 0ULL;
+
+    key ^= Zobrist::keys.castling[castlingRights] ^ enPassantKey(enPassantSquare) ^ Zobrist::keys.side;
+    whiteToMove = !Traits::IsWhite;
+}
+
+template <PieceColor Us>
+void Board::undoMove(const Move& move) {
+    using Traits = MoveGeneration::ColorTraits<Us>;
+    constexpr PieceColor Them = Traits::Them;
+
+    // Extract source and target squares from the move
+    int sourceSquare = move.sourceSquare;
+    int targetSquare = move.targetSquare;
+
+    key ^= Zobrist::keys.castling[castlingRights] ^ enPassantKey(enPassantSquare) ^ Zobrist::keys.side;
+    AttackUpdate attackUpdate = beginAttackUpdate(touchedSquares<Us>(move));
 
     // Undo castling
     if (move.isCastling) {
-        if (isWhite) {
-            if (targetSquare == 6) { // White king-side castling
-                white_rooks |= (1ULL << 7);
-                white_rooks &= ~(1ULL << 5);
-            } else if (targetSquare == 2) { // White queen-side castling
-                white_rooks |= (1ULL);
-                white_rooks &= ~(1ULL << 3);
-            }
-        } else {
-            if (targetSquare == 62) { // Black king-side castling
-                black_rooks |= (1ULL << 63);
-                black_rooks &= ~(1ULL << 61);
-            } else if (targetSquare == 58) { // Black queen-side castling
-                black_rooks |= (1ULL << 56);
-                black_rooks &= ~(1ULL << 59);
-            }
+        if (targetSquare > sourceSquare) { // King-side castling
+            movePiece<Us>(Rook, sourceSquare + 1, sourceSquare + 3);
+        } else { // Queen-side castling
+            movePiece<Us>(Rook, sourceSquare - 1, sourceSquare - 4);
         }
     }
 
-    // Restore en passant square
-    enPassantSquare = move.previousEnPassantSquare;
-}
+    // Move the piece back to the source square, undoing promotions
+    if (move.isPromotion) {
+        removePiece<Us>(getPieceAt(targetSquare, Traits::IsWhite), targetSquare);
+        addPiece<Us>(Pawn, sourceSquare);
+    } else {
+        movePiece<Us>(getPieceAt(targetSquare, Traits::IsWhite), targetSquare, sourceSquare);
+    }
 
-uint64_t Board::getOccupiedSquares() const {
-    return white_pawns | black_pawns | white_knights | black_knights |
-           white_bishops | black_bishops | white_rooks | black_rooks |
-           white_queens | black_queens | white_king | black_king;
-}
+    // Restore captures
+    if (move.isEnPassant) {
+        addPiece<Them>(Pawn, targetSquare - Traits::Up);
+    } else if (move.isCapture) {
+        addPiece<Them>(move.capturedPiece, targetSquare);
+    }
+    endAttackUpdate(attackUpdate);
 
-int firstSetBit(uint64_t x) {
-    for (int i = 0; i < 64; i++) {
-        if (x & (1ULL << i)) return i;
+    // Restore castling rights and the en passant square
+    castlingRights = move.previousCastlingRights;
+    enPassantSquare = move.previousEnPassantSquare >= 0 ? (1ULL << move.previousEnPassantSquare) : 0ULL;
+
+    key ^= Zobrist::keys.castling[castlingRights] ^ enPassantKey(enPassantSquare);
+    whiteToMove = Traits::IsWhite;
+
+    halfmoveClock = move.previousHalfmoveClock;
+    --pliesFromNull;
+    if (history) {
+        history->pop();
     }
-    return -1; // No bits set
 }
 
-void addPawnMovesToVector(uint64_t pawns, uint64_t movesBitboard, int direction, std::vector<Move>& moves) {
-    while (movesBitboard) {
-        // Extract the target square from the bitboard
-        int targetSquare = firstSetBit(movesBitboard);
-        movesBitboard &= movesBitboard - 1;
+Board::NullMoveState Board::makeNullMove() {
+    NullMoveState state{enPassantSquare, halfmoveClock, pliesFromNull};
+    if (history) {
+        history->push(key);
+    }
+    key ^= enPassantKey(enPassantSquare) ^ Zobrist::keys.side;
+    enPassantSquare = 0ULL;
+    ++halfmoveClock;
+    pliesFromNull = 0;
+    whiteToMove = !whiteToMove;
+    return state;
+}
 
-        // Calculate the source square based on direction
-        int sourceSquare = targetSquare - direction;
+void Board::undoNullMove(const NullMoveState& state) {
+    enPassantSquare = state.enPassantSquare;
+    halfmoveClock = state.halfmoveClock;
+    pliesFromNull = state.pliesFromNull;
+    key ^= enPassantKey(enPassantSquare) ^ Zobrist::keys.side;
+    whiteToMove = !whiteToMove;
+    if (history) {
+        history->pop();
+    }
+}
 
-        // Check if the move is a promotion
-        bool isPromotion = (targetSquare / 8 == 7 || targetSquare / 8 == 0); // 7th rank for White, 0th rank for Black
+bool Board::isInsufficientMaterial() const {
+    uint64_t heavy = 0ULL, minors = 0ULL;
+    for (PieceColor color : {White, Black}) {
+        heavy |= getPieces(color, Pawn) | getPieces(color, Rook) | getPieces(color, Queen);
+        minors |= getPieces(color, Knight) | getPieces(color, Bishop);
+    }
+    return !heavy && (minors & (minors - 1)) == 0;
+}
 
-        if (isPromotion) {
-            // Add promotion moves for each promotion piece type
-            moves.emplace_back(Move(sourceSquare, targetSquare, PieceType::Queen, false, false, false, true));
-            moves.emplace_back(Move(sourceSquare, targetSquare, PieceType::Rook, false, false, false, true));
-            moves.emplace_back(Move(sourceSquare, targetSquare, PieceType::Bishop, false, false, false, true));
-            moves.emplace_back(Move(sourceSquare, targetSquare, PieceType::Knight, false, false, false, true));
-        } else {
-            // Add normal pawn move
-            moves.emplace_back(Move(sourceSquare, targetSquare));
+bool Board::isRepetition() const {
+    if (!history) {
+        return false;
+    }
+    int end = std::min({halfmoveClock, pliesFromNull, static_cast<int>(history->size())});
+    for (int plies = 4; plies <= end; plies += 2) {
+        if (history->pliesAgo(plies) == key) {
+            return true;
         }
     }
+    return false;
 }
 
-void addPawnCapturesToVector(uint64_t pawns, uint64_t capturesBitboard, int leftDirection, int rightDirection, std::vector<Move>& moves) {
-    while (capturesBitboard) {
-        // Extract the target square from the bitboard
-        int targetSquare = firstSetBit(capturesBitboard); // Find the least significant bit set to 1
-        capturesBitboard &= capturesBitboard - 1;         // Clear the least significant bit
-
-        // Calculate the source square for left and right diagonal captures
-        int sourceSquareLeft = targetSquare - leftDirection;
-        int sourceSquareRight = targetSquare - rightDirection;
-
-        // Check if the source square is a valid pawn position
-        if (pawns & (1ULL << sourceSquareLeft)) {
-            moves.emplace_back(Move(sourceSquareLeft, targetSquare, 0, true)); // Add left capture
+bool Board::hasUpcomingRepetition(int ply) const {
+    if (!history) {
+        return false;
+    }
+    int end = std::min({halfmoveClock, pliesFromNull, static_cast<int>(history->size())});
+    for (int plies = 3; plies <= end; plies += 2) {
+        int from, to;
+        if (!Cuckoo::lookup(key ^ history->pliesAgo(plies), from, to)) {
+            continue;
         }
-        if (pawns & (1ULL << sourceSquareRight)) {
-            moves.emplace_back(Move(sourceSquareRight, targetSquare, 0, true)); // Add right capture
+
+        // The move only exists if nothing stands between its squares. Like the repetition
+        // rule itself, only cycles completed inside the search tree count.
+        if (!(Attacks::between(from, to) & occupied) && plies < ply) {
+            return true;
         }
     }
+    return false;
+}
+
+// The helpers below fill either a std::vector<Move> or a MoveList
+template <typename MoveContainer>
+void addPromotionMoves(int sourceSquare, int targetSquare, bool isCapture, MoveContainer& moves) {
+    moves.emplace_back(Move(sourceSquare, targetSquare, PieceType::Queen, isCapture, false, false, true));
+    moves.emplace_back(Move(sourceSquare, targetSquare, PieceType::Rook, isCapture, false, false, true));
+    moves.emplace_back(Move(sourceSquare, targetSquare, PieceType::Bishop, isCapture, false, false, true));
+    moves.emplace_back(Move(sourceSquare, targetSquare, PieceType::Knight, isCapture, false, false, true));
 }
 
-void addKnightMovesToVector(uint64_t knights, uint64_t movesBitboard, std::vector<Move>& moves) {
+// Adds the pushes in movesBitboard; targets on the promotion rank expand into one move per promotion piece
+template <PieceColor Us, typename MoveContainer>
+void addPawnMovesToVector(uint64_t pawns, uint64_t movesBitboard, MoveContainer& moves) {
+    using Traits = MoveGeneration::ColorTraits<Us>;
+
     while (movesBitboard) {
+        // Extract the target square from the bitboard
         int targetSquare = firstSetBit(movesBitboard);
+        uint64_t targetBit = movesBitboard & -movesBitboard;
         movesBitboard &= movesBitboard - 1;
 
-        for (int sourceSquare = 0; sourceSquare < 64; ++sourceSquare) {
-            if (knights & (1ULL << sourceSquare)) {
-                if (MoveGeneration::knightAttacks[sourceSquare] & (1ULL << targetSquare)) {
-                    moves.emplace_back(Move(sourceSquare, targetSquare));
-                }
-            }
+        // If no pawn is one step back this is a double push
+        int sourceSquare = targetSquare - Traits::Up;
+        bool isDoublePush = !(pawns & (1ULL << sourceSquare));
+        if (isDoublePush) {
+            sourceSquare -= Traits::Up;
+        }
+
+        if (targetBit & Traits::PromotionRank) {
+            addPromotionMoves(sourceSquare, targetSquare, false, moves);
+        } else {
+            moves.emplace_back(Move(sourceSquare, targetSquare, 0, false, false, false, false, isDoublePush));
         }
     }
 }
 
-void addSlidingPieceMovesToVector(uint64_t pieces, uint64_t movesBitboard, std::vector<Move>& moves) {
-    while (movesBitboard) {
-        int targetSquare = firstSetBit(movesBitboard);
-        movesBitboard &= movesBitboard - 1;
+// Adds the captures in capturesBitboard; the per-diagonal target sets give each capture's source directly
+template <PieceColor Us, typename MoveContainer>
+void addPawnCapturesToVector(uint64_t pawns, uint64_t capturesBitboard, uint64_t enPassantSquare, MoveContainer& moves) {
+    using Traits = MoveGeneration::ColorTraits<Us>;
+    using MoveGeneration::shift;
+
+    uint64_t towardsA = shift<Traits::UpLeft>(pawns & MoveGeneration::NotFileA);
+    uint64_t towardsH = shift<Traits::UpRight>(pawns & MoveGeneration::NotFileH);
+
+    while (capturesBitboard) {
+        int targetSquare = firstSetBit(capturesBitboard);
+        uint64_t targetBit = capturesBitboard & -capturesBitboard;
+        capturesBitboard &= capturesBitboard - 1;
+
+        bool isEnPassant = (enPassantSquare & targetBit) != 0;
+        bool isPromotion = (targetBit & Traits::PromotionRank) != 0;
 
-        for (int sourceSquare = 0; sourceSquare < 64; ++sourceSquare) {
-            if (pieces & (1ULL << sourceSquare)) {
-                moves.emplace_back(Move(sourceSquare, targetSquare));
+        for (int direction : {Traits::UpLeft, Traits::UpRight}) {
+            if (!(targetBit & (direction == Traits::UpLeft ? towardsA : towardsH))) {
+                continue;
+            }
+            int sourceSquare = targetSquare - direction;
+            if (isPromotion) {
+                addPromotionMoves(sourceSquare, targetSquare, true, moves);
+            } else {
+                moves.emplace_back(Move(sourceSquare, targetSquare, 0, true, isEnPassant));
             }
         }
     }
 }
 
-void addKingMovesToVector(uint64_t king, uint64_t movesBitboard, std::vector<Move>& moves) {
-    while (movesBitboard) {
-        int targetSquare = firstSetBit(movesBitboard);
-        movesBitboard &= movesBitboard - 1;
-
-        for (int sourceSquare = 0; sourceSquare < 64; ++sourceSquare) {
-            if (king & (1ULL << sourceSquare)) {
-                moves.emplace_back(Move(sourceSquare, targetSquare));
-            }
+// Adds one move per (source, target) pair, where the targets of each source come from attacksFromSquare
+template <typename AttacksFromSquare, typename MoveContainer>
+void addPieceMovesToVector(uint64_t pieces, uint64_t movesBitboard, uint64_t opponentPieces,
+                           AttacksFromSquare attacksFromSquare, MoveContainer& moves) {
+    while (pieces) {
+        int sourceSquare = firstSetBit(pieces);
+        pieces &= pieces - 1;
+
+        uint64_t targets = attacksFromSquare(sourceSquare) & movesBitboard;
+        while (targets) {
+            int targetSquare = firstSetBit(targets);
+            targets &= targets - 1;
+            moves.emplace_back(Move(sourceSquare, targetSquare, 0, (opponentPieces & (1ULL << targetSquare)) != 0));
         }
     }
 }
 
+template <typename MoveContainer>
+void addKnightMovesToVector(uint64_t knights, uint64_t movesBitboard, uint64_t opponentPieces, MoveContainer& moves) {
+    addPieceMovesToVector(knights, movesBitboard, opponentPieces,
+                          [](int square) { return MoveGeneration::knightAttacks[square]; }, moves);
+}
+
+template <typename MoveContainer>
+void addSlidingPieceMovesToVector(uint64_t pieces, uint64_t movesBitboard, uint64_t opponentPieces, uint64_t occupied,
+                                  uint64_t (*attacksFromSquare)(int, uint64_t), MoveContainer& moves) {
+    addPieceMovesToVector(pieces, movesBitboard, opponentPieces,
+                          [&](int square) { return attacksFromSquare(square, occupied); }, moves);
+}
+
+template <typename MoveContainer>
+void addKingMovesToVector(uint64_t king, uint64_t movesBitboard, uint64_t opponentPieces, MoveContainer& moves) {
+    addPieceMovesToVector(king, movesBitboard, opponentPieces,
+                          [](int square) { return MoveGeneration::generateKingMovesFromSquare(square, 0ULL); }, moves);
+}
+
 
 
 std::vector<Move> Board::generateMoves(bool isWhite) const {
     std::vector<Move> moves;
+    moves.reserve(64);
+    if (isWhite) {
+        generateMoves<White>(moves);
+    } else {
+        generateMoves<Black>(moves);
+    }
+    return moves;
+}
 
-    uint64_t pawns = isWhite ? getWhitePawns() : getBlackPawns();
-    uint64_t knights = isWhite ? getWhiteKnights() : getBlackKnights();
-    uint64_t bishops = isWhite ? getWhiteBishops() : getBlackBishops();
-    uint64_t rooks = isWhite ? getWhiteRooks() : getBlackRooks();
-    uint64_t queens = isWhite ? getWhiteQueens() : getBlackQueens();
-    uint64_t king = isWhite ? getWhiteKing() : getBlackKing();
-    uint64_t ownPieces = isWhite ? getWhitePieces() : getBlackPieces();
-    uint64_t opponentPieces = isWhite ? getBlackPieces() : getWhitePieces();
-    uint64_t emptySquares = ~getOccupiedSquares();
+void Board::generateMoves(bool isWhite, MoveList& moves) const {
+    moves.clear();
+    if (isWhite) {
+        generateMoves<White>(moves);
+    } else {
+        generateMoves<Black>(moves);
+    }
+}
+
+template <PieceColor Us, typename MoveContainer>
+void Board::generateMoves(MoveContainer& moves) const {
+    constexpr PieceColor Them = MoveGeneration::ColorTraits<Us>::Them;
+    constexpr bool isWhite = MoveGeneration::ColorTraits<Us>::IsWhite;
+
+    STATS_INC(MoveGenCalls);
+
+    uint64_t pawns = getPieces<Us>(Pawn);
+    uint64_t knights = getPieces<Us>(Knight);
+    uint64_t bishops = getPieces<Us>(Bishop);
+    uint64_t rooks = getPieces<Us>(Rook);
+    uint64_t queens = getPieces<Us>(Queen);
+    uint64_t king = getPieces<Us>(King);
+    uint64_t ownPieces = getColorPieces<Us>();
+    uint64_t opponentPieces = getColorPieces<Them>();
+    uint64_t occupiedSquares = occupied;
+    uint64_t emptySquares = ~occupiedSquares;
     uint64_t enPassantSquare = getEnPassantSquare();
 
     uint64_t movesBitboard, capturesBitboard;
 
     // Debugging to confirm pawn bitboard correctness
-    if (!isWhite) {
-        std::cout << "Black Pawns Bitboard:\n";
-        displayBitboard(pawns);
-    } else {
-        std::cout << "White Pawns Bitboard:\n";
-        displayBitboard(pawns);
-    }
+    ENGINE_TRACE(TRACE_BITBOARDS,
+        std::cout << (isWhite ? "White Pawns Bitboard:\n" : "Black Pawns Bitboard:\n");
+        displayBitboard(pawns));
 
-    // Generate pawn moves
-    int pawnDirection = isWhite ? 8 : -8;
-    int pawnLeftCaptureDirection = isWhite ? 7 : -9;
-    int pawnRightCaptureDirection = isWhite ? 9 : -7;
     // Generate moves and captures for pawns
-    MoveGeneration::generatePawnMoves(pawns, emptySquares, opponentPieces, enPassantSquare, movesBitboard, capturesBitboard, isWhite);
-    addPawnMovesToVector(pawns, movesBitboard, pawnDirection, moves);
-    addPawnCapturesToVector(pawns, capturesBitboard, pawnLeftCaptureDirection, pawnRightCaptureDirection, moves);
+    MoveGeneration::generatePawnMoves<Us>(pawns, emptySquares, opponentPieces, enPassantSquare, movesBitboard, capturesBitboard);
+    addPawnMovesToVector<Us>(pawns, movesBitboard, moves);
+    addPawnCapturesToVector<Us>(pawns, capturesBitboard, enPassantSquare, moves);
 
     // Debugging to confirm generated pawn moves
-    std::cout << (isWhite ? "White Pawn Moves:\n" : "Black Pawn Moves:\n");
-    displayBitboard(movesBitboard);
-    std::cout << (isWhite ? "White Pawn Captures:\n" : "Black Pawn Captures:\n");
-    displayBitboard(capturesBitboard);
+    ENGINE_TRACE(TRACE_BITBOARDS,
+        std::cout << (isWhite ? "White Pawn Moves:\n" : "Black Pawn Moves:\n");
+        displayBitboard(movesBitboard);
+        std::cout << (isWhite ? "White Pawn Captures:\n" : "Black Pawn Captures:\n");
+        displayBitboard(capturesBitboard));
 
     // Generate knight moves
     MoveGeneration::generateKnightMoves(knights, ownPieces, opponentPieces, movesBitboard, capturesBitboard);
-    addKnightMovesToVector(knights, movesBitboard, moves);
+    addKnightMovesToVector(knights, movesBitboard | capturesBitboard, opponentPieces, moves);
 
     // Generate bishop moves
-    MoveGeneration::generateBishopMoves(bishops, ownPieces, opponentPieces, getOccupiedSquares(), movesBitboard, capturesBitboard);
-    addSlidingPieceMovesToVector(bishops, movesBitboard, moves);
+    MoveGeneration::generateBishopMoves(bishops, ownPieces, opponentPieces, occupiedSquares, movesBitboard, capturesBitboard);
+    addSlidingPieceMovesToVector(bishops, movesBitboard | capturesBitboard, opponentPieces, occupiedSquares,
+                                 MoveGeneration::generateBishopMovesFromSquare, moves);
 
     // Generate rook moves
-    MoveGeneration::generateRookMoves(rooks, ownPieces, opponentPieces, getOccupiedSquares(), movesBitboard, capturesBitboard);
-    addSlidingPieceMovesToVector(rooks, movesBitboard, moves);
+    MoveGeneration::generateRookMoves(rooks, ownPieces, opponentPieces, occupiedSquares, movesBitboard, capturesBitboard);
+    addSlidingPieceMovesToVector(rooks, movesBitboard | capturesBitboard, opponentPieces, occupiedSquares,
+                                 MoveGeneration::generateRookMovesFromSquare, moves);
 
     // Generate queen moves
-    MoveGeneration::generateQueenMoves(queens, ownPieces, opponentPieces, getOccupiedSquares(), movesBitboard, capturesBitboard);
-    addSlidingPieceMovesToVector(queens, movesBitboard, moves);
+    MoveGeneration::generateQueenMoves(queens, ownPieces, opponentPieces, occupiedSquares, movesBitboard, capturesBitboard);
+    addSlidingPieceMovesToVector(queens, movesBitboard | capturesBitboard, opponentPieces, occupiedSquares,
+                                 MoveGeneration::generateQueenMovesFromSquare, moves);
+
+    // Generate king moves, including castling
+    MoveGeneration::generateKingMoves(king, ownPieces, opponentPieces, occupiedSquares, movesBitboard, capturesBitboard);
+    addKingMovesToVector(king, movesBitboard | capturesBitboard, opponentPieces, moves);
+    MoveGeneration::generateCastlingMoves<Us>(*this, moves);
+
+    // Record the state undoMove needs to restore
+    int previousEnPassantSquare = enPassantSquare ? firstSetBit(enPassantSquare) : -1;
+    for (Move& move : moves) {
+        move.previousEnPassantSquare = previousEnPassantSquare;
+        move.previousCastlingRights = castlingRights;
+        move.previousHalfmoveClock = halfmoveClock;
+        if (move.isCapture) {
+            move.capturedPiece = move.isEnPassant ? Pawn : getPieceAt(move.targetSquare, !isWhite);
+        }
+    }
+}
 
-    // Generate king moves
-    MoveGeneration::generateKingMoves(king, ownPieces, opponentPieces, getOccupiedSquares(), movesBitboard, capturesBitboard);
-    addKingMovesToVector(king, movesBitboard, moves);
 
-    return moves;
+// Single-move validation. Each check mirrors what generateMoves and isMoveLegal do for the
+// piece on the source square, using the attack maps and line tables instead of generating
+// the other moves or playing this one.
+bool Board::isPseudoLegal(uint16_t move) const {
+    return whiteToMove ? isPseudoLegal<White>(move) : isPseudoLegal<Black>(move);
 }
 
+bool Board::isLegal(uint16_t move) const {
+    return whiteToMove ? isLegal<White>(move) : isLegal<Black>(move);
+}
 
-uint64_t Board::generateOpponentAttacks(bool isWhite) const {
-    uint64_t attacks = 0ULL;
+template <PieceColor Us>
+bool Board::isPseudoLegal(uint16_t move) const {
+    using Traits = MoveGeneration::ColorTraits<Us>;
+    constexpr PieceColor Them = Traits::Them;
+    int from = move & 63, to = (move >> 6) & 63, promotion = move >> 12;
+    uint64_t fromBit = 1ULL << from, toBit = 1ULL << to;
+    if (!(colors[Us] & fromBit) || (colors[Us] & toBit)) {
+        return false;
+    }
 
-    // Opponent pieces
-    uint64_t opponentPawns = isWhite ? black_pawns : white_pawns;
-    uint64_t opponentKnights = isWhite ? black_knights : white_knights;
-    uint64_t opponentBishops = isWhite ? black_bishops : white_bishops;
-    uint64_t opponentRooks = isWhite ? black_rooks : white_rooks;
-    uint64_t opponentQueens = isWhite ? black_queens : white_queens;
-    uint64_t opponentKing = isWhite ? black_king : white_king;
+    int piece = getPieceAt(from, Traits::IsWhite);
+    bool promotes = piece == Pawn && (toBit & Traits::PromotionRank);
+    if (promotes ? (promotion < Knight || promotion > Queen) : promotion != 0) {
+        return false;
+    }
 
-    // Pawn attacks
-    if (isWhite) {
-        attacks |= ((opponentPawns & 0xFEFEFEFEFEFEFEFEULL) << 7); // Right capture
-        attacks |= ((opponentPawns & 0x7F7F7F7F7F7F7F7FULL) << 9); // Left capture
-    } else {
-        attacks |= ((opponentPawns & 0xFEFEFEFEFEFEFEFEULL) >> 9); // Right capture
-        attacks |= ((opponentPawns & 0x7F7F7F7F7F7F7F7FULL) >> 7); // Left capture
+    switch (piece) {
+    case Pawn:
+        if (toBit & (colors[Them] | enPassantSquare)) {
+            return (MoveGeneration::pawnAttacks<Us>(fromBit) & toBit) != 0;
+        }
+        if (to == from + Traits::Up) {
+            return !(occupied & toBit);
+        }
+        return to == from + 2 * Traits::Up && (MoveGeneration::shift<Traits::Up>(fromBit) & Traits::SinglePushRank)
+               && !(occupied & (toBit | MoveGeneration::shift<Traits::Up>(fromBit)));
+    case Knight:
+        return (MoveGeneration::knightAttacks[from] & toBit) != 0;
+    case Bishop:
+    case Rook:
+    case Queen: {
+        bool diagonal = from / 8 != to / 8 && from % 8 != to % 8;
+        bool moves = diagonal ? piece != Rook : piece != Bishop;
+        return moves && (Attacks::line(from, to) & toBit) && !(Attacks::between(from, to) & occupied);
+    }
+    case King: {
+        if (Attacks::kingAttacks(fromBit) & toBit) {
+            return true;
+        }
+        // Castling, under the conditions generateCastlingMoves applies
+        constexpr int RankShift = Traits::IsWhite ? 0 : 56;
+        constexpr int KingSide = Traits::IsWhite ? WhiteKingSide : BlackKingSide;
+        constexpr int QueenSide = Traits::IsWhite ? WhiteQueenSide : BlackQueenSide;
+        if (from != Traits::KingStart) {
+            return false;
+        }
+        if (to == from + 2) {
+            return (castlingRights & KingSide) && !(occupied & (0x60ULL << RankShift))
+                   && !(attacked[Them] & (0x70ULL << RankShift));
+        }
+        if (to == from - 2) {
+            return (castlingRights & QueenSide) && !(occupied & (0xEULL << RankShift))
+                   && !(attacked[Them] & (0x1CULL << RankShift));
+        }
+        return false;
     }
+    }
+    return false;
+}
 
-    // Knight attacks
-    for (int square = 0; square < 64; ++square) {
-        if (opponentKnights & (1ULL << square)) {
-            attacks |= MoveGeneration::knightAttacks[square];
+template <PieceColor Us>
+bool Board::isLegal(uint16_t move) const {
+    constexpr PieceColor Them = MoveGeneration::ColorTraits<Us>::Them;
+    if (!isPseudoLegal<Us>(move)) {
+        return false;
+    }
+    uint64_t king = pieces[Us][King - Pawn];
+    if (!king) {
+        return true;  // Nothing to leave in check, as for isMoveLegal
+    }
+
+    int from = move & 63, to = (move >> 6) & 63;
+    uint64_t fromBit = 1ULL << from, toBit = 1ULL << to;
+    int kingSquare = __builtin_ctzll(king);
+    uint64_t theirDiagonal = pieces[Them][Bishop - Pawn] | pieces[Them][Queen - Pawn];
+    uint64_t theirStraight = pieces[Them][Rook - Pawn] | pieces[Them][Queen - Pawn];
+
+    if (from == kingSquare) {
+        if (to == from + 2 || to == from - 2) {
+            return true;  // Castling was checked against the attacks in full above
         }
+        if (attacked[Them] & toBit) {
+            return false;
+        }
+        // The maps stop a slider's ray at the king, so while one reaches it the squares
+        // beyond the king on that ray are attacked without showing
+        if (!(attacked[Them] & king)) {
+            return true;
+        }
+        uint64_t after = occupied ^ fromBit;
+        return !((Attacks::sliderAttacks(toBit, 0ULL, after) & theirDiagonal)
+                 | (Attacks::sliderAttacks(0ULL, toBit, after) & theirStraight));
     }
 
-    // Bishop and queen diagonal attacks
-    for (int square = 0; square < 64; ++square) {
-        if ((opponentBishops | opponentQueens) & (1ULL << square)) {
-            attacks |= MoveGeneration::generateBishopMovesFromSquare(square, getOccupiedSquares());
+    if ((enPassantSquare & toBit) && getPieceAt(from, MoveGeneration::ColorTraits<Us>::IsWhite) == Pawn) {
+        return MoveGeneration::isMoveLegal<Us>(*this, decodeMove(move));  // Two pieces leave the rank
+    }
+
+    // In check: a single checker must be captured or blocked
+    if (attacked[Them] & king) {
+        uint64_t checkers = (MoveGeneration::knightAttacks[kingSquare] & pieces[Them][Knight - Pawn])
+                          | (MoveGeneration::pawnAttacks<Us>(king) & pieces[Them][Pawn - Pawn])
+                          | (Attacks::sliderAttacks(king, 0ULL, occupied) & theirDiagonal)
+                          | (Attacks::sliderAttacks(0ULL, king, occupied) & theirStraight);
+        if (checkers & (checkers - 1)) {
+            return false;
+        }
+        if (!(toBit & (checkers | Attacks::between(kingSquare, __builtin_ctzll(checkers))))) {
+            return false;
         }
     }
 
-    // Rook and queen straight attacks
-    for (int square = 0; square < 64; ++square) {
-        if ((opponentRooks | opponentQueens) & (1ULL << square)) {
-            attacks |= MoveGeneration::generateRookMovesFromSquare(square, getOccupiedSquares());
+    // A piece pinned to the king may only move along the pin
+    uint64_t line = Attacks::line(kingSquare, from);
+    if (!line || (line & toBit)) {
+        return true;
+    }
+    uint64_t after = occupied ^ fromBit;
+    bool diagonal = from / 8 != kingSquare / 8 && from % 8 != kingSquare % 8;
+    uint64_t pinners = diagonal ? Attacks::sliderAttacks(king, 0ULL, after) & theirDiagonal
+                                : Attacks::sliderAttacks(0ULL, king, after) & theirStraight;
+    return !(pinners & line);
+}
+
+template bool Board::isPseudoLegal<White>(uint16_t) const;
+template bool Board::isPseudoLegal<Black>(uint16_t) const;
+template bool Board::isLegal<White>(uint16_t) const;
+template bool Board::isLegal<Black>(uint16_t) const;
+
+Move Board::decodeMove(uint16_t move) const {
+    bool isWhite = whiteToMove;
+    int from = move & 63, to = (move >> 6) & 63, promotion = move >> 12;
+    int piece = getPieceAt(from, isWhite);
+    bool enPassant = piece == Pawn && (enPassantSquare & (1ULL << to));
+    bool castling = piece == King && (to == from + 2 || to == from - 2);
+    int captured = enPassant ? Pawn : getPieceAt(to, !isWhite);
+
+    Move result(from, to, castling ? King : promotion, captured != 0, enPassant, castling, promotion != 0,
+                piece == Pawn && (to == from + 16 || to == from - 16));
+    result.previousEnPassantSquare = enPassantSquare ? firstSetBit(enPassantSquare) : -1;
+    result.previousCastlingRights = castlingRights;
+    result.previousHalfmoveClock = halfmoveClock;
+    result.capturedPiece = captured;
+    return result;
+}
+
+// The check squares are the enemy king's own attacks as each piece type; the discovered
+// checkers are found from our sliders that would see the king through one of our pieces
+CheckInfo Board::checkInfo() const {
+    PieceColor us = whiteToMove ? White : Black;
+    PieceColor them = whiteToMove ? Black : White;
+    CheckInfo info{};
+    uint64_t king = pieces[them][King - Pawn];
+    info.enemyKing = king ? __builtin_ctzll(king) : -1;
+    if (!king) {
+        return info;
+    }
+
+    uint64_t diagonal = Attacks::sliderAttacks(king, 0ULL, occupied);
+    uint64_t straight = Attacks::sliderAttacks(0ULL, king, occupied);
+    info.checkSquares[Pawn] = us == White ? MoveGeneration::pawnAttacks<Black>(king) : MoveGeneration::pawnAttacks<White>(king);
+    info.checkSquares[Knight] = MoveGeneration::knightAttacks[info.enemyKing];
+    info.checkSquares[Bishop] = diagonal;
+    info.checkSquares[Rook] = straight;
+    info.checkSquares[Queen] = diagonal | straight;
+
+    uint64_t ourDiagonal = pieces[us][Bishop - Pawn] | pieces[us][Queen - Pawn];
+    uint64_t ourStraight = pieces[us][Rook - Pawn] | pieces[us][Queen - Pawn];
+    uint64_t snipers = (Attacks::sliderAttacks(king, 0ULL, 0ULL) & ourDiagonal)
+                     | (Attacks::sliderAttacks(0ULL, king, 0ULL) & ourStraight);
+    while (snipers) {
+        int sniper = __builtin_ctzll(snipers);
+        snipers &= snipers - 1;
+        uint64_t blockers = Attacks::between(info.enemyKing, sniper) & occupied;
+        if (blockers && !(blockers & (blockers - 1)) && (blockers & colors[us])) {
+            info.discoveredCheckers |= blockers;
         }
     }
+    return info;
+}
 
-    // King attacks
-    for (int square = 0; square < 64; ++square) {
-        if (opponentKing & (1ULL << square)) {
-            attacks |= MoveGeneration::generateKingMovesFromSquare(square, getOccupiedSquares());
+bool Board::givesCheck(const Move& move, const CheckInfo& info) const {
+    if (info.enemyKing < 0) {
+        return false;
+    }
+    int from = move.sourceSquare, to = move.targetSquare;
+    uint64_t fromBit = 1ULL << from, toBit = 1ULL << to;
+    uint64_t king = 1ULL << info.enemyKing;
+
+    // Direct check by the moving piece, and discovered check by leaving a slider's line
+    if (!move.isPromotion && (info.checkSquares[getPieceAt(from, whiteToMove)] & toBit)) {
+        return true;
+    }
+    if ((info.discoveredCheckers & fromBit) && !(Attacks::line(from, info.enemyKing) & toBit)) {
+        return true;
+    }
+
+    // A promoted piece sees through the square its pawn left
+    if (move.isPromotion) {
+        uint64_t after = occupied ^ fromBit;
+        switch (move.promotionPiece) {
+        case Knight:
+            return (MoveGeneration::knightAttacks[to] & king) != 0;
+        case Bishop:
+            return (Attacks::sliderAttacks(toBit, 0ULL, after) & king) != 0;
+        case Rook:
+            return (Attacks::sliderAttacks(0ULL, toBit, after) & king) != 0;
+        default:
+            return (Attacks::sliderAttacks(toBit, toBit, after) & king) != 0;
         }
     }
 
-    return attacks;
+    // En passant also clears the captured pawn's square, which may open a line
+    PieceColor us = whiteToMove ? White : Black;
+    if (move.isEnPassant) {
+        uint64_t captured = 1ULL << (whiteToMove ? to - 8 : to + 8);
+        uint64_t after = (occupied ^ fromBit ^ captured) | toBit;
+        return ((Attacks::sliderAttacks(king, 0ULL, after) & (pieces[us][Bishop - Pawn] | pieces[us][Queen - Pawn]))
+              | (Attacks::sliderAttacks(0ULL, king, after) & (pieces[us][Rook - Pawn] | pieces[us][Queen - Pawn]))) != 0;
+    }
+
+    // Castling checks with the rook, from beside the king's target square
+    if (move.isCastling) {
+        uint64_t rookFrom = 1ULL << (to > from ? from + 3 : from - 4);
+        uint64_t rookTo = 1ULL << (to > from ? to - 1 : to + 1);
+        uint64_t after = (occupied ^ fromBit ^ rookFrom) | toBit | rookTo;
+        return (Attacks::sliderAttacks(0ULL, rookTo, after) & king) != 0;
+    }
+    return false;
 }
 
 
+// Attacks of the side opposing isWhite
+uint64_t Board::generateOpponentAttacks(bool isWhite) const {
+    return isWhite ? generateOpponentAttacks<White>() : generateOpponentAttacks<Black>();
+}
+
+// Attacks of the side opposing Us, read from the incrementally maintained map
+template <PieceColor Us>
+uint64_t Board::generateOpponentAttacks() const {
+    return attacked[MoveGeneration::ColorTraits<Us>::Them];
+}
 
+template uint64_t Board::generateOpponentAttacks<White>() const;
+template uint64_t Board::generateOpponentAttacks<Black>() const;
@@ -0,0 +1,272 @@
+#include "chess_core.h"
+#include "board.h"
+#include "key_history.h"
+#include "move_generation.h"
+#include "search.h"
+#include "transposition_table.h"
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Everything a handle touches during a call lives here, so handles share nothing mutable
+struct chess_engine {
+    explicit chess_engine(size_t megabytes) : table(megabytes), searcher(table), callback(nullptr), userData(nullptr) {
+        board.initializePosition();
+        board.setKeyHistory(&history);
+        pv.reserve(Search::MaxPly + 1);
+    }
+
+    TranspositionTable table;
+    Search::Searcher searcher;
+    KeyHistory history;
+    Board board;
+
+    // The callback of the running search and the buffer its pv is copied into
+    chess_info_callback callback;
+    void* userData;
+    std::vector<chess_move> pv;
+};
+
+namespace {
+    constexpr size_t DefaultHashMegabytes = 16;
+
+    // Legal moves of the side to move, without allocating
+    void legalMoves(const Board& board, MoveList& legal) {
+        bool isWhite = board.isWhiteToMove();
+        MoveList moves;
+        board.generateMoves(isWhite, moves);
+        legal.clear();
+        for (const Move& move : moves) {
+            if (MoveGeneration::isMoveLegal(board, move, isWhite)) {
+                legal.push_back(move);
+            }
+        }
+    }
+
+    // Checked on its own, without generating the other moves
+    bool findMove(const Board& board, chess_move packed, Move& result) {
+        if (!board.isLegal(packed)) {
+            return false;
+        }
+        result = board.decodeMove(packed);
+        return true;
+    }
+
+    bool findMove(const Board& board, const std::string& name, Move& result) {
+        chess_move packed = parseMove(name);
+        return packed != 0 && findMove(board, packed, result);
+    }
+
+    // Centipawns and moves to mate, as UCI splits a score
+    void splitScore(int score, int& centipawns, int& mate) {
+        if (std::abs(score) >= Search::MateBound) {
+            int movesToMate = (Search::MateScore - std::abs(score) + 1) / 2;
+            centipawns = 0;
+            mate = score > 0 ? movesToMate : -movesToMate;
+        } else {
+            centipawns = score;
+            mate = 0;
+        }
+    }
+
+    Search::Limits toSearchLimits(const chess_limits& limits) {
+        Search::Limits result;
+        if (limits.depth > 0) {
+            result.depth = limits.depth < Search::MaxPly - 1 ? limits.depth : Search::MaxPly - 1;
+        }
+        result.nodes = limits.nodes;
+        result.moveTime = limits.movetime_ms > 0 ? limits.movetime_ms : 0;
+        for (int side = White; side <= Black; ++side) {
+            result.time[side] = limits.time_ms[side] > 0 ? limits.time_ms[side] : 0;
+            result.increment[side] = limits.increment_ms[side] > 0 ? limits.increment_ms[side] : 0;
+        }
+        result.movesToGo = limits.moves_to_go > 0 ? limits.moves_to_go : 0;
+        result.multiPV = limits.multipv > 1 ? (limits.multipv < 256 ? limits.multipv : 256) : 1;
+        return result;
+    }
+
+    void report(chess_engine& engine, const Search::Info& info) {
+        chess_search_info out;
+        out.depth = info.depth;
+        out.seldepth = info.selDepth;
+        out.multipv = info.multiPV;
+        splitScore(info.score, out.score_cp, out.mate);
+        out.nodes = info.nodes;
+        out.time_ms = info.timeMs;
+        out.hashfull = info.hashfull;
+        engine.pv.clear();
+        for (const Move& move : info.pv) {
+            engine.pv.push_back(move.pack());
+        }
+        out.pv = engine.pv.data();
+        out.pv_length = static_cast<int>(engine.pv.size());
+        if (engine.callback(&out, engine.userData) != 0) {
+            engine.searcher.stop();
+        }
+    }
+}
+
+extern "C" {
+
+int chess_core_api_version(void) {
+    return CHESS_CORE_API_VERSION;
+}
+
+chess_engine* chess_engine_create(size_t hash_megabytes) {
+    try {
+        return new chess_engine(hash_megabytes > 0 ? hash_megabytes : DefaultHashMegabytes);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void chess_engine_destroy(chess_engine* engine) {
+    delete engine;
+}
+
+void chess_engine_clear(chess_engine* engine) {
+    if (!engine) {
+        return;
+    }
+    if (!engine->table.isMapped()) {
+        engine->table.clear();
+    }
+    engine->searcher.clear();
+}
+
+chess_status chess_engine_set_position(chess_engine* engine, const char* fen, const char* moves) {
+    if (!engine) {
+        return CHESS_INVALID_ARGUMENT;
+    }
+    try {
+        // Built aside and swapped in, so a bad FEN or move leaves the handle untouched
+        KeyHistory history;
+        Board board;
+        board.setKeyHistory(&history);
+        if (!fen) {
+            board.initializePosition();
+        } else if (!board.loadFen(fen)) {
+            return CHESS_INVALID_FEN;
+        }
+
+        std::istringstream input(moves ? moves : "");
+        for (std::string name; input >> name;) {
+            Move move(0, 0);
+            if (!findMove(board, name, move)) {
+                return CHESS_ILLEGAL_MOVE;
+            }
+            board.makeMove(move);
+        }
+
+        engine->history = std::move(history);
+        engine->board = board;
+        engine->board.setKeyHistory(&engine->history);
+        return CHESS_OK;
+    } catch (const std::bad_alloc&) {
+        return CHESS_OUT_OF_MEMORY;
+    } catch (...) {
+        return CHESS_INTERNAL_ERROR;
+    }
+}
+
+chess_status chess_engine_make_move(chess_engine* engine, chess_move move) {
+    if (!engine) {
+        return CHESS_INVALID_ARGUMENT;
+    }
+    Move found(0, 0);
+    if (!findMove(engine->board, move, found)) {
+        return CHESS_ILLEGAL_MOVE;
+    }
+    try {
+        engine->board.makeMove(found);
+        return CHESS_OK;
+    } catch (...) {
+        return CHESS_OUT_OF_MEMORY;  // The history could not grow
+    }
+}
+
+int chess_engine_white_to_move(const chess_engine* engine) {
+    return engine && engine->board.isWhiteToMove() ? 1 : 0;
+}
+
+int chess_engine_legal_moves(const chess_engine* engine, chess_move* moves, size_t capacity) {
+    if (!engine || (!moves && capacity > 0)) {
+        return CHESS_INVALID_ARGUMENT;
+    }
+    MoveList legal;
+    legalMoves(engine->board, legal);
+    if (static_cast<size_t>(legal.size()) > capacity) {
+        return CHESS_BUFFER_TOO_SMALL;
+    }
+    for (int i = 0; i < legal.size(); ++i) {
+        moves[i] = legal[i].pack();
+    }
+    return legal.size();
+}
+
+int chess_move_to_string(chess_move move, char* buffer, size_t size) {
+    if (!buffer || size < CHESS_MOVE_STRING_SIZE) {
+        return CHESS_INVALID_ARGUMENT;
+    }
+    int promotion = move >> 12;
+    if (move == 0 || (promotion != 0 && (promotion < Knight || promotion > Queen))) {
+        return CHESS_INVALID_ARGUMENT;
+    }
+    Move unpacked(move & 63, (move >> 6) & 63, promotion, false, false, false, promotion != 0);
+    std::string name = unpacked.toString();
+    std::memcpy(buffer, name.c_str(), name.size() + 1);
+    return static_cast<int>(name.size());
+}
+
+void chess_limits_init(chess_limits* limits) {
+    if (limits) {
+        std::memset(limits, 0, sizeof(*limits));
+        limits->multipv = 1;
+    }
+}
+
+chess_status chess_engine_search(chess_engine* engine, const chess_limits* limits,
+                                 chess_info_callback callback, void* user_data,
+                                 chess_search_result* result) {
+    if (!engine) {
+        return CHESS_INVALID_ARGUMENT;
+    }
+    chess_limits none;
+    chess_limits_init(&none);
+    try {
+        engine->callback = callback;
+        engine->userData = user_data;
+        std::function<void(const Search::Info&)> onIteration;
+        if (callback) {
+            onIteration = [engine](const Search::Info& info) { report(*engine, info); };
+        }
+        Search::Result found = engine->searcher.search(engine->board, toSearchLimits(limits ? *limits : none), onIteration);
+        engine->callback = nullptr;
+        engine->userData = nullptr;
+        if (result) {
+            result->best_move = found.hasMove ? found.bestMove.pack() : 0;
+            splitScore(found.score, result->score_cp, result->mate);
+            result->depth = found.depth;
+            result->nodes = found.nodes;
+        }
+        return CHESS_OK;
+    } catch (const std::bad_alloc&) {
+        engine->callback = nullptr;
+        return CHESS_OUT_OF_MEMORY;
+    } catch (...) {
+        engine->callback = nullptr;
+        return CHESS_INTERNAL_ERROR;
+    }
+}
+
+void chess_engine_stop(chess_engine* engine) {
+    if (engine) {
+        engine->searcher.stop();
+    }
+}
+
+}
@@ -0,0 +1,86 @@
+#include "cuckoo.h"
+#include "attacks.h"
+#include "move.h"
+#include "move_generation.h"
+#include "zobrist.h"
+#include <cassert>
+#include <utility>
+
+namespace Cuckoo {
+    namespace {
+        inline int hash1(uint64_t key) { return static_cast<int>(key & (Size - 1)); }
+        inline int hash2(uint64_t key) { return static_cast<int>((key >> 16) & (Size - 1)); }
+
+        struct Tables {
+            uint64_t keys[Size];
+            uint8_t from[Size];
+            uint8_t to[Size];
+            int count;
+
+            Tables() : keys{}, from{}, to{}, count(0) {
+                for (int color = White; color <= Black; ++color) {
+                    for (int piece = Knight; piece <= King; ++piece) {
+                        for (int s1 = 0; s1 < 64; ++s1) {
+                            for (int s2 = s1 + 1; s2 < 64; ++s2) {
+                                if (attacksOnEmptyBoard(piece, s1) & (1ULL << s2)) {
+                                    insert(color, piece, s1, s2);
+                                }
+                            }
+                        }
+                    }
+                }
+                assert(count == 3668);
+            }
+
+            static uint64_t attacksOnEmptyBoard(int piece, int square) {
+                switch (piece) {
+                    case Knight: return Attacks::knightAttacks(1ULL << square);
+                    case Bishop: return MoveGeneration::generateBishopMovesFromSquare(square, 0ULL);
+                    case Rook: return MoveGeneration::generateRookMovesFromSquare(square, 0ULL);
+                    case Queen: return MoveGeneration::generateQueenMovesFromSquare(square, 0ULL);
+                    default: return Attacks::kingAttacks(1ULL << square);
+                }
+            }
+
+            // Cuckoo insertion: displace the occupant to its other slot until an empty one is found
+            void insert(int color, int piece, int s1, int s2) {
+                uint64_t key = Zobrist::keys.pieces[color][piece][s1] ^ Zobrist::keys.pieces[color][piece][s2] ^ Zobrist::keys.side;
+                uint8_t a = static_cast<uint8_t>(s1), b = static_cast<uint8_t>(s2);
+                int slot = hash1(key);
+                while (true) {
+                    std::swap(keys[slot], key);
+                    std::swap(from[slot], a);
+                    std::swap(to[slot], b);
+                    if (key == 0) {
+                        break;
+                    }
+                    slot = slot == hash1(key) ? hash2(key) : hash1(key);
+                }
+                ++count;
+            }
+        };
+
+        const Tables& tables() {
+            static const Tables instance;
+            return instance;
+        }
+    }
+
+    bool lookup(uint64_t moveKey, int& from, int& to) {
+        const Tables& t = tables();
+        int slot = hash1(moveKey);
+        if (t.keys[slot] != moveKey) {
+            slot = hash2(moveKey);
+            if (t.keys[slot] != moveKey) {
+                return false;
+            }
+        }
+        from = t.from[slot];
+        to = t.to[slot];
+        return true;
+    }
+
+    int entryCount() {
+        return tables().count;
+    }
+}
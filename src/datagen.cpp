@@ -0,0 +1,285 @@
+#include "datagen.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include "harness.h"
+#include "key_history.h"
+#include "move_generation.h"
+#include "search.h"
+#include "transposition_table.h"
+
+namespace Datagen {
+    PackedPosition pack(const Board& board, int score, GameResult result) {
+        PackedPosition record;
+        std::memset(&record, 0, sizeof(record));
+        record.occupancy = board.getOccupiedSquares();
+
+        int index = 0;
+        for (uint64_t rest = record.occupancy; rest && index < 32; rest &= rest - 1, ++index) {
+            int square = __builtin_ctzll(rest);
+            bool isWhite = (board.getColorPieces(White) >> square) & 1;
+            int code = (isWhite ? White : Black) << 3 | board.getPieceAt(square, isWhite);
+            record.pieces[index / 2] |= static_cast<uint8_t>(code << (4 * (index & 1)));
+        }
+
+        record.score = static_cast<int16_t>(std::clamp(score, -32767, 32767));
+        record.result = result;
+        record.sideToMove = board.isWhiteToMove() ? White : Black;
+        record.castlingRights = static_cast<uint8_t>(board.getCastlingRights());
+        uint64_t enPassant = board.getEnPassantSquare();
+        record.enPassantSquare = static_cast<uint8_t>(enPassant ? __builtin_ctzll(enPassant) : 64);
+        record.halfmoveClock = static_cast<uint8_t>(std::min(board.getHalfmoveClock(), 255));
+        return record;
+    }
+
+    void unpack(const PackedPosition& record, Board& board) {
+        uint64_t bitboards[2][6] = {};
+        int index = 0;
+        for (uint64_t rest = record.occupancy; rest && index < 32; rest &= rest - 1, ++index) {
+            int code = (record.pieces[index / 2] >> (4 * (index & 1))) & 0xF;
+            int pieceType = code & 7;
+            if (pieceType >= Pawn && pieceType <= King) {
+                bitboards[code >> 3][pieceType - Pawn] |= rest & (0 - rest);
+            }
+        }
+        uint64_t enPassant = record.enPassantSquare < 64 ? 1ULL << record.enPassantSquare : 0ULL;
+        board.loadPosition(bitboards, record.sideToMove == White, record.castlingRights, enPassant,
+                           record.halfmoveClock);
+    }
+
+    Writer::Writer(std::FILE* file, std::mutex* fileMutex)
+        : file(file), fileMutex(fileMutex), buffer(new PackedPosition[BufferRecords]), count(0) {}
+
+    bool Writer::flush() {
+        if (count == 0) {
+            return true;
+        }
+        size_t written;
+        {
+            std::lock_guard<std::mutex> lock(*fileMutex);
+            written = std::fwrite(buffer.get(), sizeof(PackedPosition), count, file);
+        }
+        bool ok = written == count;
+        count = 0;
+        return ok;
+    }
+
+    Reader::Reader(const std::string& path)
+        : file(std::fopen(path.c_str(), "rb")), buffer(new PackedPosition[BufferRecords]), position(0), count(0) {}
+
+    Reader::~Reader() {
+        if (file) {
+            std::fclose(file);
+        }
+    }
+
+    bool Reader::refill() {
+        if (!file) {
+            return false;
+        }
+        count = std::fread(buffer.get(), sizeof(PackedPosition), BufferRecords, file);
+        position = 0;
+        return count > 0;
+    }
+
+    namespace {
+        // xorshift64*, seeded through splitmix64 so neighbouring game seeds diverge at once
+        class Random {
+        public:
+            explicit Random(uint64_t seed) {
+                seed += 0x9E3779B97F4A7C15ULL;
+                seed = (seed ^ (seed >> 30)) * 0xBF58476D1CE4E5B9ULL;
+                seed = (seed ^ (seed >> 27)) * 0x94D049BB133111EBULL;
+                state = (seed ^ (seed >> 31)) | 1;
+            }
+
+            uint64_t next() {
+                state ^= state >> 12;
+                state ^= state << 25;
+                state ^= state >> 27;
+                return state * 0x2545F4914F6CDD1DULL;
+            }
+
+        private:
+            uint64_t state;
+        };
+
+        // Per-thread state, allocated once and reused for every game the thread plays
+        struct Worker {
+            Worker(const Options& options, std::FILE* file, std::mutex* fileMutex)
+                : table(options.hashMegabytes), searcher(table), writer(file, fileMutex), summary{} {
+                pending.reserve(options.maxPlies);
+            }
+
+            TranspositionTable table;
+            Search::Searcher searcher;
+            Writer writer;
+            KeyHistory history;
+            std::vector<PackedPosition> pending;  // Records of the running game, result still open
+            Summary summary;
+        };
+
+        void playGame(Worker& worker, const Options& options, uint64_t seed) {
+            Random random(seed);
+            Board board;
+            Harness::playRandomOpening(board, worker.history, options.randomPlies, [&random]() { return random.next(); });
+
+            worker.table.clear();
+            worker.searcher.clear();
+            worker.pending.clear();
+            Search::Limits limits;
+            limits.nodes = options.nodes;
+
+            GameResult result = Draw;
+            for (int ply = 0;; ++ply) {
+                bool isWhite = board.isWhiteToMove();
+                bool inCheck = !MoveGeneration::isKingSafe(board, isWhite);
+                if (MoveGeneration::legalMoves(board).empty()) {
+                    result = !inCheck ? Draw : isWhite ? BlackWin : WhiteWin;
+                    break;
+                }
+                if (ply >= options.maxPlies || board.isRepetition() || board.isFiftyMoveDraw()
+                    || board.isInsufficientMaterial()) {
+                    break;
+                }
+
+                Search::Result searched = worker.searcher.search(board, limits);
+                // Quiet positions only: no check, no capture as best move, no mate score
+                if (!inCheck && !searched.bestMove.isCapture && std::abs(searched.score) < Search::MateBound) {
+                    worker.pending.push_back(pack(board, isWhite ? searched.score : -searched.score, Draw));
+                }
+                board.makeMove(searched.bestMove);
+            }
+
+            for (PackedPosition& record : worker.pending) {
+                record.result = result;
+                worker.writer.write(record);
+            }
+            ++worker.summary.games;
+            worker.summary.positions += worker.pending.size();
+            ++worker.summary.results[result];
+        }
+
+        int readFile(const std::string& path) {
+            Reader reader(path);
+            if (!reader.isOpen()) {
+                std::cerr << "datagen: cannot open " << path << std::endl;
+                return 1;
+            }
+
+            uint64_t records = 0, results[3] = {0, 0, 0}, pieces = 0;
+            int64_t scoreSum = 0;
+            Board board;
+            auto start = std::chrono::steady_clock::now();
+            for (const PackedPosition* record; reader.next(record);) {
+                unpack(*record, board);
+                ++records;
+                ++results[std::min<int>(record->result, WhiteWin)];
+                scoreSum += std::abs(record->score);
+                pieces += __builtin_popcountll(board.getOccupiedSquares());
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            std::cout << "records " << records
+                      << " white " << results[WhiteWin] << " draw " << results[Draw] << " black " << results[BlackWin]
+                      << std::fixed << std::setprecision(1)
+                      << " mean|score| " << (records ? static_cast<double>(scoreSum) / records : 0.0)
+                      << " pieces " << (records ? static_cast<double>(pieces) / records : 0.0)
+                      << std::setprecision(3) << " time " << seconds
+                      << std::setprecision(0) << " records/s " << (seconds > 0 ? records / seconds : 0.0) << std::endl;
+            return 0;
+        }
+    }
+
+    bool generate(const Options& options, Summary& summary) {
+        summary = Summary{};
+        std::FILE* file = std::fopen(options.output.c_str(), "ab");
+        if (!file) {
+            return false;
+        }
+
+        std::mutex fileMutex;
+        std::atomic<int> nextGame(0);
+        std::atomic<bool> failed(false);
+        std::mutex summaryMutex;
+        auto start = std::chrono::steady_clock::now();
+
+        auto work = [&]() {
+            std::unique_ptr<Worker> worker(new Worker(options, file, &fileMutex));
+            for (int game; (game = nextGame.fetch_add(1, std::memory_order_relaxed)) < options.games;) {
+                playGame(*worker, options, options.seed + static_cast<uint64_t>(game));
+            }
+            if (!worker->writer.flush()) {
+                failed = true;
+            }
+
+            std::lock_guard<std::mutex> lock(summaryMutex);
+            summary.games += worker->summary.games;
+            summary.positions += worker->summary.positions;
+            for (int result = BlackWin; result <= WhiteWin; ++result) {
+                summary.results[result] += worker->summary.results[result];
+            }
+        };
+
+        std::vector<std::thread> pool;
+        for (int i = 1; i < options.threads; ++i) {
+            pool.emplace_back(work);
+        }
+        work();
+        for (std::thread& thread : pool) {
+            thread.join();
+        }
+
+        summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        bool ok = !failed && !std::ferror(file);
+        return std::fclose(file) == 0 && ok;
+    }
+
+    int runCommand(const std::vector<std::string>& args) {
+        Options options;
+        for (size_t i = 0; i < args.size(); ++i) {
+            bool hasValue = i + 1 < args.size();
+            if (args[i] == "--read" && hasValue) {
+                return readFile(args[++i]);
+            } else if (args[i] == "--games" && hasValue) {
+                options.games = std::max(1, std::stoi(args[++i]));
+            } else if (args[i] == "--threads" && hasValue) {
+                options.threads = std::max(1, std::stoi(args[++i]));
+            } else if (args[i] == "--nodes" && hasValue) {
+                options.nodes = std::max<uint64_t>(1, std::stoull(args[++i]));
+            } else if (args[i] == "--random-plies" && hasValue) {
+                options.randomPlies = std::max(0, std::stoi(args[++i]));
+            } else if (args[i] == "--max-plies" && hasValue) {
+                options.maxPlies = std::max(1, std::stoi(args[++i]));
+            } else if (args[i] == "--hash" && hasValue) {
+                options.hashMegabytes = std::max<size_t>(1, std::stoul(args[++i]));
+            } else if (args[i] == "--seed" && hasValue) {
+                options.seed = std::stoull(args[++i]);
+            } else if (args[i] == "--out" && hasValue) {
+                options.output = args[++i];
+            } else {
+                std::cerr << "datagen: unknown option " << args[i] << std::endl;
+                return 1;
+            }
+        }
+
+        Summary summary;
+        if (!generate(options, summary)) {
+            std::cerr << "datagen: cannot write " << options.output << std::endl;
+            return 1;
+        }
+        std::cout << "games " << summary.games << " positions " << summary.positions
+                  << " white " << summary.results[WhiteWin] << " draw " << summary.results[Draw]
+                  << " black " << summary.results[BlackWin]
+                  << std::fixed << std::setprecision(3) << " time " << summary.seconds
+                  << std::setprecision(1) << " games/s " << (summary.seconds > 0 ? summary.games / summary.seconds : 0.0)
+                  << std::setprecision(0) << " positions/s "
+                  << (summary.seconds > 0 ? summary.positions / summary.seconds : 0.0) << std::endl;
+        return 0;
+    }
+}
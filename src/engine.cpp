@@ -1,6 +1,255 @@
+#include <algorithm>
 #include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
 #include "engine.h"
+#include "board.h"
+#include "mate_search.h"
+#include "move_generation.h"
+#include "search.h"
+#include "stats.h"
+#include "transposition_table.h"
 
 void startEngine() {
     std::cout << "Engine is running!" << std::endl;
 }
+
+namespace {
+    std::mutex outputMutex;
+
+    void send(const std::string& line) {
+        std::lock_guard<std::mutex> lock(outputMutex);
+        std::cout << line << std::endl;
+    }
+
+    std::string formatInfo(const Search::Info& info) {
+        std::ostringstream out;
+        out << "info depth " << info.depth << " seldepth " << info.selDepth << " multipv " << info.multiPV
+            << " score " << Search::scoreToUci(info.score)
+            << " nodes " << info.nodes
+            << " nps " << (info.timeMs > 0 ? info.nodes * 1000 / info.timeMs : info.nodes)
+            << " hashfull " << info.hashfull
+            << " time " << info.timeMs << " pv";
+        for (const Move& move : info.pv) {
+            out << " " << move.toString();
+        }
+        return out.str();
+    }
+
+    std::string formatMateInfo(const MateSearch::Result& result) {
+        std::ostringstream out;
+        out << "info depth " << result.pv.size() << " score mate " << result.mateIn << " nodes " << result.nodes
+            << " nps " << (result.timeMs > 0 ? result.nodes * 1000 / result.timeMs : result.nodes)
+            << " time " << result.timeMs << " pv";
+        for (const Move& move : result.pv) {
+            out << " " << move.toString();
+        }
+        return out.str();
+    }
+
+    // Finds the legal move with the given name (e2e4, e7e8q, or long algebraic as Ng1-f3)
+    bool findMove(const Board& board, const std::string& name, Move& result) {
+        uint16_t move = parseMove(name);
+        if (!move || !board.isLegal(move)) {
+            return false;
+        }
+        result = board.decodeMove(move);
+        return true;
+    }
+
+    // Replaces the position; the game moves are recorded in history for repetition detection
+    void setPosition(Board& board, KeyHistory& history, std::istringstream& input) {
+        history.clear();
+        board.setKeyHistory(&history);
+        std::string token;
+        input >> token;
+        if (token == "startpos") {
+            board.initializePosition();
+            input >> token;
+        } else if (token == "fen") {
+            std::string fen;
+            while (input >> token && token != "moves") {
+                fen += token + " ";
+            }
+            if (!board.loadFen(fen)) {
+                send("info string invalid fen");
+                board.initializePosition();
+            }
+        }
+
+        if (token == "moves") {
+            while (input >> token) {
+                Move move(0, 0);
+                if (!findMove(board, token, move)) {
+                    send("info string illegal move " + token);
+                    break;
+                }
+                board.makeMove(move);
+            }
+        }
+    }
+
+    Search::Limits parseLimits(std::istringstream& input) {
+        Search::Limits limits;
+        std::string token;
+        while (input >> token) {
+            if (token == "depth") input >> limits.depth;
+            else if (token == "nodes") input >> limits.nodes;
+            else if (token == "movetime") input >> limits.moveTime;
+            else if (token == "wtime") input >> limits.time[White];
+            else if (token == "btime") input >> limits.time[Black];
+            else if (token == "winc") input >> limits.increment[White];
+            else if (token == "binc") input >> limits.increment[Black];
+            else if (token == "movestogo") input >> limits.movesToGo;
+            else if (token == "infinite") limits.infinite = true;
+            else if (token == "mate") input >> limits.mate;
+        }
+        return limits;
+    }
+}
+
+void uciLoop() {
+    Board board;
+    KeyHistory gameHistory;
+    board.initializePosition();
+    board.setKeyHistory(&gameHistory);
+    TranspositionTable table(16);
+    Search::Searcher searcher(table);
+    MateSearch::Solver mateSolver(16);
+    bool mateChecksOnly = false;
+    int multiPV = 1;
+    bool largePages = true;
+    std::string hashFile;
+    std::thread searchThread;
+
+    auto waitForSearch = [&]() {
+        if (searchThread.joinable()) {
+            searchThread.join();
+        }
+    };
+
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        std::istringstream input(line);
+        std::string command;
+        input >> command;
+
+        if (command == "uci") {
+            send("id name ChessEngine");
+            send("id author DevrajK721");
+            send("option name Hash type spin default 16 min 1 max 65536");
+            send("option name MultiPV type spin default 1 min 1 max 256");
+            send("option name LargePages type check default true");
+            send("option name HashFile type string default <empty>");
+            send("option name MateChecksOnly type check default false");
+            send("uciok");
+        } else if (command == "isready") {
+            send("readyok");
+        } else if (command == "setoption") {
+            std::string token, name, value;
+            input >> token >> name >> token >> value;
+            if ((name == "Hash" || name == "LargePages" || name == "HashFile") && !value.empty()) {
+                waitForSearch();
+                largePages = name == "LargePages" ? value == "true" : largePages;
+                hashFile = name == "HashFile" ? (value == "<empty>" ? "" : value) : hashFile;
+                size_t megabytes = name == "Hash" ? std::stoul(value) : table.sizeInMegabytes();
+
+                // A valid existing file keeps its own size and entries
+                std::string error;
+                if (!hashFile.empty() && table.mapFile(hashFile, megabytes, error)) {
+                    send("info string hash " + std::to_string(table.sizeInMegabytes()) + " MB, file " + hashFile);
+                } else {
+                    if (!hashFile.empty()) {
+                        send("info string hash file " + error);
+                        hashFile.clear();
+                    }
+                    table.resize(megabytes, largePages ? LargePages::Mode::Explicit : LargePages::Mode::Normal);
+                    send("info string hash " + std::to_string(megabytes) + " MB, " + LargePages::modeName(table.pageMode()));
+                }
+            } else if (name == "MateChecksOnly" && !value.empty()) {
+                mateChecksOnly = value == "true";
+            } else if (name == "MultiPV" && !value.empty()) {
+                multiPV = std::max(1, std::min(256, std::stoi(value)));
+            }
+        } else if (command == "ucinewgame") {
+            waitForSearch();
+            // A file-backed table is kept: carrying entries over is what it is for
+            if (!table.isMapped()) {
+                table.clear();
+            }
+            searcher.clear();
+            mateSolver.clear();
+        } else if (command == "position") {
+            waitForSearch();
+            setPosition(board, gameHistory, input);
+        } else if (command == "go") {
+            waitForSearch();
+            Search::Limits limits = parseLimits(input);
+            limits.multiPV = multiPV;
+            Stats::reset();
+            if (limits.mate > 0) {
+                // Proof-number search for a mate in at most N moves; without one the first
+                // legal move is sent so the GUI still gets a move
+                MateSearch::Limits mateLimits;
+                mateLimits.mateIn = limits.mate;
+                mateLimits.nodes = limits.nodes;
+                mateLimits.moveTime = limits.moveTime;
+                mateLimits.checksOnly = mateChecksOnly;
+                searchThread = std::thread([&mateSolver, board, mateLimits]() {
+                    MateSearch::Result result = mateSolver.solve(board, mateLimits);
+                    std::string bestMove = "0000";
+                    if (result.proven && !result.pv.empty()) {
+                        send(formatMateInfo(result));
+                        bestMove = result.pv.front().toString();
+                    } else {
+                        send(std::string("info string ") + (result.disproven ? "no mate in " : "mate not proven in ")
+                             + std::to_string(mateLimits.mateIn));
+                        bool isWhite = board.isWhiteToMove();
+                        std::vector<Move> moves = MoveGeneration::filterLegalMoves(board, board.generateMoves(isWhite), isWhite);
+                        if (!moves.empty()) {
+                            bestMove = moves.front().toString();
+                        }
+                    }
+                    send("bestmove " + bestMove);
+                });
+            } else {
+                searchThread = std::thread([&searcher, board, limits]() {
+                    Search::Result result = searcher.search(board, limits, [](const Search::Info& info) {
+                        send(formatInfo(info));
+                    });
+                    if (Stats::enabled) {
+                        send(Stats::infoString(Stats::collect()));
+                    }
+                    send("bestmove " + (result.hasMove ? result.bestMove.toString() : std::string("0000")));
+                });
+            }
+        } else if (command == "stop") {
+            searcher.stop();
+            mateSolver.stop();
+            waitForSearch();
+        } else if (command == "stats") {
+            waitForSearch();
+            send(Stats::infoString(Stats::collect()));
+        } else if (command == "statsjson") {
+            waitForSearch();
+            std::ostringstream out;
+            Stats::writeJson(out, Stats::collect());
+            send(out.str());
+        } else if (command == "bench") {
+            waitForSearch();
+            std::vector<std::string> args;
+            for (std::string token; input >> token;) {
+                args.push_back(token);
+            }
+            runBench(args);
+        } else if (command == "quit") {
+            break;
+        }
+    }
+
+    searcher.stop();
+    mateSolver.stop();
+    waitForSearch();
+}
@@ -0,0 +1,206 @@
+#include "evaluate.h"
+#include "evaluate_params.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#ifdef ENGINE_AVX2
+#include <immintrin.h>
+#endif
+
+namespace Evaluation {
+    namespace {
+        using namespace Params;
+
+        const int* const TablesMg[7] = {nullptr, PawnMgPst, KnightPst, BishopPst, RookPst, QueenPst, KingMgPst};
+        const int* const TablesEg[7] = {nullptr, PawnEgPst, KnightPst, BishopPst, RookPst, QueenPst, KingEgPst};
+
+        uint64_t pieceBitboard(const Board& board, int piece, bool isWhite) {
+            switch (piece) {
+                case Pawn: return isWhite ? board.getWhitePawns() : board.getBlackPawns();
+                case Knight: return isWhite ? board.getWhiteKnights() : board.getBlackKnights();
+                case Bishop: return isWhite ? board.getWhiteBishops() : board.getBlackBishops();
+                case Rook: return isWhite ? board.getWhiteRooks() : board.getBlackRooks();
+                case Queen: return isWhite ? board.getWhiteQueens() : board.getBlackQueens();
+                default: return isWhite ? board.getWhiteKing() : board.getBlackKing();
+            }
+        }
+
+        // Batch evaluation tables: material and piece-square value folded together per
+        // (color, piece, square), signed for the side, with the middlegame part in the high
+        // 16 bits and the endgame part in the low 16 bits so one add accumulates both
+        constexpr int FeatureCount = 2 * 7 * 64;  // Entries for piece type 0 stay zero and pad the gathers
+
+        int32_t packScore(int mg, int eg) {
+            return static_cast<int32_t>(static_cast<uint32_t>(mg) << 16) + eg;
+        }
+
+        struct BatchTables {
+            alignas(64) int32_t packed[FeatureCount];
+
+            BatchTables() : packed{} {
+                for (int color = White; color <= Black; ++color) {
+                    int sign = color == White ? 1 : -1;
+                    for (int piece = Pawn; piece <= King; ++piece) {
+                        for (int square = 0; square < 64; ++square) {
+                            int index = color == White ? square ^ 56 : square;
+                            packed[(color * 7 + piece) * 64 + square] =
+                                packScore(sign * (MaterialMg[piece] + TablesMg[piece][index]),
+                                          sign * (MaterialEg[piece] + TablesEg[piece][index]));
+                        }
+                    }
+                }
+            }
+        };
+
+        const BatchTables& batchTables() {
+            static const BatchTables tables;
+            return tables;
+        }
+
+        // Up to 32 pieces per position, plus promotions in artificial positions
+        constexpr int MaxFeatures = 64;
+        constexpr size_t ChunkSize = 128 * BatchLanes;
+
+        // Feature indices of one block, one column per lane; short lanes are padded with index 0
+        struct Block {
+            alignas(32) int32_t features[MaxFeatures][BatchLanes];
+            alignas(32) int32_t phase[BatchLanes];
+            alignas(32) int32_t sign[BatchLanes];
+            int rows;
+        };
+
+        void extractFeatures(const Board* positions, size_t lanes, Block& block) {
+            block.rows = 0;
+            for (size_t lane = 0; lane < BatchLanes; ++lane) {
+                int count = 0;
+                int phase = 0;
+                if (lane < lanes) {
+                    const Board& board = positions[lane];
+                    for (int color = White; color <= Black; ++color) {
+                        for (int piece = Pawn; piece <= King; ++piece) {
+                            uint64_t pieces = board.getPieces(static_cast<PieceColor>(color), piece);
+                            phase += PhaseWeight[piece] * __builtin_popcountll(pieces);
+                            int base = (color * 7 + piece) * 64;
+                            for (; pieces && count < MaxFeatures; pieces &= pieces - 1) {
+                                block.features[count++][lane] = base + __builtin_ctzll(pieces);
+                            }
+                        }
+                    }
+                    block.sign[lane] = board.isWhiteToMove() ? 1 : -1;
+                } else {
+                    block.sign[lane] = 1;
+                }
+                block.phase[lane] = std::min(phase, MaxPhase);
+                for (int row = count; row < MaxFeatures; ++row) {
+                    block.features[row][lane] = 0;
+                }
+                block.rows = std::max(block.rows, count);
+            }
+        }
+
+#ifdef ENGINE_AVX2
+        void evaluateBlock(const Block& block, int* scores, size_t lanes) {
+            const int32_t* table = batchTables().packed;
+            __m256i accumulator = _mm256_setzero_si256();
+            for (int row = 0; row < block.rows; ++row) {
+                __m256i indices = _mm256_load_si256(reinterpret_cast<const __m256i*>(block.features[row]));
+                accumulator = _mm256_add_epi32(accumulator, _mm256_i32gather_epi32(table, indices, 4));
+            }
+
+            // Unpack: endgame is the sign-extended low half, middlegame the rounded high half
+            __m256i eg = _mm256_srai_epi32(_mm256_slli_epi32(accumulator, 16), 16);
+            __m256i mg = _mm256_srai_epi32(_mm256_add_epi32(accumulator, _mm256_set1_epi32(0x8000)), 16);
+
+            __m256i phase = _mm256_load_si256(reinterpret_cast<const __m256i*>(block.phase));
+            __m256i tapered = _mm256_add_epi32(_mm256_mullo_epi32(mg, phase),
+                                               _mm256_mullo_epi32(eg, _mm256_sub_epi32(_mm256_set1_epi32(MaxPhase), phase)));
+            // Exact for these magnitudes: the quotient is correctly rounded and truncation matches integer division
+            __m256 quotient = _mm256_div_ps(_mm256_cvtepi32_ps(tapered), _mm256_set1_ps(static_cast<float>(MaxPhase)));
+            __m256i score = _mm256_mullo_epi32(_mm256_cvttps_epi32(quotient),
+                                               _mm256_load_si256(reinterpret_cast<const __m256i*>(block.sign)));
+
+            alignas(32) int32_t lanesOut[BatchLanes];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(lanesOut), score);
+            std::copy(lanesOut, lanesOut + lanes, scores);
+        }
+#else
+        void evaluateBlock(const Block& block, int* scores, size_t lanes) {
+            const int32_t* table = batchTables().packed;
+            int32_t accumulator[BatchLanes] = {0};
+            for (int row = 0; row < block.rows; ++row) {
+                for (size_t lane = 0; lane < BatchLanes; ++lane) {
+                    accumulator[lane] += table[block.features[row][lane]];
+                }
+            }
+            for (size_t lane = 0; lane < lanes; ++lane) {
+                int eg = static_cast<int16_t>(static_cast<uint16_t>(accumulator[lane]));
+                int mg = (accumulator[lane] + 0x8000) >> 16;
+                int phase = block.phase[lane];
+                scores[lane] = block.sign[lane] * ((mg * phase + eg * (MaxPhase - phase)) / MaxPhase);
+            }
+        }
+#endif
+
+        void evaluateRange(const Board* positions, size_t count, int* scores) {
+            Block block;
+            for (size_t first = 0; first < count; first += BatchLanes) {
+                size_t lanes = std::min(BatchLanes, count - first);
+                extractFeatures(positions + first, lanes, block);
+                evaluateBlock(block, scores + first, lanes);
+            }
+        }
+    }
+
+    int evaluate(const Board& board) {
+        int mg = 0, eg = 0, phase = 0;
+
+        for (int piece = Pawn; piece <= King; ++piece) {
+            for (int color = White; color <= Black; ++color) {
+                bool isWhite = color == White;
+                int sign = isWhite ? 1 : -1;
+                uint64_t pieces = pieceBitboard(board, piece, isWhite);
+                while (pieces) {
+                    int square = firstSetBit(pieces);
+                    pieces &= pieces - 1;
+                    int index = isWhite ? square ^ 56 : square;
+                    mg += sign * (MaterialMg[piece] + TablesMg[piece][index]);
+                    eg += sign * (MaterialEg[piece] + TablesEg[piece][index]);
+                    phase += PhaseWeight[piece];
+                }
+            }
+        }
+
+        if (phase > MaxPhase) {
+            phase = MaxPhase;
+        }
+        int score = (mg * phase + eg * (MaxPhase - phase)) / MaxPhase;
+        return board.isWhiteToMove() ? score : -score;
+    }
+
+    void evaluateBatch(const Board* positions, size_t count, int* scores, int threads) {
+        batchTables();
+        if (threads <= 1 || count <= ChunkSize) {
+            evaluateRange(positions, count, scores);
+            return;
+        }
+
+        // Threads take chunks (a multiple of the block size) from a shared index
+        std::atomic<size_t> next(0);
+        auto worker = [&]() {
+            for (size_t first = next.fetch_add(ChunkSize); first < count; first = next.fetch_add(ChunkSize)) {
+                evaluateRange(positions + first, std::min(ChunkSize, count - first), scores + first);
+            }
+        };
+
+        std::vector<std::thread> pool;
+        for (int i = 1; i < threads; ++i) {
+            pool.emplace_back(worker);
+        }
+        worker();
+        for (std::thread& thread : pool) {
+            thread.join();
+        }
+    }
+}
@@ -0,0 +1,322 @@
+#include "game_host.h"
+#include "board.h"
+#include "harness.h"
+#include "key_history.h"
+#include "move_generation.h"
+#include "search.h"
+#include "zobrist.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <iomanip>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <thread>
+
+namespace GameHost {
+    TablePool::TablePool(size_t count, size_t kilobytesEach)
+        : memory(count * std::max<size_t>(kilobytesEach, 1) * 1024, LargePages::Mode::Transparent) {
+        size_t bytes = std::max<size_t>(kilobytesEach, 1) * 1024;
+        char* base = static_cast<char*>(memory.data());
+        tables.reserve(count);
+        idle.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            tables.emplace_back(new TranspositionTable(base + i * bytes, bytes));
+            idle.push_back(tables.back().get());
+        }
+    }
+
+    TranspositionTable* TablePool::acquire() {
+        TranspositionTable* table;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (idle.empty()) {
+                return nullptr;
+            }
+            table = idle.back();
+            idle.pop_back();
+        }
+        table->clear();
+        return table;
+    }
+
+    void TablePool::release(TranspositionTable* table) {
+        std::lock_guard<std::mutex> lock(mutex);
+        idle.push_back(table);
+    }
+
+    size_t TablePool::available() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return idle.size();
+    }
+
+    namespace {
+        using Clock = std::chrono::steady_clock;
+
+        enum Outcome { Running, WhiteWin, Draw, BlackWin };
+
+        // A game between its moves: everything its search needs to carry on from any worker
+        struct Game {
+            int index;
+            Board board;
+            KeyHistory history;
+            TranspositionTable* table;
+            int ply;
+            Clock::time_point due;        // When the current move fell due
+            Clock::time_point deadline;
+            int nextDepth;                // First iteration the next step runs
+            uint64_t budget;              // Nodes for the next step
+            Move bestMove;                // From the deepest completed iteration of this move
+            int bestDepth;                // 0 until an iteration completes
+        };
+
+        // Earliest deadline first; equal deadlines in the order they were queued
+        struct Ready {
+            Clock::time_point deadline;
+            uint64_t order;
+            Game* game;
+
+            bool operator>(const Ready& other) const {
+                return deadline != other.deadline ? deadline > other.deadline : order > other.order;
+            }
+        };
+
+        // What one worker has counted; folded into the summary when it finishes
+        struct Tally {
+            uint64_t moves = 0, steps = 0, nodes = 0, cutShort = 0, late = 0;
+            std::vector<double> latencies;
+        };
+
+        class Scheduler {
+        public:
+            explicit Scheduler(const Options& options)
+                : options(options), pool(std::max(1, std::min(options.concurrent, options.games)), options.tableKilobytes),
+                  started(0), finished(0), order(0), summary{} {}
+
+            Summary run() {
+                auto start = Clock::now();
+                for (size_t i = 0; i < pool.capacity() && started < options.games; ++i) {
+                    games.emplace_back(new Game);
+                    startGame(*games.back(), started++);
+                }
+                for (const std::unique_ptr<Game>& game : games) {
+                    queue.push(Ready{game->deadline, order++, game.get()});
+                }
+
+                std::vector<std::thread> workers;
+                for (int i = 1; i < options.threads; ++i) {
+                    workers.emplace_back([this]() { work(); });
+                }
+                work();
+                for (std::thread& worker : workers) {
+                    worker.join();
+                }
+
+                summary.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+                summary.gamesPerSecond = summary.seconds > 0 ? summary.games / summary.seconds : 0.0;
+                summary.p50Ms = Harness::percentile(latencies, 0.50);
+                summary.p90Ms = Harness::percentile(latencies, 0.90);
+                summary.p99Ms = Harness::percentile(latencies, 0.99);
+                summary.maxMs = latencies.empty() ? 0.0 : *std::max_element(latencies.begin(), latencies.end());
+                return summary;
+            }
+
+        private:
+            // A random opening per game index, reproducible from the seed
+            void startGame(Game& game, int index) {
+                std::mt19937_64 random(options.seed + static_cast<uint64_t>(index));
+                Harness::playRandomOpening(game.board, game.history, options.randomPlies, random);
+                game.index = index;
+                game.table = pool.acquire();
+                game.ply = 0;
+                beginMove(game, Clock::now());
+            }
+
+            void beginMove(Game& game, Clock::time_point now) {
+                game.due = now;
+                game.deadline = now + std::chrono::milliseconds(options.moveTimeMs);
+                game.nextDepth = 1;
+                game.budget = options.sliceNodes;
+                game.bestDepth = 0;
+            }
+
+            Outcome outcome(const Game& game) const {
+                const Board& board = game.board;
+                if (MoveGeneration::legalMoves(board).empty()) {
+                    return !board.isInCheck() ? Draw : board.isWhiteToMove() ? BlackWin : WhiteWin;
+                }
+                if (game.ply >= options.maxPlies || board.isRepetition() || board.isFiftyMoveDraw()
+                    || board.isInsufficientMaterial()) {
+                    return Draw;
+                }
+                return Running;
+            }
+
+            // One step of the game's current move, playing it when it is done. Returns the
+            // outcome after the step; the game stays queued while it is Running.
+            Outcome step(Game& game, Search::Searcher& searcher, Tally& tally) {
+                Search::Limits limits;
+                limits.startDepth = game.nextDepth;
+                limits.depth = options.depth;
+                limits.nodes = game.budget;
+
+                // Killers and history from other games would make the result depend on the
+                // schedule; the game's own table carries its work from step to step
+                searcher.setTable(*game.table);
+                searcher.clear();
+                Search::Result searched = searcher.search(game.board, limits);
+                ++tally.steps;
+                tally.nodes += searched.nodes;
+                if (searched.depth > 0) {
+                    game.bestMove = searched.bestMove;
+                    game.bestDepth = searched.depth;
+                    game.nextDepth = searched.depth + 1;
+                } else {
+                    // An interrupted iteration is thrown away, and the table does not always
+                    // keep enough of it for the retry to finish within the same budget; doubling
+                    // it guarantees progress at a bounded cost in wasted nodes
+                    game.budget = std::min<uint64_t>(game.budget * 2, options.sliceNodes << 16);
+                }
+
+                Clock::time_point now = Clock::now();
+                bool done = game.bestDepth >= options.depth;
+                if (!done && (now < game.deadline || game.bestDepth == 0)) {
+                    return Running;
+                }
+                tally.cutShort += !done;
+                tally.late += now > game.deadline;
+                tally.latencies.push_back(std::chrono::duration<double, std::milli>(now - game.due).count());
+                ++tally.moves;
+                game.board.makeMove(game.bestMove);
+                ++game.ply;
+                Outcome result = outcome(game);
+                if (result == Running) {
+                    beginMove(game, now);
+                }
+                return result;
+            }
+
+            void work() {
+                std::unique_ptr<Search::Searcher> searcher;
+                Tally tally;
+                std::unique_lock<std::mutex> lock(mutex);
+                while (true) {
+                    wake.wait(lock, [this]() { return !queue.empty() || finished == options.games; });
+                    if (queue.empty()) {
+                        break;
+                    }
+                    Game& game = *queue.top().game;
+                    queue.pop();
+                    lock.unlock();
+
+                    if (!searcher) {
+                        searcher.reset(new Search::Searcher(*game.table));
+                    }
+                    Outcome result = step(game, *searcher, tally);
+                    if (result != Running) {
+                        pool.release(game.table);
+                    }
+
+                    lock.lock();
+                    if (result != Running) {
+                        record(game, result);
+                        if (started < options.games) {
+                            int index = started++;
+                            lock.unlock();
+                            startGame(game, index);
+                            lock.lock();
+                        } else {
+                            if (finished == options.games) {
+                                wake.notify_all();
+                            }
+                            continue;
+                        }
+                    }
+                    queue.push(Ready{game.deadline, order++, &game});
+                    wake.notify_one();
+                }
+
+                summary.moves += tally.moves;
+                summary.steps += tally.steps;
+                summary.nodes += tally.nodes;
+                summary.cutShort += tally.cutShort;
+                summary.late += tally.late;
+                latencies.insert(latencies.end(), tally.latencies.begin(), tally.latencies.end());
+            }
+
+            // Called with the lock held
+            void record(const Game& game, Outcome result) {
+                ++finished;
+                ++summary.games;
+                summary.whiteWins += result == WhiteWin;
+                summary.draws += result == Draw;
+                summary.blackWins += result == BlackWin;
+                uint64_t state = game.board.getKey() ^ (static_cast<uint64_t>(game.index) << 20) ^ static_cast<uint64_t>(game.ply);
+                summary.signature ^= Zobrist::splitMix64(state);
+            }
+
+            const Options& options;
+            TablePool pool;
+            std::vector<std::unique_ptr<Game>> games;
+            std::priority_queue<Ready, std::vector<Ready>, std::greater<Ready>> queue;
+            std::mutex mutex;
+            std::condition_variable wake;
+            int started;
+            int finished;
+            uint64_t order;
+            Summary summary;
+            std::vector<double> latencies;
+        };
+    }
+
+    Summary play(const Options& options) {
+        Scheduler scheduler(options);
+        return scheduler.run();
+    }
+
+    int runCommand(const std::vector<std::string>& args) {
+        Options options;
+        for (size_t i = 0; i < args.size(); ++i) {
+            bool hasValue = i + 1 < args.size();
+            if (args[i] == "--games" && hasValue) {
+                options.games = std::max(1, std::stoi(args[++i]));
+            } else if (args[i] == "--concurrent" && hasValue) {
+                options.concurrent = std::max(1, std::stoi(args[++i]));
+            } else if (args[i] == "--threads" && hasValue) {
+                options.threads = std::max(1, std::stoi(args[++i]));
+            } else if (args[i] == "--depth" && hasValue) {
+                options.depth = std::max(1, std::min(Search::MaxPly - 1, std::stoi(args[++i])));
+            } else if (args[i] == "--movetime" && hasValue) {
+                options.moveTimeMs = std::max<int64_t>(0, std::stoll(args[++i]));
+            } else if (args[i] == "--slice" && hasValue) {
+                options.sliceNodes = std::max<uint64_t>(1, std::stoull(args[++i]));
+            } else if (args[i] == "--table" && hasValue) {
+                options.tableKilobytes = std::max<size_t>(1, std::stoul(args[++i]));
+            } else if (args[i] == "--random-plies" && hasValue) {
+                options.randomPlies = std::max(0, std::stoi(args[++i]));
+            } else if (args[i] == "--max-plies" && hasValue) {
+                options.maxPlies = std::max(1, std::stoi(args[++i]));
+            } else if (args[i] == "--seed" && hasValue) {
+                options.seed = std::stoull(args[++i]);
+            } else {
+                std::cerr << "host: unknown option " << args[i] << std::endl;
+                return 1;
+            }
+        }
+
+        Summary summary = play(options);
+        std::cout << "games " << summary.games << " moves " << summary.moves << " steps " << summary.steps
+                  << " nodes " << summary.nodes
+                  << " white " << summary.whiteWins << " draw " << summary.draws << " black " << summary.blackWins
+                  << std::fixed << std::setprecision(2)
+                  << "\ntime " << summary.seconds << " s games/s " << summary.gamesPerSecond
+                  << " moves/s " << (summary.seconds > 0 ? summary.moves / summary.seconds : 0.0)
+                  << "\nmove latency ms p50 " << summary.p50Ms << " p90 " << summary.p90Ms
+                  << " p99 " << summary.p99Ms << " max " << summary.maxMs
+                  << "\nlate " << summary.late << " cut short " << summary.cutShort
+                  << " tables " << std::min(options.concurrent, options.games) << " x " << options.tableKilobytes << " KB"
+                  << std::hex << " signature " << summary.signature << std::dec << std::endl;
+        return 0;
+    }
+}
@@ -0,0 +1,131 @@
+#include "large_pages.h"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <string>
+#include <utility>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace LargePages {
+    namespace {
+        constexpr size_t HugePageSize = 2 * 1024 * 1024;
+
+        size_t roundUp(size_t bytes, size_t alignment) {
+            return (bytes + alignment - 1) / alignment * alignment;
+        }
+
+#ifdef __linux__
+        // The system THP policy; "[never]" means madvise is accepted but has no effect
+        bool transparentEnabled() {
+            std::ifstream policy("/sys/kernel/mm/transparent_hugepage/enabled");
+            std::string line;
+            return std::getline(policy, line) && line.find("[never]") == std::string::npos;
+        }
+#endif
+    }
+
+    const char* modeName(Mode mode) {
+        switch (mode) {
+            case Mode::Explicit: return "explicit huge pages";
+            case Mode::Transparent: return "transparent huge pages";
+            case Mode::Normal: return "normal pages";
+        }
+        return "unknown";
+    }
+
+    Buffer::Buffer(size_t size, Mode request) : bytes(size) {
+        if (size == 0) {
+            return;
+        }
+#ifdef __linux__
+        // Reserved huge pages: fails unless the administrator has set some aside
+#ifdef MAP_HUGETLB
+        if (request == Mode::Explicit) {
+            size_t length = roundUp(size, HugePageSize);
+            void* mapped = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (mapped != MAP_FAILED) {
+                memory = mapped;
+                mappedBytes = length;
+                obtained = Mode::Explicit;
+                return;
+            }
+        }
+#endif
+
+        // Over-map by one huge page and trim both ends so the block starts on a 2MB boundary;
+        // only whole aligned 2MB ranges can be backed by transparent huge pages
+        size_t length = roundUp(size, HugePageSize);
+        void* mapped = mmap(nullptr, length + HugePageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapped == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        char* start = static_cast<char*>(mapped);
+        char* aligned = reinterpret_cast<char*>(roundUp(reinterpret_cast<uintptr_t>(start), HugePageSize));
+        if (aligned > start) {
+            munmap(start, static_cast<size_t>(aligned - start));
+        }
+        size_t tail = static_cast<size_t>(start + length + HugePageSize - (aligned + length));
+        if (tail) {
+            munmap(aligned + length, tail);
+        }
+        memory = aligned;
+        mappedBytes = length;
+
+        // madvise succeeds even when THP is disabled system-wide, so an "always"/"madvise"
+        // policy is needed too before the mode is reported as transparent
+        obtained = Mode::Normal;
+#if defined(MADV_HUGEPAGE) && defined(MADV_NOHUGEPAGE)
+        if (request != Mode::Normal && madvise(aligned, length, MADV_HUGEPAGE) == 0 && transparentEnabled()) {
+            obtained = Mode::Transparent;
+        } else {
+            madvise(aligned, length, MADV_NOHUGEPAGE);
+        }
+#endif
+#else
+        (void)request;
+        memory = std::aligned_alloc(HugePageSize, roundUp(size, HugePageSize));
+        if (!memory) {
+            throw std::bad_alloc();
+        }
+        std::memset(memory, 0, size);
+        obtained = Mode::Normal;
+#endif
+    }
+
+    Buffer::~Buffer() {
+        release();
+    }
+
+    Buffer::Buffer(Buffer&& other) noexcept
+        : memory(std::exchange(other.memory, nullptr)), bytes(std::exchange(other.bytes, 0)),
+          mappedBytes(std::exchange(other.mappedBytes, 0)), obtained(other.obtained) {}
+
+    Buffer& Buffer::operator=(Buffer&& other) noexcept {
+        if (this != &other) {
+            release();
+            memory = std::exchange(other.memory, nullptr);
+            bytes = std::exchange(other.bytes, 0);
+            mappedBytes = std::exchange(other.mappedBytes, 0);
+            obtained = other.obtained;
+        }
+        return *this;
+    }
+
+    void Buffer::release() {
+        if (!memory) {
+            return;
+        }
+#ifdef __linux__
+        munmap(memory, mappedBytes);
+#else
+        std::free(memory);
+#endif
+        memory = nullptr;
+        bytes = 0;
+        mappedBytes = 0;
+    }
+}
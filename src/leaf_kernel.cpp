@@ -0,0 +1,525 @@
+#include "leaf_kernel.h"
+#include "attacks.h"
+#include "move.h"
+#include "move_generation.h"
+
+#if defined(ENGINE_AVX2) || defined(ENGINE_AVX512)
+#include <immintrin.h>
+#endif
+
+namespace LeafKernel {
+    namespace {
+        // One block of positions in structure-of-arrays form: plane p of lane i is
+        // planes[p][i]. Lanes past the last position stay empty and count zero moves.
+        constexpr int MaxWidth = 8;
+        enum Plane {
+            OurPawns, OurKnights, OurBishops, OurRooks, OurQueens, OurKing,
+            TheirPawns, TheirKnights, TheirBishops, TheirRooks, TheirQueens, TheirKing,
+            CastleTargets,    // g1 and/or c1 for the castling rights still held
+            EnPassantTarget,  // Always on the sixth rank after the flip
+            PlaneCount
+        };
+
+        struct alignas(64) Block {
+            uint64_t planes[PlaneCount][MaxWidth];
+        };
+
+        constexpr uint64_t NotFileA = MoveGeneration::NotFileA;
+        constexpr uint64_t NotFileH = MoveGeneration::NotFileH;
+        constexpr uint64_t NotFileAB = 0xFCFCFCFCFCFCFCFCULL;
+        constexpr uint64_t NotFileGH = 0x3F3F3F3F3F3F3F3FULL;
+        constexpr uint64_t Rank3 = 0x0000000000FF0000ULL;
+        constexpr uint64_t Rank8 = 0xFF00000000000000ULL;
+
+        // Writes one position into a lane, flipped vertically when Black is to move
+        void pack(const Board& board, Block& block, int lane) {
+            PieceColor us = board.isWhiteToMove() ? White : Black;
+            PieceColor them = us == White ? Black : White;
+            auto orient = [us](uint64_t bitboard) { return us == White ? bitboard : __builtin_bswap64(bitboard); };
+
+            for (int pieceType = Pawn; pieceType <= King; ++pieceType) {
+                block.planes[OurPawns + pieceType - Pawn][lane] = orient(board.getPieces(us, pieceType));
+                block.planes[TheirPawns + pieceType - Pawn][lane] = orient(board.getPieces(them, pieceType));
+            }
+            bool kingSide = us == White ? board.canWhiteCastleKingSide() : board.canBlackCastleKingSide();
+            bool queenSide = us == White ? board.canWhiteCastleQueenSide() : board.canBlackCastleQueenSide();
+            block.planes[CastleTargets][lane] = (kingSide ? 1ULL << 6 : 0) | (queenSide ? 1ULL << 2 : 0);
+            block.planes[EnPassantTarget][lane] = orient(board.getEnPassantSquare());
+        }
+
+        void clearLanes(Block& block, int firstLane) {
+            for (int plane = 0; plane < PlaneCount; ++plane) {
+                for (int lane = firstLane; lane < MaxWidth; ++lane) {
+                    block.planes[plane][lane] = 0;
+                }
+            }
+        }
+
+        // Lane types. Each provides load/store, broadcast, bitwise operators, add/sub,
+        // compile-time shifts, any() (all ones in lanes that are nonzero), a per-lane
+        // popcount and anyLane() (true if some lane is nonzero).
+        struct ScalarLanes {
+            static constexpr int Width = 1;
+            uint64_t v;
+
+            static ScalarLanes load(const uint64_t* lanes) { return {*lanes}; }
+            static ScalarLanes broadcast(uint64_t value) { return {value}; }
+            void store(uint64_t* lanes) const { *lanes = v; }
+
+            friend ScalarLanes operator&(ScalarLanes a, ScalarLanes b) { return {a.v & b.v}; }
+            friend ScalarLanes operator|(ScalarLanes a, ScalarLanes b) { return {a.v | b.v}; }
+            friend ScalarLanes operator^(ScalarLanes a, ScalarLanes b) { return {a.v ^ b.v}; }
+            friend ScalarLanes operator~(ScalarLanes a) { return {~a.v}; }
+            friend ScalarLanes operator+(ScalarLanes a, ScalarLanes b) { return {a.v + b.v}; }
+            friend ScalarLanes operator-(ScalarLanes a, ScalarLanes b) { return {a.v - b.v}; }
+
+            template <int Amount>
+            ScalarLanes shift() const { return {MoveGeneration::shift<Amount>(v)}; }
+            ScalarLanes any() const { return {v ? ~0ULL : 0ULL}; }
+            ScalarLanes popcount() const { return {static_cast<uint64_t>(__builtin_popcountll(v))}; }
+            bool anyLane() const { return v != 0; }
+        };
+
+#ifdef ENGINE_AVX2
+        struct Avx2Lanes {
+            static constexpr int Width = 4;
+            __m256i v;
+
+            static Avx2Lanes load(const uint64_t* lanes) { return {_mm256_load_si256(reinterpret_cast<const __m256i*>(lanes))}; }
+            static Avx2Lanes broadcast(uint64_t value) { return {_mm256_set1_epi64x(static_cast<long long>(value))}; }
+            void store(uint64_t* lanes) const { _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), v); }
+
+            friend Avx2Lanes operator&(Avx2Lanes a, Avx2Lanes b) { return {_mm256_and_si256(a.v, b.v)}; }
+            friend Avx2Lanes operator|(Avx2Lanes a, Avx2Lanes b) { return {_mm256_or_si256(a.v, b.v)}; }
+            friend Avx2Lanes operator^(Avx2Lanes a, Avx2Lanes b) { return {_mm256_xor_si256(a.v, b.v)}; }
+            friend Avx2Lanes operator~(Avx2Lanes a) { return {_mm256_xor_si256(a.v, _mm256_set1_epi64x(-1))}; }
+            friend Avx2Lanes operator+(Avx2Lanes a, Avx2Lanes b) { return {_mm256_add_epi64(a.v, b.v)}; }
+            friend Avx2Lanes operator-(Avx2Lanes a, Avx2Lanes b) { return {_mm256_sub_epi64(a.v, b.v)}; }
+
+            template <int Amount>
+            Avx2Lanes shift() const {
+                return {Amount > 0 ? _mm256_slli_epi64(v, Amount > 0 ? Amount : 0) : _mm256_srli_epi64(v, Amount < 0 ? -Amount : 0)};
+            }
+            Avx2Lanes any() const {
+                return {_mm256_xor_si256(_mm256_cmpeq_epi64(v, _mm256_setzero_si256()), _mm256_set1_epi64x(-1))};
+            }
+            // Nibble lookup per byte, then the bytes of each lane summed by sad against zero
+            Avx2Lanes popcount() const {
+                const __m256i table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                                       0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+                const __m256i nibble = _mm256_set1_epi8(0x0F);
+                __m256i low = _mm256_shuffle_epi8(table, _mm256_and_si256(v, nibble));
+                __m256i high = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble));
+                return {_mm256_sad_epu8(_mm256_add_epi8(low, high), _mm256_setzero_si256())};
+            }
+            bool anyLane() const { return !_mm256_testz_si256(v, v); }
+        };
+#endif
+
+#ifdef ENGINE_AVX512
+        struct Avx512Lanes {
+            static constexpr int Width = 8;
+            __m512i v;
+
+            static Avx512Lanes load(const uint64_t* lanes) { return {_mm512_load_si512(lanes)}; }
+            static Avx512Lanes broadcast(uint64_t value) { return {_mm512_set1_epi64(static_cast<long long>(value))}; }
+            void store(uint64_t* lanes) const { _mm512_store_si512(lanes, v); }
+
+            friend Avx512Lanes operator&(Avx512Lanes a, Avx512Lanes b) { return {_mm512_and_si512(a.v, b.v)}; }
+            friend Avx512Lanes operator|(Avx512Lanes a, Avx512Lanes b) { return {_mm512_or_si512(a.v, b.v)}; }
+            friend Avx512Lanes operator^(Avx512Lanes a, Avx512Lanes b) { return {_mm512_xor_si512(a.v, b.v)}; }
+            friend Avx512Lanes operator~(Avx512Lanes a) { return {_mm512_ternarylogic_epi64(a.v, a.v, a.v, 0x55)}; }
+            friend Avx512Lanes operator+(Avx512Lanes a, Avx512Lanes b) { return {_mm512_add_epi64(a.v, b.v)}; }
+            friend Avx512Lanes operator-(Avx512Lanes a, Avx512Lanes b) { return {_mm512_sub_epi64(a.v, b.v)}; }
+
+            template <int Amount>
+            Avx512Lanes shift() const {
+                return {Amount > 0 ? _mm512_slli_epi64(v, Amount > 0 ? Amount : 0) : _mm512_srli_epi64(v, Amount < 0 ? -Amount : 0)};
+            }
+            Avx512Lanes any() const {
+                return {_mm512_maskz_mov_epi64(_mm512_test_epi64_mask(v, v), _mm512_set1_epi64(-1))};
+            }
+            Avx512Lanes popcount() const {
+                const __m512i table = _mm512_broadcast_i32x4(_mm_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4));
+                const __m512i nibble = _mm512_set1_epi8(0x0F);
+                __m512i low = _mm512_shuffle_epi8(table, _mm512_and_si512(v, nibble));
+                __m512i high = _mm512_shuffle_epi8(table, _mm512_and_si512(_mm512_srli_epi16(v, 4), nibble));
+                return {_mm512_sad_epu8(_mm512_add_epi8(low, high), _mm512_setzero_si512())};
+            }
+            bool anyLane() const { return _mm512_test_epi64_mask(v, v) != 0; }
+        };
+#endif
+
+        // One step in Direction, dropping squares that wrapped round the board edge
+        template <int Direction, typename V>
+        inline V step(V bitboards) {
+            return bitboards.template shift<Direction>() & V::broadcast(Attacks::wrapMask<Direction>());
+        }
+
+        // Knight jumps are checked against the two files they can wrap onto
+        template <int Direction>
+        constexpr uint64_t knightWrapMask() {
+            return (Direction == 17 || Direction == -15) ? NotFileA
+                 : (Direction == 15 || Direction == -17) ? NotFileH
+                 : (Direction == 10 || Direction == -6) ? NotFileAB
+                 : NotFileGH;
+        }
+
+        template <int Direction, typename V>
+        inline V jump(V knights) {
+            return knights.template shift<Direction>() & V::broadcast(knightWrapMask<Direction>());
+        }
+
+        // Attacks::slide in lanes
+        template <int Direction, typename V>
+        inline V slide(V generators, V empty) {
+            const V mask = V::broadcast(Attacks::wrapMask<Direction>());
+            V propagators = empty & mask;
+            generators = generators | (propagators & generators.template shift<Direction>());
+            propagators = propagators & propagators.template shift<Direction>();
+            generators = generators | (propagators & generators.template shift<2 * Direction>());
+            propagators = propagators & propagators.template shift<2 * Direction>();
+            generators = generators | (propagators & generators.template shift<4 * Direction>());
+            return generators.template shift<Direction>() & mask;
+        }
+
+        template <typename V>
+        inline V knightAttacks(V knights) {
+            return jump<17>(knights) | jump<15>(knights) | jump<10>(knights) | jump<6>(knights)
+                 | jump<-6>(knights) | jump<-10>(knights) | jump<-15>(knights) | jump<-17>(knights);
+        }
+
+        template <typename V>
+        inline V kingAttacks(V king) {
+            return step<8>(king) | step<-8>(king) | step<1>(king) | step<-1>(king)
+                 | step<9>(king) | step<7>(king) | step<-7>(king) | step<-9>(king);
+        }
+
+        template <typename V>
+        inline V diagonalRays(V sliders, V empty) {
+            return slide<9>(sliders, empty) | slide<7>(sliders, empty) | slide<-7>(sliders, empty) | slide<-9>(sliders, empty);
+        }
+
+        template <typename V>
+        inline V straightRays(V sliders, V empty) {
+            return slide<8>(sliders, empty) | slide<-8>(sliders, empty) | slide<1>(sliders, empty) | slide<-1>(sliders, empty);
+        }
+
+        // Moves of a set of our pawns onto target: pushes through empty, captures of theirs,
+        // and every promotion counted four times
+        template <typename V>
+        inline V pawnMoveCount(V pawns, V empty, V theirs, V target) {
+            const V rank3 = V::broadcast(Rank3), rank8 = V::broadcast(Rank8);
+            V single = pawns.template shift<8>() & empty;
+            V pushes = single & target;
+            V doubles = (single & rank3).template shift<8>() & empty & target;
+            V left = step<7>(pawns) & theirs & target;
+            V right = step<9>(pawns) & theirs & target;
+            V quiet = (pushes & ~rank8).popcount() + doubles.popcount() + (left & ~rank8).popcount() + (right & ~rank8).popcount();
+            V promotions = (pushes & rank8).popcount() + (left & rank8).popcount() + (right & rank8).popcount();
+            return quiet + promotions.template shift<2>();
+        }
+
+        // Everything the kernel needs to know about one position, kept per lane
+        template <typename V>
+        struct Position {
+            V pawns, knights, bishops, rooks, queens, king;
+            V theirPawns, theirKnights, theirDiagonal, theirStraight, theirKing;
+            V ours, theirs, empty;
+        };
+
+        // Ray from our king in Direction: records a slider check (and the squares that block it)
+        // or a pin (and the line the pinned piece may still move along)
+        template <int Direction, typename V>
+        inline void scanRay(const Position<V>& position, V& checkers, V& blockers, V& pinned, V& line) {
+            constexpr bool Diagonal = Direction == 9 || Direction == 7 || Direction == -7 || Direction == -9;
+            V enemySliders = Diagonal ? position.theirDiagonal : position.theirStraight;
+            V ray = slide<Direction>(position.king, position.empty);
+            V checker = ray & enemySliders;
+            checkers = checkers | checker;
+            blockers = blockers | (ray & checker.any());
+
+            V candidate = ray & position.ours;
+            V beyond = slide<Direction>(candidate, position.empty);
+            V pins = (beyond & enemySliders).any();
+            pinned = candidate & pins;
+            line = (ray | beyond) & ~candidate & pins;
+        }
+
+        // Moves of the piece pinned along Direction (if any), which stay on the pin line
+        template <int Direction, typename V>
+        inline V pinnedMoveCount(const Position<V>& position, V pinned, V line, V target) {
+            constexpr bool Diagonal = Direction == 9 || Direction == 7 || Direction == -7 || Direction == -9;
+            constexpr bool Vertical = Direction == 8 || Direction == -8;
+            V sliders = pinned & (Diagonal ? position.bishops | position.queens : position.rooks | position.queens);
+            V count = (line & target & sliders.any()).popcount();
+
+            V pawns = pinned & position.pawns;
+            if (Diagonal) {
+                V none = V::broadcast(0);
+                count = count + pawnMoveCount(pawns, none, position.theirs, target & line);
+            } else if (Vertical) {
+                V none = V::broadcast(0);
+                count = count + pawnMoveCount(pawns, position.empty, none, target);
+            }
+            return count;
+        }
+
+        // Whether our king would be attacked after an en passant capture by capturer
+        template <typename V>
+        inline V exposedAfterEnPassant(const Position<V>& position, V occupied, V capturer, V target, V captured) {
+            V empty = ~(occupied ^ capturer ^ target ^ captured);
+            V king = position.king;
+            V attackers = (diagonalRays(king, empty) & position.theirDiagonal)
+                        | (straightRays(king, empty) & position.theirStraight)
+                        | (knightAttacks(king) & position.theirKnights)
+                        | ((step<7>(king) | step<9>(king)) & position.theirPawns & ~captured);
+            return attackers.any();
+        }
+
+        template <typename V>
+        V countLegal(const Block& block) {
+            Position<V> position;
+            position.pawns = V::load(block.planes[OurPawns]);
+            position.knights = V::load(block.planes[OurKnights]);
+            position.bishops = V::load(block.planes[OurBishops]);
+            position.rooks = V::load(block.planes[OurRooks]);
+            position.queens = V::load(block.planes[OurQueens]);
+            position.king = V::load(block.planes[OurKing]);
+            position.theirPawns = V::load(block.planes[TheirPawns]);
+            position.theirKnights = V::load(block.planes[TheirKnights]);
+            V theirQueens = V::load(block.planes[TheirQueens]);
+            position.theirDiagonal = V::load(block.planes[TheirBishops]) | theirQueens;
+            position.theirStraight = V::load(block.planes[TheirRooks]) | theirQueens;
+            position.theirKing = V::load(block.planes[TheirKing]);
+            position.ours = position.pawns | position.knights | position.bishops | position.rooks | position.queens | position.king;
+            position.theirs = position.theirPawns | position.theirKnights | position.theirDiagonal | position.theirStraight
+                            | position.theirKing;
+            V occupied = position.ours | position.theirs;
+            position.empty = ~occupied;
+
+            // Squares the opponent attacks, seen through our king so it cannot retreat along a checking ray
+            V emptyWithoutKing = position.empty | position.king;
+            V attacked = step<-7>(position.theirPawns) | step<-9>(position.theirPawns) | knightAttacks(position.theirKnights) | kingAttacks(position.theirKing)
+                     | diagonalRays(position.theirDiagonal, emptyWithoutKing)
+                     | straightRays(position.theirStraight, emptyWithoutKing);
+
+            V count = (kingAttacks(position.king) & ~position.ours & ~attacked).popcount();
+
+            // Checks by pawns and knights can only be answered by capturing the checker
+            V checkers = ((step<7>(position.king) | step<9>(position.king)) & position.theirPawns)
+                       | (knightAttacks(position.king) & position.theirKnights);
+            V blockers = checkers;
+            V pinned[8], lines[8];
+            scanRay<8>(position, checkers, blockers, pinned[0], lines[0]);
+            scanRay<-8>(position, checkers, blockers, pinned[1], lines[1]);
+            scanRay<1>(position, checkers, blockers, pinned[2], lines[2]);
+            scanRay<-1>(position, checkers, blockers, pinned[3], lines[3]);
+            scanRay<9>(position, checkers, blockers, pinned[4], lines[4]);
+            scanRay<7>(position, checkers, blockers, pinned[5], lines[5]);
+            scanRay<-7>(position, checkers, blockers, pinned[6], lines[6]);
+            scanRay<-9>(position, checkers, blockers, pinned[7], lines[7]);
+            V allPinned = pinned[0] | pinned[1] | pinned[2] | pinned[3] | pinned[4] | pinned[5] | pinned[6] | pinned[7];
+
+            // Out of check anything may land anywhere not ours; in single check only on the
+            // blocking squares or the checker; in double check only the king moves
+            V inCheck = checkers.any();
+            V doubleCheck = (checkers & (checkers - V::broadcast(1))).any();
+            V target = ~position.ours & (~inCheck | blockers) & ~doubleCheck;
+
+            // Castling: rights still held, path empty and not attacked, king not in check
+            V castle = V::load(block.planes[CastleTargets]) & ~inCheck;
+            const V kingSidePath = V::broadcast(0x60ULL);
+            V kingSide = castle & V::broadcast(1ULL << 6) & ~((occupied | attacked) & kingSidePath).any();
+            V queenSide = castle & V::broadcast(1ULL << 2)
+                        & ~((occupied & V::broadcast(0x0EULL)) | (attacked & V::broadcast(0x0CULL))).any();
+            count = count + (kingSide | queenSide).popcount();
+
+            // Unpinned pieces; each direction's rays are disjoint, so their squares count moves exactly
+            V pawns = position.pawns & ~allPinned;
+            count = count + pawnMoveCount(pawns, position.empty, position.theirs, target);
+
+            V knights = position.knights & ~allPinned;
+            count = count + (jump<17>(knights) & target).popcount() + (jump<15>(knights) & target).popcount()
+                          + (jump<10>(knights) & target).popcount() + (jump<6>(knights) & target).popcount()
+                          + (jump<-6>(knights) & target).popcount() + (jump<-10>(knights) & target).popcount()
+                          + (jump<-15>(knights) & target).popcount() + (jump<-17>(knights) & target).popcount();
+
+            V diagonal = (position.bishops | position.queens) & ~allPinned;
+            count = count + (slide<9>(diagonal, position.empty) & target).popcount()
+                          + (slide<7>(diagonal, position.empty) & target).popcount()
+                          + (slide<-7>(diagonal, position.empty) & target).popcount()
+                          + (slide<-9>(diagonal, position.empty) & target).popcount();
+
+            V straight = (position.rooks | position.queens) & ~allPinned;
+            count = count + (slide<8>(straight, position.empty) & target).popcount()
+                          + (slide<-8>(straight, position.empty) & target).popcount()
+                          + (slide<1>(straight, position.empty) & target).popcount()
+                          + (slide<-1>(straight, position.empty) & target).popcount();
+
+            if (allPinned.anyLane()) {
+                count = count + pinnedMoveCount<8>(position, pinned[0], lines[0], target)
+                              + pinnedMoveCount<-8>(position, pinned[1], lines[1], target)
+                              + pinnedMoveCount<1>(position, pinned[2], lines[2], target)
+                              + pinnedMoveCount<-1>(position, pinned[3], lines[3], target)
+                              + pinnedMoveCount<9>(position, pinned[4], lines[4], target)
+                              + pinnedMoveCount<7>(position, pinned[5], lines[5], target)
+                              + pinnedMoveCount<-7>(position, pinned[6], lines[6], target)
+                              + pinnedMoveCount<-9>(position, pinned[7], lines[7], target);
+            }
+
+            // En passant is rare, so its full king-safety recheck (which also covers the
+            // captured and capturing pawns leaving the same rank) runs only when some lane has one
+            V enPassant = V::load(block.planes[EnPassantTarget]);
+            if (enPassant.anyLane()) {
+                V captured = enPassant.template shift<-8>();
+                V fromRight = step<-7>(enPassant) & position.pawns;
+                V fromLeft = step<-9>(enPassant) & position.pawns;
+                count = count + (fromRight & ~exposedAfterEnPassant(position, occupied, fromRight, enPassant, captured)).popcount()
+                              + (fromLeft & ~exposedAfterEnPassant(position, occupied, fromLeft, enPassant, captured)).popcount();
+            }
+            return count;
+        }
+
+        template <typename V>
+        void countAll(const Board* positions, size_t count, uint32_t* counts) {
+            Block block;
+            alignas(64) uint64_t results[MaxWidth];
+            for (size_t first = 0; first < count; first += V::Width) {
+                int lanes = static_cast<int>(count - first < static_cast<size_t>(V::Width) ? count - first : V::Width);
+                for (int lane = 0; lane < lanes; ++lane) {
+                    pack(positions[first + lane], block, lane);
+                }
+                if (lanes < V::Width) {
+                    clearLanes(block, lanes);
+                }
+                countLegal<V>(block).store(results);
+                for (int lane = 0; lane < lanes; ++lane) {
+                    counts[first + lane] = static_cast<uint32_t>(results[lane]);
+                }
+            }
+        }
+
+        // Sums the legal move counts of positions fed to it one at a time
+        template <typename V>
+        class LeafTotal {
+        public:
+            void add(const Board& board) {
+                pack(board, block, lanes);
+                if (++lanes == V::Width) {
+                    flush();
+                }
+            }
+
+            uint64_t finish() {
+                if (lanes) {
+                    clearLanes(block, lanes);
+                    flush();
+                }
+                return total;
+            }
+
+        private:
+            void flush() {
+                alignas(64) uint64_t results[MaxWidth];
+                countLegal<V>(block).store(results);
+                for (int lane = 0; lane < V::Width; ++lane) {
+                    total += results[lane];
+                }
+                lanes = 0;
+            }
+
+            Block block;
+            int lanes = 0;
+            uint64_t total = 0;
+        };
+
+        template <typename V>
+        uint64_t perftLanes(const Board& board, int depth) {
+            if (depth <= 0) {
+                return 1;
+            }
+            if (depth == 1) {
+                uint32_t moves;
+                countAll<V>(&board, 1, &moves);
+                return moves;
+            }
+
+            bool isWhite = board.isWhiteToMove();
+            MoveList moves;
+            board.generateMoves(isWhite, moves);
+            uint64_t nodes = 0;
+            if (depth > 2) {
+                for (const Move& move : moves) {
+                    if (MoveGeneration::isMoveLegal(board, move, isWhite)) {
+                        Board child = board;
+                        child.makeMove(move);
+                        nodes += perftLanes<V>(child, depth - 1);
+                    }
+                }
+                return nodes;
+            }
+
+            // Children are packed straight into lanes and counted a block at a time
+            LeafTotal<V> total;
+            for (const Move& move : moves) {
+                if (MoveGeneration::isMoveLegal(board, move, isWhite)) {
+                    Board child = board;
+                    child.makeMove(move);
+                    total.add(child);
+                }
+            }
+            return total.finish();
+        }
+    }
+
+    const char* pathName(Path path) {
+        switch (path) {
+            case Path::Scalar: return "scalar";
+            case Path::Avx2: return "avx2";
+            case Path::Avx512: return "avx512";
+        }
+        return "unknown";
+    }
+
+    bool available(Path path) {
+        switch (path) {
+            case Path::Scalar: return true;
+#ifdef ENGINE_AVX2
+            case Path::Avx2: return true;
+#endif
+#ifdef ENGINE_AVX512
+            case Path::Avx512: return true;
+#endif
+            default: return false;
+        }
+    }
+
+    Path widest() {
+        return available(Path::Avx512) ? Path::Avx512 : available(Path::Avx2) ? Path::Avx2 : Path::Scalar;
+    }
+
+    void countLegalMoves(const Board* positions, size_t count, uint32_t* counts, Path path) {
+        switch (path) {
+#ifdef ENGINE_AVX2
+            case Path::Avx2: countAll<Avx2Lanes>(positions, count, counts); return;
+#endif
+#ifdef ENGINE_AVX512
+            case Path::Avx512: countAll<Avx512Lanes>(positions, count, counts); return;
+#endif
+            default: countAll<ScalarLanes>(positions, count, counts); return;
+        }
+    }
+
+    uint64_t perft(const Board& board, int depth, Path path) {
+        switch (path) {
+#ifdef ENGINE_AVX2
+            case Path::Avx2: return perftLanes<Avx2Lanes>(board, depth);
+#endif
+#ifdef ENGINE_AVX512
+            case Path::Avx512: return perftLanes<Avx512Lanes>(board, depth);
+#endif
+            default: return perftLanes<ScalarLanes>(board, depth);
+        }
+    }
+}
@@ -1,19 +1,25 @@
 #include "move_generation.h"
 #include "board.h"
+#include "datagen.h"
 #include "engine.h"
+#include "game_host.h"
+#include "mate_search.h"
+#include "perft.h"
+#include "server.h"
+#include "stats.h"
+#include "tune.h"
 #include <iostream>
 #include <cstdint>
+#include <string>
 #include <vector>
 
-int main() {
+// Lists the moves of the initial position for both sides
+static int showInitialMoves() {
     // Initialize the board
     Board board;
     board.initializePosition();
 
-    // Precompute knight attacks
-    MoveGeneration::precomputeKnightAttacks();
-
-    // Generate and display all moves
+    // Generate all moves (the per-piece bitboard dump needs ENGINE_TRACE_LEVEL >= 2)
     std::cout << "Generating all moves for the initial position:\n";
     MoveGeneration::generateAllMoves(board);
 
@@ -33,5 +39,45 @@ int main() {
         std::cout << move.toString() << std::endl;
     }
 
+    std::cout << Stats::infoString(Stats::collect()) << std::endl;
+
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    // Subcommands; with none the engine speaks UCI on stdin/stdout
+    std::string command = argc > 1 ? argv[1] : "";
+    std::vector<std::string> args(argc > 2 ? argv + 2 : argv + argc, argv + argc);
+
+    if (command == "perft") {
+        return Perft::runCommand(args);
+    }
+    if (command == "bench") {
+        return runBench(args);
+    }
+    if (command == "datagen") {
+        return Datagen::runCommand(args);
+    }
+    if (command == "mate") {
+        return MateSearch::runCommand(args);
+    }
+    if (command == "tune") {
+        return Tune::runCommand(args);
+    }
+    if (command == "server") {
+        return Server::runCommand(args);
+    }
+    if (command == "loadtest") {
+        return Server::runLoadTest(args);
+    }
+    if (command == "host") {
+        return GameHost::runCommand(args);
+    }
+    if (command == "moves") {
+        return showInitialMoves();
+    }
+
+    startEngine();
+    uciLoop();
     return 0;
 }
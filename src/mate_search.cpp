@@ -0,0 +1,397 @@
+#include "mate_search.h"
+#include "attacks.h"
+#include "move_generation.h"
+#include "transposition_table.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+namespace MateSearch {
+    Solver::Solver(size_t megabytes)
+        : mask(0), frames(new Frame[Search::MaxPly + 1]), stopRequested(false), stopped(false), maxPly(0),
+          nodes(0) {
+        // Largest power-of-two bucket count that fits
+        size_t buckets = 1;
+        while (buckets * 2 * BucketSize * sizeof(Entry) <= std::max<size_t>(1, megabytes) * 1024 * 1024) {
+            buckets *= 2;
+        }
+        entries.resize(buckets * BucketSize);
+        mask = buckets - 1;
+    }
+
+    void Solver::clear() {
+        std::fill(entries.begin(), entries.end(), Entry{});
+    }
+
+    bool Solver::shouldStop() {
+        if (stopRequested.load(std::memory_order_relaxed)) {
+            return true;
+        }
+        if (limits.nodes && nodes >= limits.nodes) {
+            return true;
+        }
+        if (limits.moveTime > 0) {
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - startTime).count();
+            return elapsed >= limits.moveTime;
+        }
+        return false;
+    }
+
+    // False, with proof and disproof 1, for a position the table holds nothing usable on
+    bool Solver::lookup(uint64_t key, int remaining, uint32_t& proof, uint32_t& disproof, uint16_t& distance) const {
+        const Entry* bucket = &entries[(key & mask) * BucketSize];
+        for (int i = 0; i < BucketSize; ++i) {
+            const Entry& entry = bucket[i];
+            if (entry.key != key) {
+                continue;
+            }
+            bool usable = entry.proof == 0 ? entry.distance <= remaining
+                        : entry.disproof == 0 ? entry.remaining >= remaining
+                        : true;
+            if (usable) {
+                proof = entry.proof;
+                disproof = entry.disproof;
+                distance = entry.distance;
+                return true;
+            }
+            break;
+        }
+        proof = disproof = 1;
+        distance = 0;
+        return false;
+    }
+
+    void Solver::store(uint64_t key, int remaining, uint32_t proof, uint32_t disproof, uint16_t distance, uint64_t work) {
+        Entry* bucket = &entries[(key & mask) * BucketSize];
+        Entry* victim = bucket;
+        for (int i = 0; i < BucketSize; ++i) {
+            if (bucket[i].key == key) {
+                victim = &bucket[i];
+                break;
+            }
+            if (bucket[i].work < victim->work) {
+                victim = &bucket[i];
+            }
+        }
+        victim->key = key;
+        victim->proof = proof;
+        victim->disproof = disproof;
+        victim->work = static_cast<uint32_t>(std::min<uint64_t>(work, UINT32_MAX));
+        victim->distance = distance;
+        victim->remaining = static_cast<uint16_t>(remaining);
+    }
+
+    // Legal moves of the node at ply and the keys they lead to. Attacker nodes keep only
+    // checks when asked to, and always when a single ply is left, since only a check mates;
+    // the others are dropped before they are played.
+    // A defender's reply is estimated to take one proof per square its king can flee to,
+    // which steers the attacker towards moves that box the king in.
+    int Solver::expand(Board& board, int ply) {
+        Frame& frame = frames[ply];
+        bool isWhite = board.isWhiteToMove();
+        bool checksOnly = (ply & 1) == 0 && (limits.checksOnly || maxPly - ply == 1);
+        board.generateMoves(isWhite, frame.moves);
+        CheckInfo checkInfo = checksOnly ? board.checkInfo() : CheckInfo{};
+
+        int count = 0;
+        for (int i = 0; i < frame.moves.size(); ++i) {
+            const Move move = frame.moves[i];
+            if ((checksOnly && !board.givesCheck(move, checkInfo)) || !MoveGeneration::isMoveLegal(board, move, isWhite)) {
+                continue;
+            }
+            board.makeMove(move);
+            uint64_t key = board.getKey();
+            PieceColor them = isWhite ? Black : White;
+            uint64_t king = board.getPieces(them, King);
+            uint64_t flights = Attacks::kingAttacks(king)
+                             & ~board.getColorPieces(them) & ~board.getAttacks(isWhite ? White : Black);
+            board.undoMove(move);
+            frame.estimate[count] = 1 + __builtin_popcountll(flights);
+            frame.keys[count] = key;
+            frame.moves[count++] = move;
+        }
+        frame.moves.resize(count);
+        return count;
+    }
+
+    // Multiple iterative deepening: searches the node until its proof number reaches
+    // proofThreshold or its disproof number disproofThreshold, always descending into the
+    // child that currently decides the node, then stores the node's numbers
+    void Solver::mid(Board& board, int ply, uint32_t proofThreshold, uint32_t disproofThreshold) {
+        ++nodes;
+        if ((limits.nodes && nodes > limits.nodes) || ((nodes & 1023) == 0 && shouldStop())) {
+            stopped = true;
+        }
+        if (stopped) {
+            return;
+        }
+
+        Frame& frame = frames[ply];
+        frame.key = board.getKey();
+        bool attacker = (ply & 1) == 0;
+        int remaining = maxPly - ply;
+        uint64_t startNodes = nodes;
+        int count = expand(board, ply);
+
+        // No moves (or checks) left for the attacker, checkmate or stalemate for the defender,
+        // or the ply limit
+        if (count == 0 || remaining == 0) {
+            bool mated = count == 0 && !attacker && board.isInCheck();
+            store(frame.key, remaining, mated ? 0 : Infinity, mated ? Infinity : 0, 0, 1);
+            return;
+        }
+
+        while (true) {
+            // The attacker minimises proof numbers over its children and sums disproof
+            // numbers; the defender the other way round
+            uint32_t smallest = Infinity, second = Infinity;
+            uint64_t sum = 0;
+            int best = 0;
+            for (int i = 0; i < count; ++i) {
+                bool repeated = false;
+                for (int earlier = ply - 1; earlier >= 0 && !repeated; --earlier) {
+                    repeated = frames[earlier].key == frame.keys[i];
+                }
+                if (repeated) {
+                    frame.proof[i] = Infinity;
+                    frame.disproof[i] = 0;
+                    frame.distance[i] = 0;
+                } else if (!lookup(frame.keys[i], remaining - 1, frame.proof[i], frame.disproof[i], frame.distance[i])
+                           && attacker) {
+                    frame.proof[i] = frame.estimate[i];
+                }
+
+                uint32_t minimised = attacker ? frame.proof[i] : frame.disproof[i];
+                sum += attacker ? frame.disproof[i] : frame.proof[i];
+                if (minimised < smallest) {
+                    second = smallest;
+                    smallest = minimised;
+                    best = i;
+                } else if (minimised < second) {
+                    second = minimised;
+                }
+            }
+            // The sum is Infinity only through a child the node is already decided by (smallest
+            // 0); otherwise it saturates one below, so large trees never pass for decided ones
+            uint32_t summed = static_cast<uint32_t>(std::min<uint64_t>(sum, smallest == 0 ? Infinity : Infinity - 1));
+            uint32_t proof = attacker ? smallest : summed;
+            uint32_t disproof = attacker ? summed : smallest;
+
+            if (proof >= proofThreshold || disproof >= disproofThreshold) {
+                // A proven attacker node mates through its quickest proven child, a proven
+                // defender node lasts as long as its slowest
+                uint16_t distance = 0;
+                if (proof == 0) {
+                    distance = attacker ? UINT16_MAX : 0;
+                    for (int i = 0; i < count; ++i) {
+                        if (frame.proof[i] == 0) {
+                            uint16_t through = static_cast<uint16_t>(frame.distance[i] + 1);
+                            distance = attacker ? std::min(distance, through) : std::max(distance, through);
+                        }
+                    }
+                }
+                store(frame.key, remaining, proof, disproof, distance, nodes - startNodes);
+                return;
+            }
+
+            uint32_t childProof, childDisproof;
+            if (attacker) {
+                childProof = std::min<uint32_t>(proofThreshold, second + 1);
+                childDisproof = static_cast<uint32_t>(
+                    std::min<uint64_t>(static_cast<uint64_t>(disproofThreshold) - disproof + frame.disproof[best], Infinity));
+            } else {
+                childDisproof = std::min<uint32_t>(disproofThreshold, second + 1);
+                childProof = static_cast<uint32_t>(
+                    std::min<uint64_t>(static_cast<uint64_t>(proofThreshold) - proof + frame.proof[best], Infinity));
+            }
+
+            const Move move = frame.moves[best];
+            board.makeMove(move);
+            mid(board, ply + 1, childProof, childDisproof);
+            board.undoMove(move);
+            if (stopped) {
+                return;
+            }
+        }
+    }
+
+    Result Solver::solve(const Board& position, const Limits& searchLimits) {
+        limits = searchLimits;
+        maxPly = limits.mateIn > 0 ? std::min(2 * limits.mateIn - 1, Search::MaxPly) : Search::MaxPly;
+        stopRequested.store(false, std::memory_order_relaxed);
+        stopped = false;
+        nodes = 0;
+        startTime = std::chrono::steady_clock::now();
+
+        Board board = position;
+        board.setKeyHistory(nullptr);
+        mid(board, 0, Infinity, Infinity);
+
+        Result result{};
+        uint32_t proof, disproof;
+        uint16_t distance;
+        lookup(board.getKey(), maxPly, proof, disproof, distance);
+        result.proven = !stopped && proof == 0;
+        result.disproven = !stopped && disproof == 0;
+        result.nodes = nodes;
+
+        // The line the proof holds: the quickest mate at attacker nodes, the longest defence
+        // at defender nodes, for as long as the entries are still in the table
+        if (result.proven) {
+            result.mateIn = (distance + 1) / 2;
+            for (int ply = 0; ply < maxPly; ++ply) {
+                int count = expand(board, ply);
+                bool attacker = (ply & 1) == 0;
+                int best = -1;
+                uint16_t bestDistance = 0;
+                for (int i = 0; i < count; ++i) {
+                    uint16_t childDistance;
+                    lookup(frames[ply].keys[i], maxPly - ply - 1, proof, disproof, childDistance);
+                    if (proof != 0) {
+                        continue;
+                    }
+                    if (best < 0 || (attacker ? childDistance < bestDistance : childDistance > bestDistance)) {
+                        best = i;
+                        bestDistance = childDistance;
+                    }
+                }
+                if (best < 0) {
+                    break;
+                }
+                result.pv.push_back(frames[ply].moves[best]);
+                board.makeMove(frames[ply].moves[best]);
+            }
+        }
+        result.timeMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - startTime).count();
+        return result;
+    }
+
+    const std::vector<Problem>& suite() {
+        static const std::vector<Problem> problems = {
+            {"back rank", "6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1", 1},
+            {"legal", "r2qkbnr/ppp2ppp/2np4/4N3/2B1P1b1/2N5/PPPP1PPP/R1BbK2R w KQkq - 0 6", 2},
+            {"boden", "2kr1b1r/pp1npppp/2p1bn2/7q/5B2/2NB1Q1P/PPP1N1P1/2KR3R w - - 0 1", 2},
+            {"opera", "4kb1r/p2n1ppp/4q3/4p1B1/4P3/1Q6/PPP2PPP/2KR4 w k - 1 16", 2},
+            {"reti", "rnb1kb1r/pp3ppp/2p5/4q3/4n3/3Q4/PPPB1PPP/2KR1BNR w kq - 0 9", 3},
+            {"queen corner", "k7/8/8/2K5/8/8/8/6Q1 w - - 0 1", 2},
+            {"rook corner", "k7/8/8/3K4/8/8/8/7R w - - 0 1", 3},
+            {"philidor", "5rk1/6pp/8/6N1/8/8/6PP/3Q2K1 w - - 0 1", 5},
+            {"lasker thomas", "rn3rk1/pbppq1pp/1p2pb2/4N2Q/3PN3/3B4/PPP2PPP/R3K2R w KQ - 1 11", 7},
+            {"king hunt", "r1b1kb1r/pppp1ppp/5q2/4n3/3KP3/2N3PN/PPP4P/R1BQ1B1R b kq - 0 1", 3},
+            {"queen ending", "8/8/8/8/2k5/8/8/K6Q w - - 0 1", 9},
+        };
+        return problems;
+    }
+
+    namespace {
+        std::string formatLine(const std::vector<Move>& pv) {
+            std::string line;
+            for (const Move& move : pv) {
+                line += (line.empty() ? "" : " ") + move.toString();
+            }
+            return line;
+        }
+
+        // Time for the main search to report a mate in at most mateIn moves, or -1 if it does
+        // not within the time limit
+        int64_t searchTimeToMate(const Board& board, int mateIn, int64_t moveTime, uint64_t& nodes) {
+            TranspositionTable table(16);
+            Search::Searcher searcher(table);
+            Search::Limits limits;
+            limits.moveTime = moveTime;
+            int64_t found = -1;
+            nodes = 0;
+            searcher.search(board, limits, [&](const Search::Info& info) {
+                nodes = info.nodes;
+                if (found < 0 && info.score > Search::MateBound && (Search::MateScore - info.score + 1) / 2 <= mateIn) {
+                    found = info.timeMs;
+                    searcher.stop();
+                }
+            });
+            return found;
+        }
+    }
+
+    int runCommand(const std::vector<std::string>& args) {
+        std::string fen;
+        Limits limits;
+        size_t megabytes = 64;
+        bool compare = false;
+        for (size_t i = 0; i < args.size(); ++i) {
+            bool hasValue = i + 1 < args.size();
+            if (args[i] == "--fen" && hasValue) {
+                fen = args[++i];
+            } else if (args[i] == "--mate" && hasValue) {
+                limits.mateIn = std::max(0, std::stoi(args[++i]));
+            } else if (args[i] == "--checks-only") {
+                limits.checksOnly = true;
+            } else if (args[i] == "--nodes" && hasValue) {
+                limits.nodes = std::stoull(args[++i]);
+            } else if (args[i] == "--movetime" && hasValue) {
+                limits.moveTime = std::stoll(args[++i]);
+            } else if (args[i] == "--hash" && hasValue) {
+                megabytes = std::max<size_t>(1, std::stoul(args[++i]));
+            } else if (args[i] == "--compare") {
+                compare = true;
+            } else {
+                std::cerr << "mate: unknown option " << args[i] << std::endl;
+                return 1;
+            }
+        }
+
+        std::vector<Problem> problems;
+        if (!fen.empty()) {
+            problems.push_back({"position", fen.c_str(), limits.mateIn});
+        } else {
+            problems = suite();
+        }
+
+        Solver solver(megabytes);
+        uint64_t totalNodes = 0, searchNodes = 0;
+        int64_t totalMs = 0, searchMs = 0;
+        int solved = 0, searchSolved = 0;
+        for (const Problem& problem : problems) {
+            Board board;
+            if (!board.loadFen(problem.fen)) {
+                std::cerr << "mate: invalid fen " << problem.fen << std::endl;
+                return 1;
+            }
+            Limits problemLimits = limits;
+            if (fen.empty()) {
+                problemLimits.mateIn = problem.mateIn;
+            }
+            solver.clear();
+            Result result = solver.solve(board, problemLimits);
+            totalNodes += result.nodes;
+            totalMs += result.timeMs;
+            solved += result.proven;
+
+            std::cout << std::left << std::setw(16) << problem.name << std::right
+                      << (result.proven ? " mate " + std::to_string(result.mateIn)
+                                        : result.disproven ? " no mate" : " unknown")
+                      << " nodes " << result.nodes << " time " << result.timeMs << " ms";
+            if (compare) {
+                uint64_t nodes;
+                int64_t found = searchTimeToMate(board, result.proven ? result.mateIn : problem.mateIn,
+                                                 limits.moveTime > 0 ? limits.moveTime : 10000, nodes);
+                searchNodes += nodes;
+                searchMs += found < 0 ? (limits.moveTime > 0 ? limits.moveTime : 10000) : found;
+                searchSolved += found >= 0;
+                std::cout << " | search " << (found < 0 ? "not found" : std::to_string(found) + " ms")
+                          << " nodes " << nodes;
+            }
+            std::cout << (result.proven ? " pv " + formatLine(result.pv) : "") << std::endl;
+        }
+
+        std::cout << "solved " << solved << "/" << problems.size() << " nodes " << totalNodes
+                  << " time " << totalMs << " ms";
+        if (compare) {
+            std::cout << " | search solved " << searchSolved << "/" << problems.size() << " nodes " << searchNodes
+                      << " time " << searchMs << " ms";
+        }
+        std::cout << std::endl;
+        return 0;
+    }
+}
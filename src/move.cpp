@@ -1,4 +1,6 @@
 #include "move.h"
+#include <cctype>
+#include <cstring>
 #include <string>
 
 std::string Move::toString() const
@@ -9,7 +11,60 @@ std::string Move::toString() const
     result += char('a' + targetSquare % 8);
     result += char('1' + targetSquare / 8);
     if (isPromotion) {
-        result += "q";
+        const char promotionLetters[] = " pnbrqk";
+        result += promotionPiece >= Knight && promotionPiece <= Queen ? promotionLetters[promotionPiece] : 'q';
     }
     return result;
-}
\ No newline at end of file
+}
+
+uint16_t parseMove(const std::string& text)
+{
+    size_t i = 0;
+    if (i < text.size() && text[i] && std::strchr("NBRQK", text[i])) {
+        ++i;  // Piece letter of long algebraic notation
+    }
+    auto square = [&](int& result) {
+        if (i + 1 >= text.size() || text[i] < 'a' || text[i] > 'h' || text[i + 1] < '1' || text[i + 1] > '8') {
+            return false;
+        }
+        result = (text[i + 1] - '1') * 8 + (text[i] - 'a');
+        i += 2;
+        return true;
+    };
+
+    int source, target;
+    if (!square(source)) {
+        return 0;
+    }
+    if (i < text.size() && (text[i] == '-' || text[i] == 'x')) {
+        ++i;
+    }
+    if (!square(target) || source == target) {
+        return 0;
+    }
+
+    int promotion = 0;
+    bool promotionMarked = i < text.size() && text[i] == '=';
+    if (promotionMarked) {
+        ++i;
+    }
+    if (promotionMarked || (i < text.size() && text[i] != '+' && text[i] != '#')) {
+        if (i == text.size()) {
+            return 0;
+        }
+        const char* letters = "nbrq";
+        const char* found = std::strchr(letters, std::tolower(static_cast<unsigned char>(text[i])));
+        if (!found || !*found) {
+            return 0;
+        }
+        promotion = Knight + static_cast<int>(found - letters);
+        ++i;
+    }
+    if (i < text.size() && (text[i] == '+' || text[i] == '#')) {
+        ++i;
+    }
+    if (i != text.size()) {
+        return 0;
+    }
+    return static_cast<uint16_t>(source | (target << 6) | (promotion << 12));
+}
@@ -1,52 +1,27 @@
 #include "move_generation.h"
 #include "board.h"
 #include "move.h"
+#include "stats.h"
+#include "trace.h"
+#include <cstdlib>
 #include <iostream>
 #include <cstdint>
 #include <vector>
 
 // Namespace for clarity
 namespace MoveGeneration {
-    uint64_t knightAttacks[64];  // Precomputed knight attacks
-    void precomputeKnightAttacks();   // Add function declaration
     uint64_t generateBishopMovesFromSquare(int square, uint64_t blockers);
     uint64_t generateRookMovesFromSquare(int square, uint64_t blockers);
     uint64_t generateKingMovesFromSquare(int square, uint64_t blockers);
 
-    // Square under attack
+    // Square under attack by side By, read from the board's attack map
+    template <PieceColor By>
+    bool isSquareAttacked(int square, const Board& board) {
+        return board.isAttacked(square, By);
+    }
+
     bool isSquareAttacked(int square, const Board& board, bool byWhite) {
-        uint64_t attackers = byWhite ? board.getWhitePieces() : board.getBlackPieces();
-        uint64_t pawns = byWhite ? board.getWhitePawns() : board.getBlackPawns();
-        uint64_t knights = byWhite ? board.getWhiteKnights() : board.getBlackKnights();
-        uint64_t bishops = byWhite ? board.getWhiteBishops() : board.getBlackBishops();
-        uint64_t rooks = byWhite ? board.getWhiteRooks() : board.getBlackRooks();
-        uint64_t queens = byWhite ? board.getWhiteQueens() : board.getBlackQueens();
-        uint64_t king = byWhite ? board.getWhiteKing() : board.getBlackKing();
-
-        // Pawn attacks
-        uint64_t pawnAttacks = byWhite
-            ? ((pawns & 0xFEFEFEFEFEFEFEFE) >> 9) | ((pawns & 0x7F7F7F7F7F7F7F7F) >> 7)
-            : ((pawns & 0xFEFEFEFEFEFEFEFE) << 7) | ((pawns & 0x7F7F7F7F7F7F7F7F) << 9);
-
-        if (pawnAttacks & (1ULL << square)) return true;
-
-        // Knight attacks
-        precomputeKnightAttacks();
-        if (knightAttacks[square] & knights) return true;
-
-        // Bishop/Queen diagonal attacks
-        uint64_t bishopMoves = generateBishopMovesFromSquare(square, board.getOccupiedSquares());
-        if (bishopMoves & (bishops | queens)) return true;
-
-        // Rook/Queen straight attacks
-        uint64_t rookMoves = generateRookMovesFromSquare(square, board.getOccupiedSquares());
-        if (rookMoves & (rooks | queens)) return true;
-
-        // King attacks
-        uint64_t kingAttacks = generateKingMovesFromSquare(square, board.getOccupiedSquares());
-        if (kingAttacks & king) return true;
-
-        return false;
+        return byWhite ? isSquareAttacked<White>(square, board) : isSquareAttacked<Black>(square, board);
     }
 
     int firstSetBit(uint64_t x) {
@@ -56,40 +31,53 @@ namespace MoveGeneration {
         return -1; // No bits set
     }
 
+    template <PieceColor Us>
+    bool isKingSafe(const Board& board) {
+        return !(board.getAttacks(ColorTraits<Us>::Them) & board.getPieces<Us>(King));
+    }
+
     bool isKingSafe(const Board& board, bool isWhite) {
-        int kingSquare = firstSetBit(isWhite ? board.getWhiteKing() : board.getBlackKing()) - 1;
-        return !isSquareAttacked(kingSquare, board, !isWhite);
+        return isWhite ? isKingSafe<White>(board) : isKingSafe<Black>(board);
     }
 
-    bool isMoveLegal(const Board& board, const Move& move, bool isWhite) {
-        // Create a temporary board to simulate the move
+    template <PieceColor Us>
+    bool isMoveLegal(const Board& board, const Move& move) {
+        STATS_INC(LegalityChecks);
+
+        // Create a temporary board to simulate the move, detached from the key history
         Board tempBoard = board;
+        tempBoard.setKeyHistory(nullptr);
         tempBoard.makeMove(move);  // Simulate the move
 
         // Check if the king is in check after the move
-        bool kingSafe = isKingSafe(tempBoard, isWhite);
+        bool kingSafe = isKingSafe<Us>(tempBoard);
 
         // If castling, ensure the king does not pass through or land in check
         if (move.isCastling) {
-            int kingSource = isWhite ? 4 : 60; // e1 or e8
+            int kingSource = ColorTraits<Us>::KingStart;
             int kingTarget = move.targetSquare;
             int midSquare = (kingSource + kingTarget) / 2;
 
-            uint64_t opponentAttacks = board.generateOpponentAttacks(!isWhite);
+            uint64_t opponentAttacks = board.generateOpponentAttacks<Us>();
             if (opponentAttacks & ((1ULL << kingSource) | (1ULL << midSquare) | (1ULL << kingTarget))) {
                 kingSafe = false;
             }
         }
 
-        tempBoard.undoMove(move); // Undo the move
         return kingSafe;
     }
 
-    std::vector<Move> filterLegalMoves(const Board& board, const std::vector<Move>& moves, bool isWhite) {
+    bool isMoveLegal(const Board& board, const Move& move, bool isWhite) {
+        return isWhite ? isMoveLegal<White>(board, move) : isMoveLegal<Black>(board, move);
+    }
+
+    template <PieceColor Us>
+    std::vector<Move> filterLegalMoves(const Board& board, const std::vector<Move>& moves) {
         std::vector<Move> legalMoves;
+        legalMoves.reserve(moves.size());
 
         for (const Move& move : moves) {
-            if (isMoveLegal(board, move, isWhite)) {
+            if (isMoveLegal<Us>(board, move)) {
                 legalMoves.push_back(move);
             }
         }
@@ -97,47 +85,33 @@ namespace MoveGeneration {
         return legalMoves;
     }
 
-    // Generate all pawn moves, including captures and en passant
-    void generatePawnMoves(const uint64_t& pawns, const uint64_t& emptySquares, const uint64_t& opponentPieces, uint64_t enPassantSquare, uint64_t& moves, uint64_t& captures, bool isWhite) {
-        moves = 0ULL;
-        captures = 0ULL;
+    std::vector<Move> filterLegalMoves(const Board& board, const std::vector<Move>& moves, bool isWhite) {
+        return isWhite ? filterLegalMoves<White>(board, moves) : filterLegalMoves<Black>(board, moves);
+    }
 
-        if (isWhite) {
-            // Single forward moves for White
-            moves |= (pawns << 8) & emptySquares;
+    std::vector<Move> legalMoves(const Board& board) {
+        bool isWhite = board.isWhiteToMove();
+        return filterLegalMoves(board, board.generateMoves(isWhite), isWhite);
+    }
 
-            // Double forward moves for White (from starting rank)
-            moves |= ((pawns & 0x000000000000FF00ULL) << 16) & (emptySquares << 8);
+    // Generate all pawn moves, including captures and en passant
+    template <PieceColor Us>
+    void generatePawnMoves(const uint64_t& pawns, const uint64_t& emptySquares, const uint64_t& opponentPieces, uint64_t enPassantSquare, uint64_t& moves, uint64_t& captures) {
+        using Traits = ColorTraits<Us>;
 
-            // Left diagonal captures for White
-            captures |= (pawns & 0x7F7F7F7F7F7F7F7F) << 7 & opponentPieces;
+        // Single pushes, then double pushes through an empty square on the third rank
+        uint64_t singlePushes = shift<Traits::Up>(pawns) & emptySquares;
+        moves = singlePushes | (shift<Traits::Up>(singlePushes & Traits::SinglePushRank) & emptySquares);
 
-            // Right diagonal captures for White
-            captures |= (pawns & 0xFEFEFEFEFEFEFEFE) << 9 & opponentPieces;
+        // Diagonal captures, including the en passant target
+        captures = pawnAttacks<Us>(pawns) & (opponentPieces | enPassantSquare);
+    }
 
-            // En passant captures for White
-            if (enPassantSquare) {
-                captures |= ((pawns & 0x7F7F7F7F7F7F7F7F) << 7 & enPassantSquare);
-                captures |= ((pawns & 0xFEFEFEFEFEFEFEFE) << 9 & enPassantSquare);
-            }
+    void generatePawnMoves(const uint64_t& pawns, const uint64_t& emptySquares, const uint64_t& opponentPieces, uint64_t enPassantSquare, uint64_t& moves, uint64_t& captures, bool isWhite) {
+        if (isWhite) {
+            generatePawnMoves<White>(pawns, emptySquares, opponentPieces, enPassantSquare, moves, captures);
         } else {
-            // Single forward moves for Black
-            moves |= (pawns >> 8) & emptySquares;
-
-            // Double forward moves for Black (from starting rank)
-            moves |= ((pawns & 0x00FF000000000000ULL) >> 16) & (emptySquares >> 8);
-
-            // Left diagonal captures for Black
-            captures |= (pawns & 0xFEFEFEFEFEFEFEFE) >> 9 & opponentPieces;
-
-            // Right diagonal captures for Black
-            captures |= (pawns & 0x7F7F7F7F7F7F7F7F) >> 7 & opponentPieces;
-
-            // En passant captures for Black
-            if (enPassantSquare) {
-                captures |= ((pawns & 0xFEFEFEFEFEFEFEFE) >> 9 & enPassantSquare);
-                captures |= ((pawns & 0x7F7F7F7F7F7F7F7F) >> 7 & enPassantSquare);
-            }
+            generatePawnMoves<Black>(pawns, emptySquares, opponentPieces, enPassantSquare, moves, captures);
         }
     }
 
@@ -148,41 +122,14 @@ namespace MoveGeneration {
         captures = 0ULL;
 
         // Left diagonal captures (including en passant)
-        uint64_t leftCapture = (pawns & 0x7F7F7F7F7F7F7F7F) << 7;
+        uint64_t leftCapture = (pawns & 0xFEFEFEFEFEFEFEFE) << 7;
         captures |= (leftCapture & opponentPawns) | (leftCapture & enPassantSquare);
 
         // Right diagonal captures (including en passant)
-        uint64_t rightCapture = (pawns & 0xFEFEFEFEFEFEFEFE) << 9;
+        uint64_t rightCapture = (pawns & 0x7F7F7F7F7F7F7F7F) << 9;
         captures |= (rightCapture & opponentPawns) | (rightCapture & enPassantSquare);
     }
 
-    // Precompute all possible knight attack masks
-    void precomputeKnightAttacks() {
-        for (int square = 0; square < 64; ++square) {
-            uint64_t attack = 0ULL;
-            int rank = square / 8;
-            int file = square % 8;
-
-            // Knight move offsets
-            int knightOffsets[8][2] = {
-                {2, 1}, {1, 2}, {-1, 2}, {-2, 1},
-                {-2, -1}, {-1, -2}, {1, -2}, {2, -1}
-            };
-
-            for (int i = 0; i < 8; ++i) {
-                int targetRank = rank + knightOffsets[i][0];
-                int targetFile = file + knightOffsets[i][1];
-
-                // Ensure the target position is on the board
-                if (targetRank >= 0 && targetRank < 8 && targetFile >= 0 && targetFile < 8) {
-                    int targetSquare = targetRank * 8 + targetFile;
-                    attack |= (1ULL << targetSquare); // Set the bit
-                }
-            }
-            knightAttacks[square] = attack;
-        }
-    }
-
     // Generate knight moves
     void generateKnightMoves(const uint64_t& knights, const uint64_t& ownPieces, const uint64_t& opponentPieces, uint64_t& moves, uint64_t& captures) {
         moves = 0ULL;
@@ -289,6 +236,10 @@ namespace MoveGeneration {
         captures = bishopCaptures | rookCaptures;
     }
 
+    uint64_t generateQueenMovesFromSquare(int square, uint64_t blockers) {
+        return generateBishopMovesFromSquare(square, blockers) | generateRookMovesFromSquare(square, blockers);
+    }
+
     // Generate king moves
     void generateKingMoves(const uint64_t& king, const uint64_t& ownPieces, const uint64_t& opponentPieces, const uint64_t& occupied, uint64_t& moves, uint64_t& captures) {
         moves = 0ULL;
@@ -296,7 +247,7 @@ namespace MoveGeneration {
 
         for (int square = 0; square < 64; ++square) {
             if (king & (1ULL << square)) {
-                uint64_t potentialMoves = generateKingMovesFromSquare(square, occupied);
+                uint64_t potentialMoves = generateKingMovesFromSquare(square, ownPieces);
                 moves |= potentialMoves & ~ownPieces; // Exclude own pieces
                 captures |= potentialMoves & opponentPieces; // Include opponent pieces
             }
@@ -324,27 +275,51 @@ namespace MoveGeneration {
     }
 
     // Generate castling moves
-    void generateCastlingMoves(const Board& board, std::vector<Move>& moves, bool isWhite) {
-        uint64_t opponentAttacks = board.generateOpponentAttacks(!isWhite);
+    template <PieceColor Us, typename MoveContainer>
+    void generateCastlingMoves(const Board& board, MoveContainer& moves) {
+        constexpr bool IsWhite = ColorTraits<Us>::IsWhite;
+        constexpr int KingStart = ColorTraits<Us>::KingStart;
+        constexpr int RankShift = IsWhite ? 0 : 56;  // Masks below are written for the first rank
+
+        bool canCastleKingSide = IsWhite ? board.canWhiteCastleKingSide() : board.canBlackCastleKingSide();
+        bool canCastleQueenSide = IsWhite ? board.canWhiteCastleQueenSide() : board.canBlackCastleQueenSide();
+        if (!canCastleKingSide && !canCastleQueenSide) {
+            return;
+        }
+
+        uint64_t opponentAttacks = board.generateOpponentAttacks<Us>();
         uint64_t occupied = board.getOccupiedSquares();
 
+        if (canCastleKingSide && !(occupied & (0x60ULL << RankShift)) && !(opponentAttacks & (0x70ULL << RankShift))) {
+            moves.emplace_back(Move(KingStart, KingStart + 2, PieceType::King, false, false, true));
+        }
+        if (canCastleQueenSide && !(occupied & (0xEULL << RankShift)) && !(opponentAttacks & (0x1CULL << RankShift))) {
+            moves.emplace_back(Move(KingStart, KingStart - 2, PieceType::King, false, false, true));
+        }
+    }
+
+    void generateCastlingMoves(const Board& board, std::vector<Move>& moves, bool isWhite) {
         if (isWhite) {
-            if (board.canWhiteCastleKingSide() && !(occupied & 0x60ULL) && !(opponentAttacks & 0x70ULL)) {
-                moves.emplace_back(Move(4, 6, PieceType::King, false, false, true));
-            }
-            if (board.canWhiteCastleQueenSide() && !(occupied & 0xEULL) && !(opponentAttacks & 0x1CULL)) {
-                moves.emplace_back(Move(4, 2, PieceType::King, false, false, true));
-            }
+            generateCastlingMoves<White>(board, moves);
         } else {
-            if (board.canBlackCastleKingSide() && !(occupied & 0x6000000000000000ULL) && !(opponentAttacks & 0x7000000000000000ULL)) {
-                moves.emplace_back(Move(60, 62, PieceType::King, false, false, true));
-            }
-            if (board.canBlackCastleQueenSide() && !(occupied & 0x0E00000000000000ULL) && !(opponentAttacks & 0x1C00000000000000ULL)) {
-                moves.emplace_back(Move(60, 58, PieceType::King, false, false, true));
-            }
+            generateCastlingMoves<Black>(board, moves);
         }
     }
 
+    template void generatePawnMoves<White>(const uint64_t&, const uint64_t&, const uint64_t&, uint64_t, uint64_t&, uint64_t&);
+    template void generatePawnMoves<Black>(const uint64_t&, const uint64_t&, const uint64_t&, uint64_t, uint64_t&, uint64_t&);
+    template void generateCastlingMoves<White>(const Board&, std::vector<Move>&);
+    template void generateCastlingMoves<Black>(const Board&, std::vector<Move>&);
+    template void generateCastlingMoves<White>(const Board&, MoveList&);
+    template void generateCastlingMoves<Black>(const Board&, MoveList&);
+    template bool isSquareAttacked<White>(int, const Board&);
+    template bool isSquareAttacked<Black>(int, const Board&);
+    template bool isKingSafe<White>(const Board&);
+    template bool isKingSafe<Black>(const Board&);
+    template bool isMoveLegal<White>(const Board&, const Move&);
+    template bool isMoveLegal<Black>(const Board&, const Move&);
+    template std::vector<Move> filterLegalMoves<White>(const Board&, const std::vector<Move>&);
+    template std::vector<Move> filterLegalMoves<Black>(const Board&, const std::vector<Move>&);
 
     // Helper function to check if a move would cross board boundaries
     bool outOfBounds(int startSquare, int targetSquare, int direction) {
@@ -353,18 +328,23 @@ namespace MoveGeneration {
         int targetRank = targetSquare / 8;
         int targetFile = targetSquare % 8;
 
-        // Check for wrapping around the board
+        // Check for wrapping around the board: a single step never changes file by more than one
         if (direction == 1 || direction == -1) {  // Horizontal moves
             return startRank != targetRank;
         }
-        return false;  // Vertical and diagonal moves don't need this check
+        return std::abs(targetFile - startFile) > 1;  // Diagonal steps that wrapped to the other edge
+    }
+
+    // Prints a labelled bitboard when bitboard tracing is compiled in
+    static void traceBitboard(const char* label, uint64_t bitboard) {
+        ENGINE_TRACE(TRACE_BITBOARDS, std::cout << label << std::endl; Board::displayBitboard(bitboard));
     }
 
-    // Generate all legal moves for the current board
+    // Generate every piece's moves for both sides and dump them (visible at ENGINE_TRACE_LEVEL >= 2)
     void generateAllMoves(const Board& board) {
         std::vector<Move> allMoves; // Vector to store all generated moves
 
-        std::cout << "Generating moves for WHITE pieces" << std::endl;
+        ENGINE_TRACE(TRACE_BITBOARDS, std::cout << "Generating moves for WHITE pieces" << std::endl);
 
         // Generate White pawn moves and captures
         uint64_t whitePawnMoves = 0, whitePawnCaptures = 0;
@@ -377,17 +357,14 @@ namespace MoveGeneration {
             whitePawnCaptures,
             true
         );
-        std::cout << "White Pawn Moves:" << std::endl;
-        board.displayBitboard(whitePawnMoves);
-        std::cout << "White Pawn Captures:" << std::endl;
-        board.displayBitboard(whitePawnCaptures);
+        traceBitboard("White Pawn Moves:", whitePawnMoves);
+        traceBitboard("White Pawn Captures:", whitePawnCaptures);
 
         // Generate White castling moves
         generateCastlingMoves(board, allMoves, true);
-        std::cout << "White Castling Moves:" << std::endl;
-        for (const Move& move : allMoves) {
-            std::cout << move.toString() << std::endl;
-        }
+        ENGINE_TRACE(TRACE_BITBOARDS,
+            std::cout << "White Castling Moves:" << std::endl;
+            for (const Move& move : allMoves) std::cout << move.toString() << std::endl);
 
         // Generate White knight moves and captures
         uint64_t whiteKnightMoves = 0, whiteKnightCaptures = 0;
@@ -398,38 +375,28 @@ namespace MoveGeneration {
             whiteKnightMoves,
             whiteKnightCaptures
         );
-        std::cout << "White Knight Moves:" << std::endl;
-        board.displayBitboard(whiteKnightMoves);
-        std::cout << "White Knight Captures:" << std::endl;
-        board.displayBitboard(whiteKnightCaptures);
+        traceBitboard("White Knight Moves:", whiteKnightMoves);
+        traceBitboard("White Knight Captures:", whiteKnightCaptures);
 
         // Generate moves for other White pieces (bishops, rooks, queens, king)
         uint64_t moves = 0, captures = 0;
         generateBishopMoves(board.getWhiteBishops(), board.getWhitePieces(), board.getBlackPieces(), board.getOccupiedSquares(), moves, captures);
-        std::cout << "White Bishop Moves:" << std::endl;
-        board.displayBitboard(moves);
-        std::cout << "White Bishop Captures:" << std::endl;
-        board.displayBitboard(captures);
+        traceBitboard("White Bishop Moves:", moves);
+        traceBitboard("White Bishop Captures:", captures);
 
         generateRookMoves(board.getWhiteRooks(), board.getWhitePieces(), board.getBlackPieces(), board.getOccupiedSquares(), moves, captures);
-        std::cout << "White Rook Moves:" << std::endl;
-        board.displayBitboard(moves);
-        std::cout << "White Rook Captures:" << std::endl;
-        board.displayBitboard(captures);
+        traceBitboard("White Rook Moves:", moves);
+        traceBitboard("White Rook Captures:", captures);
 
         generateQueenMoves(board.getWhiteQueens(), board.getWhitePieces(), board.getBlackPieces(), board.getOccupiedSquares(), moves, captures);
-        std::cout << "White Queen Moves:" << std::endl;
-        board.displayBitboard(moves);
-        std::cout << "White Queen Captures:" << std::endl;
-        board.displayBitboard(captures);
+        traceBitboard("White Queen Moves:", moves);
+        traceBitboard("White Queen Captures:", captures);
 
         generateKingMoves(board.getWhiteKing(), board.getWhitePieces(), board.getBlackPieces(), board.getOccupiedSquares(), moves, captures);
-        std::cout << "White King Moves:" << std::endl;
-        board.displayBitboard(moves);
-        std::cout << "White King Captures:" << std::endl;
-        board.displayBitboard(captures);
+        traceBitboard("White King Moves:", moves);
+        traceBitboard("White King Captures:", captures);
 
-        std::cout << "Generating moves for BLACK pieces" << std::endl;
+        ENGINE_TRACE(TRACE_BITBOARDS, std::cout << "Generating moves for BLACK pieces" << std::endl);
 
         // Generate Black pawn moves and captures
         uint64_t blackPawnMoves = 0, blackPawnCaptures = 0;
@@ -442,17 +409,14 @@ namespace MoveGeneration {
             blackPawnCaptures,
             false
         );
-        std::cout << "Black Pawn Moves:" << std::endl;
-        board.displayBitboard(blackPawnMoves);
-        std::cout << "Black Pawn Captures:" << std::endl;
-        board.displayBitboard(blackPawnCaptures);
+        traceBitboard("Black Pawn Moves:", blackPawnMoves);
+        traceBitboard("Black Pawn Captures:", blackPawnCaptures);
 
         // Generate Black castling moves
         generateCastlingMoves(board, allMoves, false);
-        std::cout << "Black Castling Moves:" << std::endl;
-        for (const Move& move : allMoves) {
-            std::cout << move.toString() << std::endl;
-        }
+        ENGINE_TRACE(TRACE_BITBOARDS,
+            std::cout << "Black Castling Moves:" << std::endl;
+            for (const Move& move : allMoves) std::cout << move.toString() << std::endl);
 
         // Generate Black knight moves and captures
         uint64_t blackKnightMoves = 0, blackKnightCaptures = 0;
@@ -463,35 +427,25 @@ namespace MoveGeneration {
             blackKnightMoves,
             blackKnightCaptures
         );
-        std::cout << "Black Knight Moves:" << std::endl;
-        board.displayBitboard(blackKnightMoves);
-        std::cout << "Black Knight Captures:" << std::endl;
-        board.displayBitboard(blackKnightCaptures);
+        traceBitboard("Black Knight Moves:", blackKnightMoves);
+        traceBitboard("Black Knight Captures:", blackKnightCaptures);
 
         // Generate moves for other Black pieces (bishops, rooks, queens, king)
         generateBishopMoves(board.getBlackBishops(), board.getBlackPieces(), board.getWhitePieces(), board.getOccupiedSquares(), moves, captures);
-        std::cout << "Black Bishop Moves:" << std::endl;
-        board.displayBitboard(moves);
-        std::cout << "Black Bishop Captures:" << std::endl;
-        board.displayBitboard(captures);
+        traceBitboard("Black Bishop Moves:", moves);
+        traceBitboard("Black Bishop Captures:", captures);
 
         generateRookMoves(board.getBlackRooks(), board.getBlackPieces(), board.getWhitePieces(), board.getOccupiedSquares(), moves, captures);
-        std::cout << "Black Rook Moves:" << std::endl;
-        board.displayBitboard(moves);
-        std::cout << "Black Rook Captures:" << std::endl;
-        board.displayBitboard(captures);
+        traceBitboard("Black Rook Moves:", moves);
+        traceBitboard("Black Rook Captures:", captures);
 
         generateQueenMoves(board.getBlackQueens(), board.getBlackPieces(), board.getWhitePieces(), board.getOccupiedSquares(), moves, captures);
-        std::cout << "Black Queen Moves:" << std::endl;
-        board.displayBitboard(moves);
-        std::cout << "Black Queen Captures:" << std::endl;
-        board.displayBitboard(captures);
+        traceBitboard("Black Queen Moves:", moves);
+        traceBitboard("Black Queen Captures:", captures);
 
         generateKingMoves(board.getBlackKing(), board.getBlackPieces(), board.getWhitePieces(), board.getOccupiedSquares(), moves, captures);
-        std::cout << "Black King Moves:" << std::endl;
-        board.displayBitboard(moves);
-        std::cout << "Black King Captures:" << std::endl;
-        board.displayBitboard(captures);
+        traceBitboard("Black King Moves:", moves);
+        traceBitboard("Black King Captures:", captures);
     }
 
     // Utility function to display moves and captures
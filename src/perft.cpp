@@ -0,0 +1,289 @@
+#include "perft.h"
+#include "leaf_kernel.h"
+#include "move_generation.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+namespace Perft {
+    namespace {
+        // Depth lives in the low byte of the data word, the node count above it
+        constexpr int DepthBits = 8;
+
+        struct WorkItem {
+            Board board;
+            size_t rootMove;
+            uint64_t nodes;
+        };
+
+        // Expands every legal line of length plies below the root into work items
+        void collectWorkItems(Board& board, int plies, size_t rootMove, std::vector<WorkItem>& items) {
+            if (plies == 0) {
+                items.push_back(WorkItem{board, rootMove, 0});
+                return;
+            }
+            for (const Move& move : MoveGeneration::legalMoves(board)) {
+                board.makeMove(move);
+                collectWorkItems(board, plies - 1, rootMove, items);
+                board.undoMove(move);
+            }
+        }
+
+        void printScalingTable(const Board& board, int depth, int maxThreads, int splitDepth, size_t hashMegabytes,
+                               bool copyMake) {
+            std::vector<int> threadCounts;
+            for (int threads = 1; threads < maxThreads; threads *= 2) {
+                threadCounts.push_back(threads);
+            }
+            threadCounts.push_back(maxThreads);
+
+            std::cout << std::setw(8) << "threads" << std::setw(16) << "nodes" << std::setw(12) << "seconds"
+                      << std::setw(16) << "nps" << std::setw(10) << "speedup" << std::endl;
+
+            double baseline = 0.0;
+            for (int threads : threadCounts) {
+                // A fresh table per run so no run benefits from an earlier one
+                std::unique_ptr<HashTable> table(hashMegabytes ? new HashTable(hashMegabytes) : nullptr);
+                auto start = std::chrono::steady_clock::now();
+                uint64_t nodes = parallelPerft(board, depth, threads, splitDepth, table.get(), nullptr, copyMake);
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                if (threads == 1) {
+                    baseline = seconds;
+                }
+                std::cout << std::setw(8) << threads << std::setw(16) << nodes
+                          << std::fixed << std::setprecision(3) << std::setw(12) << seconds
+                          << std::setprecision(0) << std::setw(16) << (seconds > 0 ? nodes / seconds : 0.0)
+                          << std::setprecision(2) << std::setw(10) << (seconds > 0 ? baseline / seconds : 0.0)
+                          << std::endl;
+            }
+        }
+    }
+
+    HashTable::HashTable(size_t megabytes, LargePages::Mode request) {
+        size_t count = 1;
+        while (count * 2 * sizeof(Entry) <= megabytes * 1024 * 1024) {
+            count *= 2;
+        }
+        memory = LargePages::Buffer(count * sizeof(Entry), request);
+        entries = static_cast<Entry*>(memory.data());
+        mask = count - 1;
+        clear();
+    }
+
+    bool HashTable::probe(uint64_t key, int depth, uint64_t& nodes) const {
+        const Entry& entry = entries[key & mask];
+        uint64_t data = entry.data.load(std::memory_order_relaxed);
+        uint64_t check = entry.check.load(std::memory_order_relaxed);
+        if ((check ^ data) != key || static_cast<int>(data & ((1ULL << DepthBits) - 1)) != depth) {
+            return false;
+        }
+        nodes = data >> DepthBits;
+        return true;
+    }
+
+    void HashTable::store(uint64_t key, int depth, uint64_t nodes) {
+        Entry& entry = entries[key & mask];
+        uint64_t data = (nodes << DepthBits) | static_cast<uint64_t>(depth);
+        entry.check.store(key ^ data, std::memory_order_relaxed);
+        entry.data.store(data, std::memory_order_relaxed);
+    }
+
+    void HashTable::clear() {
+        for (uint64_t i = 0; i <= mask; ++i) {
+            entries[i].check.store(0, std::memory_order_relaxed);
+            entries[i].data.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t perft(Board& board, int depth, HashTable* table) {
+        if (depth == 0) {
+            return 1;
+        }
+
+        uint64_t nodes = 0;
+        if (depth > 1 && table && table->probe(board.getKey(), depth, nodes)) {
+            return nodes;
+        }
+
+        std::vector<Move> moves = MoveGeneration::legalMoves(board);
+
+        // Bulk-count the last ply instead of making each move
+        if (depth == 1) {
+            return moves.size();
+        }
+
+        for (const Move& move : moves) {
+            board.makeMove(move);
+            nodes += perft(board, depth - 1, table);
+            board.undoMove(move);
+        }
+
+        if (table) {
+            table->store(board.getKey(), depth, nodes);
+        }
+        return nodes;
+    }
+
+    uint64_t perftCopyMake(const Board& board, int depth, HashTable* table) {
+        if (depth == 0) {
+            return 1;
+        }
+
+        uint64_t nodes = 0;
+        if (depth > 1 && table && table->probe(board.getKey(), depth, nodes)) {
+            return nodes;
+        }
+
+        std::vector<Move> moves = MoveGeneration::legalMoves(board);
+        if (depth == 1) {
+            return moves.size();
+        }
+
+        for (const Move& move : moves) {
+            Board child = board;
+            child.makeMove(move);
+            nodes += perftCopyMake(child, depth - 1, table);
+        }
+
+        if (table) {
+            table->store(board.getKey(), depth, nodes);
+        }
+        return nodes;
+    }
+
+    uint64_t parallelPerft(const Board& board, int depth, int threads, int splitDepth, HashTable* table,
+                           std::vector<std::pair<std::string, uint64_t>>* divide, bool copyMake) {
+        if (depth <= 0) {
+            return 1;
+        }
+
+        // Detached from the caller's key history: the work items are copies of root, and
+        // copies share the history they were copied with, which the workers would all write to
+        Board root = board;
+        root.setKeyHistory(nullptr);
+        std::vector<Move> rootMoves = MoveGeneration::legalMoves(root);
+
+        // Split at least one ply deep (so divide has its per-move counts) but never at the leaves
+        int plies = std::max(1, std::min(splitDepth, depth - 1));
+        std::vector<WorkItem> items;
+        for (size_t i = 0; i < rootMoves.size(); ++i) {
+            root.makeMove(rootMoves[i]);
+            collectWorkItems(root, plies - 1, i, items);
+            root.undoMove(rootMoves[i]);
+        }
+
+        std::atomic<size_t> next(0);
+        auto worker = [&]() {
+            for (size_t index = next.fetch_add(1); index < items.size(); index = next.fetch_add(1)) {
+                WorkItem& item = items[index];
+                item.nodes = copyMake ? perftCopyMake(item.board, depth - plies, table)
+                                      : perft(item.board, depth - plies, table);
+            }
+        };
+
+        std::vector<std::thread> pool;
+        for (int i = 1; i < threads; ++i) {
+            pool.emplace_back(worker);
+        }
+        worker();
+        for (std::thread& thread : pool) {
+            thread.join();
+        }
+
+        std::vector<uint64_t> rootCounts(rootMoves.size(), 0);
+        for (const WorkItem& item : items) {
+            rootCounts[item.rootMove] += item.nodes;
+        }
+
+        uint64_t total = 0;
+        for (size_t i = 0; i < rootMoves.size(); ++i) {
+            total += rootCounts[i];
+            if (divide) {
+                divide->emplace_back(rootMoves[i].toString(), rootCounts[i]);
+            }
+        }
+        return total;
+    }
+
+    int runCommand(const std::vector<std::string>& args) {
+        if (args.empty()) {
+            std::cerr << "usage: perft <depth> [--threads N] [--split D] [--hash MB] [--fen FEN] [--divide] [--scaling] [--copy-make] [--leaf-kernel]" << std::endl;
+            return 1;
+        }
+
+        int depth = std::stoi(args[0]);
+        int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        int splitDepth = 2;
+        size_t hashMegabytes = 64;
+        std::string fen;
+        bool showDivide = false;
+        bool scaling = false;
+        bool copyMake = false;
+        bool leafKernel = false;
+
+        for (size_t i = 1; i < args.size(); ++i) {
+            if (args[i] == "--threads" && i + 1 < args.size()) {
+                threads = std::max(1, std::stoi(args[++i]));
+            } else if (args[i] == "--split" && i + 1 < args.size()) {
+                splitDepth = std::max(1, std::stoi(args[++i]));
+            } else if (args[i] == "--hash" && i + 1 < args.size()) {
+                hashMegabytes = static_cast<size_t>(std::stoul(args[++i]));
+            } else if (args[i] == "--fen" && i + 1 < args.size()) {
+                fen = args[++i];
+            } else if (args[i] == "--divide") {
+                showDivide = true;
+            } else if (args[i] == "--scaling") {
+                scaling = true;
+            } else if (args[i] == "--copy-make") {
+                copyMake = true;
+            } else if (args[i] == "--leaf-kernel") {
+                leafKernel = true;
+            } else {
+                std::cerr << "perft: unknown option " << args[i] << std::endl;
+                return 1;
+            }
+        }
+
+        Board board;
+        board.initializePosition();
+        if (!fen.empty() && !board.loadFen(fen)) {
+            std::cerr << "perft: bad FEN " << fen << std::endl;
+            return 1;
+        }
+
+        if (scaling) {
+            printScalingTable(board, depth, threads, splitDepth, hashMegabytes, copyMake);
+            return 0;
+        }
+
+        // Single-threaded, unhashed, with the last ply counted by the multi-board kernel
+        if (leafKernel) {
+            auto start = std::chrono::steady_clock::now();
+            uint64_t nodes = LeafKernel::perft(board, depth);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::cout << "leaf kernel " << LeafKernel::pathName(LeafKernel::widest()) << std::endl;
+            std::cout << "nodes " << nodes << " time " << std::fixed << std::setprecision(3) << seconds
+                      << " nps " << std::setprecision(0) << (seconds > 0 ? nodes / seconds : 0.0) << std::endl;
+            return 0;
+        }
+
+        std::unique_ptr<HashTable> table(hashMegabytes ? new HashTable(hashMegabytes) : nullptr);
+        if (table) {
+            std::cout << "hash " << hashMegabytes << " MB, " << LargePages::modeName(table->pageMode()) << std::endl;
+        }
+        std::vector<std::pair<std::string, uint64_t>> divide;
+        auto start = std::chrono::steady_clock::now();
+        uint64_t nodes = parallelPerft(board, depth, threads, splitDepth, table.get(), showDivide ? &divide : nullptr,
+                                       copyMake);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        for (const auto& entry : divide) {
+            std::cout << entry.first << ": " << entry.second << std::endl;
+        }
+        std::cout << "nodes " << nodes << " time " << std::fixed << std::setprecision(3) << seconds
+                  << " nps " << std::setprecision(0) << (seconds > 0 ? nodes / seconds : 0.0) << std::endl;
+        return 0;
+    }
+}
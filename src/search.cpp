@@ -0,0 +1,532 @@
+#include "search.h"
+#include "evaluate.h"
+#include "move_generation.h"
+#include "stats.h"
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+
+namespace Search {
+    namespace {
+        // Mate scores are stored relative to the node so they stay valid at other plies
+        int scoreToTT(int score, int ply) {
+            if (score >= MateBound) return score + ply;
+            if (score <= -MateBound) return score - ply;
+            return score;
+        }
+
+        int scoreFromTT(int score, int ply) {
+            if (score >= MateBound) return score - ply;
+            if (score <= -MateBound) return score + ply;
+            return score;
+        }
+
+        bool hasNonPawnMaterial(const Board& board, bool isWhite) {
+            return isWhite
+                ? (board.getWhiteKnights() | board.getWhiteBishops() | board.getWhiteRooks() | board.getWhiteQueens()) != 0
+                : (board.getBlackKnights() | board.getBlackBishops() | board.getBlackRooks() | board.getBlackQueens()) != 0;
+        }
+
+        bool isQuiet(const Move& move) {
+            return !move.isCapture && !move.isPromotion;
+        }
+
+        // Swaps the highest scored remaining move into position index
+        void pickMove(MoveList& moves, int* scores, int index) {
+            int best = index;
+            for (int i = index + 1; i < moves.size(); ++i) {
+                if (scores[i] > scores[best]) {
+                    best = i;
+                }
+            }
+            std::swap(moves[index], moves[best]);
+            std::swap(scores[index], scores[best]);
+        }
+    }
+
+    std::string scoreToUci(int score) {
+        if (std::abs(score) >= MateBound) {
+            int movesToMate = (MateScore - std::abs(score) + 1) / 2;
+            return "mate " + std::to_string(score > 0 ? movesToMate : -movesToMate);
+        }
+        return "cp " + std::to_string(score);
+    }
+
+    Searcher::Searcher(TranspositionTable& table)
+        : tt(&table), stopRequested(false), stopped(false), timeBudget(0), nodes(0), selDepth(0),
+          frames(new Frame[MaxPly + 1]), copyMake(false), upcomingRepetition(true), rootMoveHint(0), profile(nullptr) {
+        // Everything search() touches is sized here, so the search itself never allocates
+        excludedRootMoves.reserve(MoveList::Capacity);
+        previousLines.reserve(MoveList::Capacity);
+        info.pv.reserve(MaxPly + 1);
+        clear();
+    }
+
+    void Searcher::clear() {
+        for (int ply = 0; ply <= MaxPly; ++ply) {
+            frames[ply].killers[0] = frames[ply].killers[1] = 0;
+        }
+        for (auto& side : history) {
+            for (auto& from : side) {
+                std::fill(std::begin(from), std::end(from), 0);
+            }
+        }
+    }
+
+    bool Searcher::shouldStop() {
+        if (stopRequested.load(std::memory_order_relaxed)) {
+            return true;
+        }
+        if (limits.nodes && nodes >= limits.nodes) {
+            return true;
+        }
+        if (timeBudget > 0) {
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - startTime).count();
+            return elapsed >= timeBudget;
+        }
+        return false;
+    }
+
+    // Plays a move from the position at ply: in place for make/unmake, or on a copy in the next
+    // stack slot for copy-make, leaving the parent untouched
+    Board& Searcher::playMove(Board& board, const Move& move, int ply) {
+        if (!copyMake) {
+            board.makeMove(move);
+            return board;
+        }
+        Board& child = positions[ply + 1];
+        child = board;
+        child.makeMove(move);
+        return child;
+    }
+
+    void Searcher::takeBack(Board& board, const Move& move) {
+        if (copyMake) {
+            keyHistory.pop();  // The child pushed onto the shared history; there is nothing else to undo
+        } else {
+            board.undoMove(move);
+        }
+    }
+
+    void Searcher::scoreMoves(const Board& board, const MoveList& moves, uint16_t ttMove, int ply, int* scores) const {
+        bool isWhite = board.isWhiteToMove();
+        const uint16_t* killers = frames[ply].killers;
+        for (int i = 0; i < moves.size(); ++i) {
+            const Move& move = moves[i];
+            uint16_t packed = move.pack();
+            int score;
+            if (packed == ttMove) {
+                score = 1000000;
+            } else if (move.isCapture) {
+                // MVV-LVA: most valuable victim first, least valuable attacker as tie-break
+                score = 100000 + 10 * Evaluation::PieceValues[move.capturedPiece]
+                      - Evaluation::PieceValues[board.getPieceAt(move.sourceSquare, isWhite)] / 10;
+            } else if (move.isPromotion) {
+                score = move.promotionPiece == Queen ? 95000 : 0;
+            } else if (packed == killers[0]) {
+                score = 80000;
+            } else if (packed == killers[1]) {
+                score = 70000;
+            } else {
+                score = history[isWhite ? White : Black][move.sourceSquare][move.targetSquare];
+            }
+            scores[i] = score;
+        }
+    }
+
+    Result Searcher::search(const Board& rootBoard, const Limits& newLimits,
+                            const std::function<void(const Info&)>& onIteration) {
+        limits = newLimits;
+        stopRequested.store(false, std::memory_order_relaxed);
+        stopped = false;
+        nodes = 0;
+        startTime = std::chrono::steady_clock::now();
+
+        // Time budget: a fixed move time, or a slice of the remaining clock
+        int side = rootBoard.isWhiteToMove() ? White : Black;
+        timeBudget = 0;
+        if (limits.moveTime > 0) {
+            timeBudget = limits.moveTime;
+        } else if (limits.time[side] > 0 && !limits.infinite) {
+            int movesToGo = limits.movesToGo > 0 ? limits.movesToGo : 30;
+            timeBudget = limits.time[side] / movesToGo + limits.increment[side] / 2;
+            timeBudget = std::max<int64_t>(1, std::min(timeBudget, limits.time[side] / 2));
+        }
+
+        // The search keeps its own copy of the game history and extends it along the current line
+        Board board = rootBoard;
+        if (rootBoard.getKeyHistory()) {
+            keyHistory = *rootBoard.getKeyHistory();
+        } else {
+            keyHistory.clear();
+        }
+        keyHistory.reserve(keyHistory.size() + MaxPly + 1);
+        board.setKeyHistory(&keyHistory);
+        Result result{false, Move(0, 0), 0, 0, 0};
+
+        // Fall back to any legal move so a best move is always available
+        bool isWhite = board.isWhiteToMove();
+        MoveList& rootMoves = frames[0].moves;
+        board.generateMoves(isWhite, rootMoves);
+        int legalRootMoves = 0;
+        for (const Move& move : rootMoves) {
+            if (MoveGeneration::isMoveLegal(board, move, isWhite)) {
+                if (legalRootMoves++ == 0) {
+                    result.bestMove = move;
+                }
+            }
+        }
+        if (legalRootMoves == 0) {
+            return result;
+        }
+        result.hasMove = true;
+
+        int lines = std::max(1, std::min(limits.multiPV, legalRootMoves));
+        previousLines.clear();
+        excludedRootMoves.clear();
+        if (profile) {
+            ++profile->searches;
+        }
+        for (int depth = std::max(1, limits.startDepth); depth <= std::min(limits.depth, MaxPly - 1); ++depth) {
+            previousLines.swap(excludedRootMoves);
+            excludedRootMoves.clear();
+            uint64_t iterationNodes = nodes;
+            uint64_t iterationQNodes = profile ? profile->total().qnodes : 0;
+            auto iterationStart = std::chrono::steady_clock::now();
+            for (int line = 0; line < lines; ++line) {
+                selDepth = 0;
+                // Later lines have no table move of their own at the root (it is the first line's);
+                // they try the move they started with in the previous iteration first
+                rootMoveHint = line > 0 && line < static_cast<int>(previousLines.size()) ? previousLines[line] : 0;
+                int score = alphaBeta(board, depth, 0, -Infinity, Infinity, false);
+
+                // A partial iteration is only trusted when there is nothing better
+                if (stopped && (depth > 1 || line > 0)) {
+                    break;
+                }
+                const Frame& root = frames[0];
+                if (root.pvLength == 0) {
+                    continue;
+                }
+                if (line == 0) {
+                    result.bestMove = root.pv[0];
+                    result.score = score;
+                    result.depth = depth;
+                }
+                excludedRootMoves.push_back(root.pv[0].pack());
+
+                if (onIteration) {
+                    info.depth = depth;
+                    info.multiPV = line + 1;
+                    info.selDepth = selDepth;
+                    info.score = score;
+                    info.nodes = nodes;
+                    info.timeMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        std::chrono::steady_clock::now() - startTime).count();
+                    info.hashfull = tt->hashfull();
+                    info.pv.assign(root.pv, root.pv + root.pvLength);
+                    onIteration(info);
+                }
+                // A stop requested between polls (or by the callback) ends the search here
+                if (stopped || stopRequested.load(std::memory_order_relaxed)) {
+                    stopped = true;
+                    break;
+                }
+            }
+
+            if (profile) {
+                DepthProfile& entry = profile->depths[depth];
+                ++entry.searches;
+                entry.nodes += nodes - iterationNodes;
+                entry.qnodes += profile->total().qnodes - iterationQNodes;
+                entry.microseconds += std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - iterationStart).count();
+            }
+
+            if (stopped) {
+                break;
+            }
+
+            // Don't start an iteration that is unlikely to finish in time
+            if (timeBudget > 0 && limits.moveTime == 0) {
+                auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - startTime).count();
+                if (elapsed > timeBudget / 2) {
+                    break;
+                }
+            }
+        }
+
+        rootMoveHint = 0;
+        excludedRootMoves.clear();
+        result.nodes = nodes;
+        return result;
+    }
+
+    int Searcher::alphaBeta(Board& board, int depth, int ply, int alpha, int beta, bool allowNull) {
+        bool isWhite = board.isWhiteToMove();
+        bool inCheck = !MoveGeneration::isKingSafe(board, isWhite);
+
+        // Check extension
+        if (inCheck) {
+            ++depth;
+            if (profile) {
+                ++profile->plies[ply].extensions;
+            }
+        }
+        if (depth <= 0) {
+            return quiesce(board, ply, alpha, beta);
+        }
+
+        Frame& frame = frames[ply];
+        frame.pvLength = 0;
+        ++nodes;
+        STATS_INC(Nodes);
+        if (profile) {
+            ++profile->plies[ply].nodes;
+        }
+        if ((nodes & 1023) == 0 && shouldStop()) {
+            stopped = true;
+        }
+        if (stopped) {
+            return 0;
+        }
+        if (ply >= MaxPly - 1) {
+            return Evaluation::evaluate(board);
+        }
+
+        // Draws by repetition or the 50-move rule (a mate on the 100th ply still counts)
+        if (ply > 0) {
+            if (board.isRepetition() || (board.isFiftyMoveDraw() && !inCheck)) {
+                return 0;
+            }
+            if (upcomingRepetition && alpha < 0 && board.hasUpcomingRepetition(ply)) {
+                alpha = 0;
+                if (alpha >= beta) {
+                    return alpha;
+                }
+            }
+        }
+
+        bool isPvNode = beta - alpha > 1;
+        uint64_t key = board.getKey();
+
+        // Transposition table cutoff
+        uint16_t ttMove = 0;
+        TTEntry entry;
+        STATS_INC(TTProbes);
+        PlyProfile* plyProfile = profile ? &profile->plies[ply] : nullptr;
+        if (plyProfile) {
+            ++plyProfile->ttProbes;
+        }
+        if (tt->probe(key, entry)) {
+            STATS_INC(TTHits);
+            ttMove = entry.move;
+            if (plyProfile) {
+                ++plyProfile->ttHits;
+            }
+            if (!isPvNode && ply > 0 && entry.depth >= depth) {
+                int ttScore = scoreFromTT(entry.score, ply);
+                if (entry.bound == BoundExact ||
+                    (entry.bound == BoundLower && ttScore >= beta) ||
+                    (entry.bound == BoundUpper && ttScore <= alpha)) {
+                    if (plyProfile) {
+                        ++plyProfile->ttCuts;
+                    }
+                    return ttScore;
+                }
+            }
+        }
+        if (ply == 0 && rootMoveHint) {
+            ttMove = rootMoveHint;
+        }
+
+        // Null-move pruning: if passing still fails high, a real move will too
+        frame.staticEval = -Infinity;
+        if (allowNull && !isPvNode && !inCheck && depth >= 3 && ply > 0 &&
+            hasNonPawnMaterial(board, isWhite) && (frame.staticEval = Evaluation::evaluate(board)) >= beta) {
+            int reduction = 2 + depth / 6;
+            if (plyProfile) {
+                ++plyProfile->nullMoves;
+            }
+            Board& child = copyMake ? (positions[ply + 1] = board) : board;
+            frame.nullMove = child.makeNullMove();
+            int score = -alphaBeta(child, depth - 1 - reduction, ply + 1, -beta, -beta + 1, false);
+            if (copyMake) {
+                keyHistory.pop();
+            } else {
+                board.undoNullMove(frame.nullMove);
+            }
+            if (stopped) {
+                return 0;
+            }
+            if (score >= beta) {
+                STATS_INC(NullMoveSuccesses);
+                if (plyProfile) {
+                    ++plyProfile->nullMoveCuts;
+                }
+                return score >= MateBound ? beta : score;
+            }
+        }
+
+        MoveList& moves = frame.moves;
+        int* scores = frame.scores;
+        board.generateMoves(isWhite, moves);
+        scoreMoves(board, moves, ttMove, ply, scores);
+
+        int originalAlpha = alpha;
+        int bestScore = -Infinity;
+        uint16_t bestMove = 0;
+        int legalMoves = 0;
+
+        for (int i = 0; i < moves.size(); ++i) {
+            pickMove(moves, scores, i);
+            const Move& move = moves[i];
+            if (ply == 0 && std::find(excludedRootMoves.begin(), excludedRootMoves.end(), move.pack())
+                            != excludedRootMoves.end()) {
+                continue;
+            }
+
+            Board& child = playMove(board, move, ply);
+            STATS_INC(LegalityChecks);
+            if (!MoveGeneration::isKingSafe(child, isWhite)) {
+                takeBack(board, move);
+                continue;
+            }
+            ++legalMoves;
+
+            // Principal variation search with a one-ply reduction for late quiet moves
+            int score;
+            if (legalMoves == 1) {
+                score = -alphaBeta(child, depth - 1, ply + 1, -beta, -alpha, true);
+            } else {
+                int reduction = (depth >= 3 && legalMoves > 4 && isQuiet(move) && !inCheck) ? 1 : 0;
+                if (plyProfile && reduction) {
+                    ++plyProfile->reductions;
+                }
+                score = -alphaBeta(child, depth - 1 - reduction, ply + 1, -alpha - 1, -alpha, true);
+                if (score > alpha && reduction) {
+                    if (plyProfile) {
+                        ++plyProfile->researches;
+                    }
+                    score = -alphaBeta(child, depth - 1, ply + 1, -alpha - 1, -alpha, true);
+                }
+                if (score > alpha && score < beta) {
+                    score = -alphaBeta(child, depth - 1, ply + 1, -beta, -alpha, true);
+                }
+            }
+            takeBack(board, move);
+
+            if (stopped) {
+                return 0;
+            }
+
+            if (score > bestScore) {
+                bestScore = score;
+                bestMove = move.pack();
+                if (score > alpha) {
+                    alpha = score;
+                    const Frame& next = frames[ply + 1];
+                    frame.pv[0] = move;
+                    std::copy(next.pv, next.pv + next.pvLength, frame.pv + 1);
+                    frame.pvLength = next.pvLength + 1;
+
+                    if (alpha >= beta) {
+                        STATS_INC(Cutoffs);
+                        if (legalMoves == 1) {
+                            STATS_INC(FirstMoveCutoffs);
+                        }
+                        if (plyProfile) {
+                            ++plyProfile->cutoffs;
+                            plyProfile->firstMoveCutoffs += legalMoves == 1;
+                            ++profile->cutoffIndex[std::min(legalMoves, ProfileCutoffSlots) - 1];
+                        }
+                        if (isQuiet(move)) {
+                            if (frame.killers[0] != bestMove) {
+                                frame.killers[1] = frame.killers[0];
+                                frame.killers[0] = bestMove;
+                            }
+                            int& entryHistory = history[isWhite ? White : Black][move.sourceSquare][move.targetSquare];
+                            entryHistory = std::min(entryHistory + depth * depth, 60000);
+                        }
+                        break;
+                    }
+                }
+            }
+        }
+
+        if (legalMoves == 0) {
+            return inCheck ? -MateScore + ply : 0;
+        }
+
+        // A root search with moves left out does not describe the position; keep the best line's entry
+        if (ply > 0 || excludedRootMoves.empty()) {
+            Bound bound = bestScore >= beta ? BoundLower : (bestScore > originalAlpha ? BoundExact : BoundUpper);
+            tt->store(key, depth, scoreToTT(bestScore, ply), bound, bestMove);
+        }
+        return bestScore;
+    }
+
+    int Searcher::quiesce(Board& board, int ply, int alpha, int beta) {
+        Frame& frame = frames[ply];
+        frame.pvLength = 0;
+        ++nodes;
+        STATS_INC(Nodes);
+        STATS_INC(QNodes);
+        if (profile) {
+            ++profile->plies[ply].qnodes;
+        }
+        if ((nodes & 1023) == 0 && shouldStop()) {
+            stopped = true;
+        }
+        if (stopped) {
+            return 0;
+        }
+        selDepth = std::max(selDepth, ply);
+
+        // Stand pat: the side to move can usually do at least as well as the static score
+        int standPat = frame.staticEval = Evaluation::evaluate(board);
+        if (standPat >= beta || ply >= MaxPly - 1) {
+            return standPat;
+        }
+        alpha = std::max(alpha, standPat);
+
+        bool isWhite = board.isWhiteToMove();
+        MoveList& moves = frame.moves;
+        int* scores = frame.scores;
+        board.generateMoves(isWhite, moves);
+        moves.resize(static_cast<int>(std::remove_if(moves.begin(), moves.end(), isQuiet) - moves.begin()));
+        scoreMoves(board, moves, 0, ply, scores);
+
+        int bestScore = standPat;
+        for (int i = 0; i < moves.size(); ++i) {
+            pickMove(moves, scores, i);
+            const Move& move = moves[i];
+
+            Board& child = playMove(board, move, ply);
+            STATS_INC(LegalityChecks);
+            if (!MoveGeneration::isKingSafe(child, isWhite)) {
+                takeBack(board, move);
+                continue;
+            }
+            int score = -quiesce(child, ply + 1, -beta, -alpha);
+            takeBack(board, move);
+
+            if (stopped) {
+                return 0;
+            }
+            if (score > bestScore) {
+                bestScore = score;
+                if (score > alpha) {
+                    alpha = score;
+                    if (alpha >= beta) {
+                        STATS_INC(Cutoffs);
+                        break;
+                    }
+                }
+            }
+        }
+        return bestScore;
+    }
+}
@@ -0,0 +1,120 @@
+#include "search_profile.h"
+#include <cstring>
+#include <iomanip>
+
+namespace Search {
+    namespace {
+        double ratio(uint64_t numerator, uint64_t denominator) {
+            return denominator ? static_cast<double>(numerator) / static_cast<double>(denominator) : 0.0;
+        }
+    }
+
+    void Profile::clear() {
+        searches = 0;
+        std::memset(plies, 0, sizeof(plies));
+        std::memset(depths, 0, sizeof(depths));
+        std::memset(cutoffIndex, 0, sizeof(cutoffIndex));
+    }
+
+    PlyProfile Profile::total() const {
+        PlyProfile sum{};
+        for (const PlyProfile& ply : plies) {
+            sum.nodes += ply.nodes;
+            sum.qnodes += ply.qnodes;
+            sum.ttProbes += ply.ttProbes;
+            sum.ttHits += ply.ttHits;
+            sum.ttCuts += ply.ttCuts;
+            sum.cutoffs += ply.cutoffs;
+            sum.firstMoveCutoffs += ply.firstMoveCutoffs;
+            sum.nullMoves += ply.nullMoves;
+            sum.nullMoveCuts += ply.nullMoveCuts;
+            sum.reductions += ply.reductions;
+            sum.researches += ply.researches;
+            sum.extensions += ply.extensions;
+        }
+        return sum;
+    }
+
+    double Profile::plyBranchingFactor(int ply) const {
+        if (ply < 0 || ply + 1 >= ProfilePlies) {
+            return 0.0;
+        }
+        const PlyProfile& here = plies[ply];
+        const PlyProfile& next = plies[ply + 1];
+        return ratio(next.nodes + next.qnodes, here.nodes + here.qnodes);
+    }
+
+    double Profile::depthBranchingFactor(int depth) const {
+        if (depth <= 1 || depth >= ProfilePlies) {
+            return 0.0;
+        }
+        return ratio(depths[depth].nodes, depths[depth - 1].nodes);
+    }
+
+    void Profile::writeJson(std::ostream& out) const {
+        PlyProfile sum = total();
+        std::ios::fmtflags flags = out.flags();
+        std::streamsize precision = out.precision();
+        out << std::fixed << std::setprecision(4);
+
+        out << "{\"searches\": " << searches
+            << ", \"nodes\": " << sum.nodes + sum.qnodes
+            << ", \"qnodes\": " << sum.qnodes
+            << ", \"qnode_share\": " << ratio(sum.qnodes, sum.nodes + sum.qnodes)
+            << ", \"tt_hit_rate\": " << ratio(sum.ttHits, sum.ttProbes)
+            << ", \"tt_cut_rate\": " << ratio(sum.ttCuts, sum.ttProbes)
+            << ", \"first_move_cutoff_rate\": " << ratio(sum.firstMoveCutoffs, sum.cutoffs)
+            << ", \"null_move_cut_rate\": " << ratio(sum.nullMoveCuts, sum.nullMoves)
+            << ", \"reductions\": " << sum.reductions
+            << ", \"researches\": " << sum.researches
+            << ", \"extensions\": " << sum.extensions;
+
+        out << ", \"depths\": [";
+        bool first = true;
+        for (int depth = 1; depth < ProfilePlies; ++depth) {
+            const DepthProfile& entry = depths[depth];
+            if (!entry.searches) {
+                continue;
+            }
+            out << (first ? "" : ", ") << "{\"depth\": " << depth
+                << ", \"searches\": " << entry.searches
+                << ", \"nodes\": " << entry.nodes
+                << ", \"qnodes\": " << entry.qnodes
+                << ", \"ms\": " << entry.microseconds / 1000.0
+                << ", \"ebf\": " << depthBranchingFactor(depth) << "}";
+            first = false;
+        }
+
+        out << "], \"plies\": [";
+        int last = ProfilePlies - 1;
+        while (last >= 0 && !plies[last].nodes && !plies[last].qnodes) {
+            --last;
+        }
+        for (int ply = 0; ply <= last; ++ply) {
+            const PlyProfile& entry = plies[ply];
+            out << (ply ? ", " : "") << "{\"ply\": " << ply
+                << ", \"nodes\": " << entry.nodes
+                << ", \"qnodes\": " << entry.qnodes
+                << ", \"ebf\": " << plyBranchingFactor(ply)
+                << ", \"tt_probes\": " << entry.ttProbes
+                << ", \"tt_hit_rate\": " << ratio(entry.ttHits, entry.ttProbes)
+                << ", \"tt_cut_rate\": " << ratio(entry.ttCuts, entry.ttProbes)
+                << ", \"cutoffs\": " << entry.cutoffs
+                << ", \"first_move_cutoff_rate\": " << ratio(entry.firstMoveCutoffs, entry.cutoffs)
+                << ", \"null_moves\": " << entry.nullMoves
+                << ", \"null_move_cuts\": " << entry.nullMoveCuts
+                << ", \"reductions\": " << entry.reductions
+                << ", \"researches\": " << entry.researches
+                << ", \"extensions\": " << entry.extensions << "}";
+        }
+
+        out << "], \"cutoff_index\": [";
+        for (int slot = 0; slot < ProfileCutoffSlots; ++slot) {
+            out << (slot ? ", " : "") << cutoffIndex[slot];
+        }
+        out << "]}";
+
+        out.flags(flags);
+        out.precision(precision);
+    }
+}
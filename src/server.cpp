@@ -0,0 +1,898 @@
+#include "server.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include "board.h"
+#include "harness.h"
+#include "move_generation.h"
+#include "search.h"
+#include "transposition_table.h"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace Server {
+    namespace {
+        using Clock = std::chrono::steady_clock;
+
+        double millisecondsSince(Clock::time_point start) {
+            return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        }
+
+        // Completed requests whose latency the server's percentiles are taken over
+        constexpr size_t LatencyWindow = 4096;
+
+        std::string jsonString(const std::string& text) {
+            std::string out = "\"";
+            for (char c : text) {
+                if (c == '"' || c == '\\') {
+                    out += '\\';
+                    out += c;
+                } else if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    out += escaped;
+                } else {
+                    out += c;
+                }
+            }
+            return out + "\"";
+        }
+
+        // Four hex digits of a \u escape starting at text[at]
+        bool parseHex4(const std::string& text, size_t at, uint32_t& value) {
+            if (at + 4 > text.size()) {
+                return false;
+            }
+            value = 0;
+            for (size_t i = at; i < at + 4; ++i) {
+                char c = text[i];
+                int digit = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10
+                          : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+                if (digit < 0) {
+                    return false;
+                }
+                value = value * 16 + static_cast<uint32_t>(digit);
+            }
+            return true;
+        }
+
+        void appendUtf8(std::string& out, uint32_t codePoint) {
+            if (codePoint < 0x80) {
+                out += static_cast<char>(codePoint);
+            } else if (codePoint < 0x800) {
+                out += static_cast<char>(0xC0 | (codePoint >> 6));
+                out += static_cast<char>(0x80 | (codePoint & 0x3F));
+            } else if (codePoint < 0x10000) {
+                out += static_cast<char>(0xE0 | (codePoint >> 12));
+                out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (codePoint & 0x3F));
+            } else {
+                out += static_cast<char>(0xF0 | (codePoint >> 18));
+                out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+                out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (codePoint & 0x3F));
+            }
+        }
+
+        // Sends and receives newline-terminated lines on a socket
+        class LineSocket {
+        public:
+            explicit LineSocket(int fd) : fd(fd) {}
+            ~LineSocket() {
+                if (fd >= 0) {
+                    ::close(fd);
+                }
+            }
+            LineSocket(const LineSocket&) = delete;
+            LineSocket& operator=(const LineSocket&) = delete;
+
+            int descriptor() const { return fd; }
+
+            bool sendLine(const std::string& line) {
+                std::string data = line + "\n";
+                for (size_t sent = 0; sent < data.size();) {
+                    ssize_t written = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+                    if (written < 0 && errno == EINTR) {
+                        continue;
+                    }
+                    if (written <= 0) {
+                        return false;
+                    }
+                    sent += static_cast<size_t>(written);
+                }
+                return true;
+            }
+
+            // False once the peer has closed the connection and no complete line is left
+            bool readLine(std::string& line) {
+                while (true) {
+                    size_t end = pending.find('\n');
+                    if (end != std::string::npos) {
+                        line.assign(pending, 0, end);
+                        pending.erase(0, end + 1);
+                        return true;
+                    }
+                    char buffer[4096];
+                    ssize_t received = ::recv(fd, buffer, sizeof(buffer), 0);
+                    if (received < 0 && errno == EINTR) {
+                        continue;
+                    }
+                    if (received <= 0) {
+                        return false;
+                    }
+                    pending.append(buffer, static_cast<size_t>(received));
+                }
+            }
+
+        private:
+            int fd;
+            std::string pending;
+        };
+
+        // A client connection. Workers write responses while the connection thread reads
+        // requests, so writes are serialized; the descriptor is closed with the last reference.
+        struct Connection {
+            explicit Connection(int fd) : socket(fd), open(true), finished(false) {}
+
+            void send(const std::string& line) {
+                std::lock_guard<std::mutex> lock(writeMutex);
+                if (open && !socket.sendLine(line)) {
+                    open = false;
+                }
+            }
+
+            LineSocket socket;
+            std::mutex writeMutex;
+            std::atomic<bool> open;
+            std::atomic<bool> finished;  // The connection thread has returned and can be joined
+        };
+
+        struct Job {
+            std::string id;
+            std::shared_ptr<Connection> connection;
+            Board board;
+            Search::Limits limits;
+            Clock::time_point received;
+            std::atomic<bool> cancelled{false};
+            Search::Searcher* searcher = nullptr;  // Set while a worker runs the job
+        };
+
+        std::string infoJson(const std::string& id, const Search::Info& info) {
+            std::ostringstream out;
+            out << "{\"id\":" << jsonString(id) << ",\"type\":\"info\",\"depth\":" << info.depth
+                << ",\"seldepth\":" << info.selDepth << ",\"multipv\":" << info.multiPV
+                << ",\"score\":" << jsonString(Search::scoreToUci(info.score)) << ",\"nodes\":" << info.nodes
+                << ",\"time_ms\":" << info.timeMs << ",\"pv\":\"";
+            for (size_t i = 0; i < info.pv.size(); ++i) {
+                out << (i ? " " : "") << info.pv[i].toString();
+            }
+            out << "\"}";
+            return out.str();
+        }
+
+        std::string statusJson(const std::string& id, const std::string& type, const std::string& reason) {
+            std::string out = "{\"id\":" + jsonString(id) + ",\"type\":\"" + type + "\"";
+            if (!reason.empty()) {
+                out += ",\"reason\":" + jsonString(reason);
+            }
+            return out + "}";
+        }
+
+        // Responses are many small writes; without this the final line of each can sit behind
+        // Nagle's algorithm waiting for the client's delayed ACK
+        void disableNagle(int fd) {
+            int enabled = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enabled, sizeof(enabled));
+        }
+
+        int kingCount(const Board& board, PieceColor color) {
+            return __builtin_popcountll(board.getPieces(color, King));
+        }
+    }
+
+    bool parseJsonObject(const std::string& text, std::map<std::string, std::string>& fields) {
+        fields.clear();
+        size_t i = 0;
+        auto skipSpace = [&]() {
+            while (i < text.size() && std::isspace(static_cast<unsigned char>(text[i]))) {
+                ++i;
+            }
+        };
+        auto parseString = [&](std::string& out) {
+            if (i >= text.size() || text[i] != '"') {
+                return false;
+            }
+            out.clear();
+            for (++i; i < text.size(); ++i) {
+                char c = text[i];
+                if (c == '"') {
+                    ++i;
+                    return true;
+                }
+                if (c == '\\') {
+                    if (++i >= text.size()) {
+                        return false;
+                    }
+                    // \uXXXX becomes UTF-8, a surrogate pair one code point; unknown escapes
+                    // and lone surrogates make the object malformed
+                    switch (text[i]) {
+                    case '"': case '\\': case '/': out += text[i]; break;
+                    case 'b': out += '\b'; break;
+                    case 'f': out += '\f'; break;
+                    case 'n': out += '\n'; break;
+                    case 'r': out += '\r'; break;
+                    case 't': out += '\t'; break;
+                    case 'u': {
+                        uint32_t codePoint = 0, low = 0;
+                        if (!parseHex4(text, i + 1, codePoint)) {
+                            return false;
+                        }
+                        i += 4;
+                        if (codePoint >= 0xD800 && codePoint < 0xDC00) {
+                            if (i + 2 >= text.size() || text[i + 1] != '\\' || text[i + 2] != 'u'
+                                || !parseHex4(text, i + 3, low) || low < 0xDC00 || low >= 0xE000) {
+                                return false;
+                            }
+                            i += 6;
+                            codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                        } else if (codePoint >= 0xDC00 && codePoint < 0xE000) {
+                            return false;
+                        }
+                        appendUtf8(out, codePoint);
+                        break;
+                    }
+                    default:
+                        return false;
+                    }
+                } else {
+                    out += c;
+                }
+            }
+            return false;
+        };
+
+        skipSpace();
+        if (i >= text.size() || text[i++] != '{') {
+            return false;
+        }
+        skipSpace();
+        if (i < text.size() && text[i] == '}') {
+            ++i;
+            skipSpace();
+            return i == text.size();
+        }
+        while (true) {
+            std::string key, value;
+            skipSpace();
+            if (!parseString(key)) {
+                return false;
+            }
+            skipSpace();
+            if (i >= text.size() || text[i++] != ':') {
+                return false;
+            }
+            skipSpace();
+            if (i < text.size() && text[i] == '"') {
+                if (!parseString(value)) {
+                    return false;
+                }
+            } else {
+                size_t start = i;
+                while (i < text.size() && (std::isalnum(static_cast<unsigned char>(text[i])) || text[i] == '-'
+                                           || text[i] == '+' || text[i] == '.')) {
+                    ++i;
+                }
+                value = text.substr(start, i - start);
+                if (value.empty()) {
+                    return false;
+                }
+            }
+            fields[key] = value;
+            skipSpace();
+            if (i < text.size() && text[i] == ',') {
+                ++i;
+                continue;
+            }
+            if (i < text.size() && text[i] == '}') {
+                ++i;
+                skipSpace();
+                return i == text.size();
+            }
+            return false;
+        }
+    }
+
+    std::string metricsToJson(const Metrics& metrics) {
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(3)
+            << "{\"type\":\"stats\",\"accepted\":" << metrics.accepted << ",\"rejected\":" << metrics.rejected
+            << ",\"cancelled\":" << metrics.cancelled << ",\"completed\":" << metrics.completed
+            << ",\"nodes\":" << metrics.nodes << ",\"queued\":" << metrics.queued << ",\"running\":" << metrics.running
+            << ",\"p50_ms\":" << metrics.p50Ms << ",\"p99_ms\":" << metrics.p99Ms
+            << ",\"uptime_s\":" << metrics.uptimeSeconds << ",\"throughput\":" << metrics.throughput << "}";
+        return out.str();
+    }
+
+    struct AnalysisServer::State {
+        explicit State(const Options& options) : options(options), table(options.hashMegabytes) {}
+
+        void acceptLoop();
+        void workerLoop(Search::Searcher& searcher);
+        void serveConnection(const std::shared_ptr<Connection>& connection);
+        void handleRequest(const std::shared_ptr<Connection>& connection, const std::string& line);
+        void cancel(const std::shared_ptr<Connection>& connection, const std::string& id, bool reply);
+        Metrics metrics() const;
+
+        Options options;
+        TranspositionTable table;
+        int listenFd = -1;
+        std::atomic<bool> stopping{false};
+        Clock::time_point startTime;
+
+        std::thread acceptor;
+        std::vector<std::thread> workers;
+        std::vector<std::unique_ptr<Search::Searcher>> searchers;
+
+        // Queue, running jobs and counters
+        mutable std::mutex mutex;
+        std::condition_variable workAvailable;
+        std::deque<std::shared_ptr<Job>> queue;
+        std::vector<std::shared_ptr<Job>> running;
+        uint64_t accepted = 0, rejected = 0, cancelled = 0, completed = 0, nodes = 0;
+        std::vector<double> latencies;  // Ring of the last LatencyWindow, oldest at latencyNext once full
+        size_t latencyNext = 0;
+
+        std::mutex connectionsMutex;
+        std::vector<std::pair<std::shared_ptr<Connection>, std::thread>> connections;
+    };
+
+    void AnalysisServer::State::acceptLoop() {
+        while (!stopping) {
+            int fd = ::accept(listenFd, nullptr, nullptr);
+            if (fd < 0) {
+                if (stopping) {
+                    break;
+                }
+                continue;
+            }
+
+            if (options.port > 0) {
+                disableNagle(fd);
+            }
+
+            std::lock_guard<std::mutex> lock(connectionsMutex);
+            // Reap connections whose clients have gone
+            for (auto it = connections.begin(); it != connections.end();) {
+                if (it->first->finished) {
+                    it->second.join();
+                    it = connections.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            auto connection = std::make_shared<Connection>(fd);
+            connections.emplace_back(connection, std::thread([this, connection]() { serveConnection(connection); }));
+        }
+    }
+
+    void AnalysisServer::State::serveConnection(const std::shared_ptr<Connection>& connection) {
+        std::string line;
+        while (!stopping && connection->socket.readLine(line)) {
+            if (line.find_first_not_of(" \t\r") != std::string::npos) {
+                handleRequest(connection, line);
+            }
+        }
+        connection->open = false;
+        ::shutdown(connection->socket.descriptor(), SHUT_RDWR);
+
+        // Nobody is left to read the answers
+        std::vector<std::string> ids;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (const auto& job : queue) {
+                if (job->connection == connection) ids.push_back(job->id);
+            }
+            for (const auto& job : running) {
+                if (job->connection == connection) ids.push_back(job->id);
+            }
+        }
+        for (const std::string& id : ids) {
+            cancel(connection, id, false);
+        }
+        connection->finished = true;
+    }
+
+    void AnalysisServer::State::handleRequest(const std::shared_ptr<Connection>& connection, const std::string& line) {
+        std::map<std::string, std::string> fields;
+        if (!parseJsonObject(line, fields)) {
+            connection->send(statusJson("", "error", "malformed JSON"));
+            return;
+        }
+        if (fields.count("stats")) {
+            connection->send(metricsToJson(metrics()));
+            return;
+        }
+        if (fields.count("cancel")) {
+            cancel(connection, fields["cancel"], true);
+            return;
+        }
+
+        auto job = std::make_shared<Job>();
+        job->id = fields["id"];
+        job->connection = connection;
+        job->received = Clock::now();
+        try {
+            if (fields.count("depth")) job->limits.depth = std::max(1, std::stoi(fields["depth"]));
+            if (fields.count("nodes")) job->limits.nodes = std::stoull(fields["nodes"]);
+            if (fields.count("movetime")) job->limits.moveTime = std::stoll(fields["movetime"]);
+            if (fields.count("multipv")) job->limits.multiPV = std::max(1, std::stoi(fields["multipv"]));
+        } catch (const std::exception&) {
+            connection->send(statusJson(job->id, "error", "bad limit"));
+            return;
+        }
+        if (job->limits.moveTime <= 0 || job->limits.moveTime > options.maxTimeMs) {
+            job->limits.moveTime = options.maxTimeMs;
+        }
+
+        job->board.initializePosition();
+        if (fields.count("fen") && (!job->board.loadFen(fields["fen"]) || kingCount(job->board, White) != 1
+                                    || kingCount(job->board, Black) != 1)) {
+            connection->send(statusJson(job->id, "error", "bad FEN"));
+            return;
+        }
+
+        // Admission: a request is taken if a worker is idle or the queue has room
+        bool admitted;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            int idle = options.threads - static_cast<int>(running.size());
+            admitted = static_cast<int>(queue.size()) < options.maxQueued + std::max(0, idle);
+            if (admitted) {
+                queue.push_back(job);
+                ++accepted;
+            } else {
+                ++rejected;
+            }
+        }
+        if (admitted) {
+            workAvailable.notify_one();
+        } else {
+            connection->send(statusJson(job->id, "rejected", "queue full"));
+        }
+    }
+
+    void AnalysisServer::State::cancel(const std::shared_ptr<Connection>& connection, const std::string& id, bool reply) {
+        std::shared_ptr<Job> waiting;
+        bool found = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (auto it = queue.begin(); it != queue.end(); ++it) {
+                if ((*it)->connection == connection && (*it)->id == id) {
+                    waiting = *it;
+                    queue.erase(it);
+                    break;
+                }
+            }
+            if (waiting) {
+                found = true;
+            } else {
+                for (const auto& job : running) {
+                    if (job->connection == connection && job->id == id && !job->cancelled) {
+                        // The search() may not have started yet; its iteration callback checks the flag too
+                        job->cancelled = true;
+                        job->searcher->stop();
+                        found = true;
+                        break;
+                    }
+                }
+            }
+            if (found) {
+                ++cancelled;
+            }
+        }
+        if (reply && waiting) {
+            connection->send(statusJson(id, "cancelled", ""));
+        } else if (reply && !found) {
+            connection->send(statusJson(id, "error", "unknown id"));
+        }
+    }
+
+    void AnalysisServer::State::workerLoop(Search::Searcher& searcher) {
+        while (true) {
+            std::shared_ptr<Job> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                workAvailable.wait(lock, [this]() { return stopping || !queue.empty(); });
+                if (stopping) {
+                    return;
+                }
+                job = queue.front();
+                queue.pop_front();
+                job->searcher = &searcher;
+                running.push_back(job);
+            }
+
+            Search::Result result = searcher.search(job->board, job->limits, [&](const Search::Info& info) {
+                if (job->cancelled || stopping) {
+                    searcher.stop();
+                }
+                job->connection->send(infoJson(job->id, info));
+            });
+
+            std::ostringstream out;
+            out << "{\"id\":" << jsonString(job->id) << ",\"type\":\"bestmove\",\"move\":\""
+                << (result.hasMove ? result.bestMove.toString() : std::string("0000")) << "\",\"score\":"
+                << jsonString(Search::scoreToUci(result.score)) << ",\"depth\":" << result.depth
+                << ",\"nodes\":" << result.nodes << ",\"cancelled\":" << (job->cancelled ? "true" : "false") << "}";
+
+            // The worker counts as idle for admission before the client can see the answer
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                running.erase(std::find(running.begin(), running.end(), job));
+                ++completed;
+                nodes += result.nodes;
+                double latency = millisecondsSince(job->received);
+                if (latencies.size() < LatencyWindow) {
+                    latencies.push_back(latency);
+                } else {
+                    latencies[latencyNext] = latency;
+                    latencyNext = (latencyNext + 1) % LatencyWindow;
+                }
+            }
+            job->connection->send(out.str());
+        }
+    }
+
+    Metrics AnalysisServer::State::metrics() const {
+        Metrics result;
+        std::vector<double> window;
+        {
+            // Only the copy is made under the lock; the selection runs outside it
+            std::lock_guard<std::mutex> lock(mutex);
+            result.accepted = accepted;
+            result.rejected = rejected;
+            result.cancelled = cancelled;
+            result.completed = completed;
+            result.nodes = nodes;
+            result.queued = static_cast<int>(queue.size());
+            result.running = static_cast<int>(running.size());
+            window = latencies;
+        }
+        result.p50Ms = Harness::percentile(window, 0.50);
+        result.p99Ms = Harness::percentile(window, 0.99);
+        result.uptimeSeconds = millisecondsSince(startTime) / 1000.0;
+        result.throughput = result.uptimeSeconds > 0 ? result.completed / result.uptimeSeconds : 0.0;
+        return result;
+    }
+
+    AnalysisServer::AnalysisServer(const Options& options) : state(new State(options)) {}
+
+    AnalysisServer::~AnalysisServer() {
+        stop();
+    }
+
+    bool AnalysisServer::start(std::string& error) {
+        State& s = *state;
+        if (!s.options.hashFile.empty() && !s.table.mapFile(s.options.hashFile, s.options.hashMegabytes, error)) {
+            return false;
+        }
+        // On failure the descriptor is closed again, so stop() has nothing to tear down and
+        // never unlinks a socket path that belongs to someone else
+        auto fail = [&s, &error](const std::string& reason) {
+            error = reason;
+            if (s.listenFd >= 0) {
+                ::close(s.listenFd);
+                s.listenFd = -1;
+            }
+            return false;
+        };
+        if (s.options.port > 0) {
+            s.listenFd = ::socket(AF_INET, SOCK_STREAM, 0);
+            if (s.listenFd < 0) {
+                return fail(std::string("cannot create socket: ") + std::strerror(errno));
+            }
+            int reuse = 1;
+            ::setsockopt(s.listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+            sockaddr_in address{};
+            address.sin_family = AF_INET;
+            address.sin_port = htons(static_cast<uint16_t>(s.options.port));
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            if (::bind(s.listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+                return fail(std::string("cannot bind port: ") + std::strerror(errno));
+            }
+        } else {
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            if (s.options.socketPath.size() >= sizeof(address.sun_path)) {
+                error = "socket path too long";
+                return false;
+            }
+            std::strcpy(address.sun_path, s.options.socketPath.c_str());
+
+            // A leftover socket from a server that exited without stop() is removed; anything
+            // else at the path, or a socket a live server still answers on, is an error
+            struct stat status{};
+            if (::lstat(s.options.socketPath.c_str(), &status) == 0) {
+                if (!S_ISSOCK(status.st_mode)) {
+                    error = s.options.socketPath + ": exists and is not a socket";
+                    return false;
+                }
+                int probe = ::socket(AF_UNIX, SOCK_STREAM, 0);
+                bool answered = probe >= 0 && ::connect(probe, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+                if (probe >= 0) {
+                    ::close(probe);
+                }
+                if (answered) {
+                    error = s.options.socketPath + ": another server is listening";
+                    return false;
+                }
+                ::unlink(s.options.socketPath.c_str());
+            }
+            s.listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            if (s.listenFd < 0) {
+                return fail(std::string("cannot create socket: ") + std::strerror(errno));
+            }
+            if (::bind(s.listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+                return fail(std::string("cannot bind socket: ") + std::strerror(errno));
+            }
+        }
+        if (::listen(s.listenFd, 128) < 0) {
+            return fail(std::string("cannot listen: ") + std::strerror(errno));
+        }
+
+        s.startTime = Clock::now();
+        for (int i = 0; i < std::max(1, s.options.threads); ++i) {
+            s.searchers.emplace_back(new Search::Searcher(s.table));
+        }
+        for (auto& searcher : s.searchers) {
+            Search::Searcher* worker = searcher.get();
+            s.workers.emplace_back([&s, worker]() { s.workerLoop(*worker); });
+        }
+        s.acceptor = std::thread([&s]() { s.acceptLoop(); });
+        return true;
+    }
+
+    void AnalysisServer::stop() {
+        State& s = *state;
+        if (s.stopping.exchange(true) || s.listenFd < 0) {
+            return;
+        }
+
+        ::shutdown(s.listenFd, SHUT_RDWR);
+        ::close(s.listenFd);
+        if (s.acceptor.joinable()) {
+            s.acceptor.join();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(s.mutex);
+            for (const auto& job : s.running) {
+                job->searcher->stop();
+            }
+        }
+        s.workAvailable.notify_all();
+        for (std::thread& worker : s.workers) {
+            worker.join();
+        }
+
+        std::lock_guard<std::mutex> lock(s.connectionsMutex);
+        for (auto& entry : s.connections) {
+            ::shutdown(entry.first->socket.descriptor(), SHUT_RDWR);
+            entry.second.join();
+        }
+        s.connections.clear();
+        if (s.options.port == 0) {
+            ::unlink(s.options.socketPath.c_str());
+        }
+    }
+
+    Metrics AnalysisServer::metrics() const {
+        return state->metrics();
+    }
+
+    namespace {
+        // Parses the shared --socket/--port options; false if args[i] is neither
+        bool parseEndpoint(const std::vector<std::string>& args, size_t& i, Options& options) {
+            if (args[i] == "--socket" && i + 1 < args.size()) {
+                options.socketPath = args[++i];
+                options.port = 0;
+            } else if (args[i] == "--port" && i + 1 < args.size()) {
+                options.port = std::stoi(args[++i]);
+            } else {
+                return false;
+            }
+            return true;
+        }
+
+        int connectTo(const Options& options) {
+            if (options.port > 0) {
+                int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+                sockaddr_in address{};
+                address.sin_family = AF_INET;
+                address.sin_port = htons(static_cast<uint16_t>(options.port));
+                address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+                if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) {
+                    disableNagle(fd);
+                    return fd;
+                }
+                if (fd >= 0) ::close(fd);
+                return -1;
+            }
+            int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            std::strncpy(address.sun_path, options.socketPath.c_str(), sizeof(address.sun_path) - 1);
+            if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) {
+                return fd;
+            }
+            if (fd >= 0) ::close(fd);
+            return -1;
+        }
+    }
+
+    int runCommand(const std::vector<std::string>& args) {
+        Options options;
+        for (size_t i = 0; i < args.size(); ++i) {
+            if (parseEndpoint(args, i, options)) {
+                continue;
+            } else if (args[i] == "--threads" && i + 1 < args.size()) {
+                options.threads = std::max(1, std::stoi(args[++i]));
+            } else if (args[i] == "--hash" && i + 1 < args.size()) {
+                options.hashMegabytes = std::max<size_t>(1, std::stoul(args[++i]));
+            } else if (args[i] == "--hash-file" && i + 1 < args.size()) {
+                options.hashFile = args[++i];
+            } else if (args[i] == "--queue" && i + 1 < args.size()) {
+                options.maxQueued = std::max(0, std::stoi(args[++i]));
+            } else if (args[i] == "--max-time" && i + 1 < args.size()) {
+                options.maxTimeMs = std::max<int64_t>(1, std::stoll(args[++i]));
+            } else {
+                std::cerr << "server: unknown option " << args[i] << std::endl;
+                return 1;
+            }
+        }
+
+        // SIGINT/SIGTERM are taken synchronously below; every thread inherits the blocked mask
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+        AnalysisServer server(options);
+        std::string error;
+        if (!server.start(error)) {
+            std::cerr << "server: " << error << std::endl;
+            return 1;
+        }
+        std::cerr << "server: listening on "
+                  << (options.port > 0 ? "127.0.0.1:" + std::to_string(options.port) : options.socketPath)
+                  << " with " << options.threads << " workers" << std::endl;
+
+        int signal = 0;
+        sigwait(&signals, &signal);
+        server.stop();
+        std::cout << metricsToJson(server.metrics()) << std::endl;
+        return 0;
+    }
+
+    int runLoadTest(const std::vector<std::string>& args) {
+        Options endpoint;
+        int requests = 100, concurrency = 4;
+        std::string limit = "\"depth\":6";
+        std::string fen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+        for (size_t i = 0; i < args.size(); ++i) {
+            if (parseEndpoint(args, i, endpoint)) {
+                continue;
+            } else if (args[i] == "--requests" && i + 1 < args.size()) {
+                requests = std::max(1, std::stoi(args[++i]));
+            } else if (args[i] == "--concurrency" && i + 1 < args.size()) {
+                concurrency = std::max(1, std::stoi(args[++i]));
+            } else if (args[i] == "--depth" && i + 1 < args.size()) {
+                limit = "\"depth\":" + std::to_string(std::stoi(args[++i]));
+            } else if (args[i] == "--nodes" && i + 1 < args.size()) {
+                limit = "\"nodes\":" + std::to_string(std::stoull(args[++i]));
+            } else if (args[i] == "--fen" && i + 1 < args.size()) {
+                fen = args[++i];
+            } else {
+                std::cerr << "loadtest: unknown option " << args[i] << std::endl;
+                return 1;
+            }
+        }
+
+        std::atomic<int> next(0);
+        std::atomic<bool> failed(false);
+        std::mutex resultsMutex;
+        std::vector<double> latencies;
+        uint64_t rejected = 0, errors = 0;
+        auto start = Clock::now();
+
+        auto client = [&](int clientIndex) {
+            int fd = connectTo(endpoint);
+            if (fd < 0) {
+                failed = true;
+                return;
+            }
+            LineSocket socket(fd);
+            std::map<std::string, std::string> fields;
+            for (int request; (request = next.fetch_add(1)) < requests;) {
+                std::string id = std::to_string(clientIndex) + "-" + std::to_string(request);
+                auto sent = Clock::now();
+                if (!socket.sendLine("{\"id\":" + jsonString(id) + ",\"fen\":" + jsonString(fen) + "," + limit + "}")) {
+                    failed = true;
+                    return;
+                }
+                // Info lines stream in until the request's final response
+                std::string line, type;
+                while (true) {
+                    if (!socket.readLine(line)) {
+                        failed = true;
+                        return;
+                    }
+                    if (parseJsonObject(line, fields) && fields["id"] == id && fields["type"] != "info") {
+                        type = fields["type"];
+                        break;
+                    }
+                }
+                double latency = millisecondsSince(sent);
+                std::lock_guard<std::mutex> lock(resultsMutex);
+                if (type == "bestmove") {
+                    latencies.push_back(latency);
+                } else if (type == "rejected") {
+                    ++rejected;
+                } else {
+                    ++errors;
+                }
+            }
+        };
+
+        std::vector<std::thread> clients;
+        for (int i = 0; i < concurrency; ++i) {
+            clients.emplace_back(client, i);
+        }
+        for (std::thread& thread : clients) {
+            thread.join();
+        }
+        double seconds = millisecondsSince(start) / 1000.0;
+        if (failed) {
+            std::cerr << "loadtest: lost the connection to the server" << std::endl;
+            return 1;
+        }
+
+        std::cout << "completed " << latencies.size() << " rejected " << rejected << " errors " << errors
+                  << std::fixed << std::setprecision(2)
+                  << " p50_ms " << Harness::percentile(latencies, 0.50) << " p99_ms " << Harness::percentile(latencies, 0.99)
+                  << " time " << seconds << " requests/s " << (seconds > 0 ? latencies.size() / seconds : 0.0)
+                  << std::endl;
+
+        int fd = connectTo(endpoint);
+        if (fd >= 0) {
+            LineSocket socket(fd);
+            std::string line;
+            if (socket.sendLine("{\"stats\":true}") && socket.readLine(line)) {
+                std::cout << line << std::endl;
+            }
+        }
+        return 0;
+    }
+}
@@ -0,0 +1,89 @@
+#include "stats.h"
+#include <algorithm>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace Stats {
+    namespace {
+        // Registration only happens at thread start/exit, never on the counting path
+        std::mutex registryMutex;
+        std::vector<ThreadCounters*> registry;
+        Snapshot retired;
+
+        double ratio(uint64_t numerator, uint64_t denominator) {
+            return denominator ? static_cast<double>(numerator) / static_cast<double>(denominator) : 0.0;
+        }
+    }
+
+    const char* counterName(Counter counter) {
+        static const char* const names[CounterCount] = {
+            "nodes", "qnodes", "movegen_calls", "legality_checks", "tt_probes",
+            "tt_hits", "cutoffs", "first_move_cutoffs", "null_move_successes"
+        };
+        return names[counter];
+    }
+
+    ThreadCounters::ThreadCounters() {
+        for (std::atomic<uint64_t>& value : values) {
+            value.store(0, std::memory_order_relaxed);
+        }
+        std::lock_guard<std::mutex> lock(registryMutex);
+        registry.push_back(this);
+    }
+
+    ThreadCounters::~ThreadCounters() {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (int i = 0; i < CounterCount; ++i) {
+            retired.values[i] += values[i].load(std::memory_order_relaxed);
+        }
+        registry.erase(std::remove(registry.begin(), registry.end(), this), registry.end());
+    }
+
+    Snapshot collect() {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        Snapshot snapshot = retired;
+        for (const ThreadCounters* counters : registry) {
+            for (int i = 0; i < CounterCount; ++i) {
+                snapshot.values[i] += counters->values[i].load(std::memory_order_relaxed);
+            }
+        }
+        return snapshot;
+    }
+
+    void reset() {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        retired = Snapshot();
+        for (ThreadCounters* counters : registry) {
+            for (std::atomic<uint64_t>& value : counters->values) {
+                value.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::string infoString(const Snapshot& snapshot) {
+        std::ostringstream out;
+        out << "info string stats";
+        if (!enabled) {
+            out << " disabled";
+            return out.str();
+        }
+        for (int i = 0; i < CounterCount; ++i) {
+            out << " " << counterName(static_cast<Counter>(i)) << " " << snapshot.values[i];
+        }
+        return out.str();
+    }
+
+    void writeJson(std::ostream& out, const Snapshot& snapshot) {
+        out << "{\"enabled\": " << (enabled ? "true" : "false");
+        for (int i = 0; i < CounterCount; ++i) {
+            out << ", \"" << counterName(static_cast<Counter>(i)) << "\": " << snapshot.values[i];
+        }
+        out << std::fixed << std::setprecision(4)
+            << ", \"tt_hit_rate\": " << ratio(snapshot[TTHits], snapshot[TTProbes])
+            << ", \"first_move_cutoff_rate\": " << ratio(snapshot[FirstMoveCutoffs], snapshot[Cutoffs])
+            << ", \"qnode_share\": " << ratio(snapshot[QNodes], snapshot[Nodes])
+            << "}";
+    }
+}
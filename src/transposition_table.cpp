@@ -0,0 +1,221 @@
+#include "transposition_table.h"
+#include "zobrist.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    // Data word layout: move (16) | score (16) | depth (8) | bound (8)
+    uint64_t packEntry(const TTEntry& entry) {
+        return static_cast<uint64_t>(entry.move)
+             | (static_cast<uint64_t>(static_cast<uint16_t>(entry.score)) << 16)
+             | (static_cast<uint64_t>(static_cast<uint8_t>(entry.depth)) << 32)
+             | (static_cast<uint64_t>(entry.bound) << 40);
+    }
+
+    TTEntry unpackEntry(uint64_t data) {
+        TTEntry entry;
+        entry.move = static_cast<uint16_t>(data);
+        entry.score = static_cast<int16_t>(static_cast<uint16_t>(data >> 16));
+        entry.depth = static_cast<int8_t>(static_cast<uint8_t>(data >> 32));
+        entry.bound = static_cast<Bound>((data >> 40) & 3);
+        return entry;
+    }
+
+    // Largest power-of-two slot count that fits in the given number of bytes (at least one)
+    uint64_t slotCountForBytes(size_t bytes, size_t slotBytes) {
+        uint64_t count = 1;
+        while (count * 2 * slotBytes <= bytes) {
+            count *= 2;
+        }
+        return count;
+    }
+
+    uint64_t slotCount(size_t megabytes, size_t slotBytes) {
+        return slotCountForBytes(std::max<size_t>(megabytes, 1) * 1024 * 1024, slotBytes);
+    }
+
+    // First page of a table file; the slots start on the page after it
+    struct FileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t slotBytes;
+        uint64_t slotCount;
+        uint64_t keyCheck;  // Ties the file to this build's Zobrist keys
+    };
+    constexpr size_t HeaderBytes = 4096;
+    constexpr char FileMagic[8] = {'C', 'E', 'T', 'T', 'F', 'I', 'L', 'E'};
+
+    uint64_t zobristCheck() {
+        return Zobrist::keys.side ^ Zobrist::keys.castling[15] ^ Zobrist::keys.pieces[1][6][60];
+    }
+}
+
+TranspositionTable::TranspositionTable(size_t megabytes, LargePages::Mode request)
+    : mapping(nullptr), mappingBytes(0), slots(nullptr), mask(0), megabytes(0) {
+    resize(megabytes, request);
+}
+
+TranspositionTable::TranspositionTable(void* memory, size_t bytes)
+    : mapping(nullptr), mappingBytes(0), slots(static_cast<Slot*>(memory)),
+      mask(slotCountForBytes(bytes, sizeof(Slot)) - 1), megabytes(bytes / (1024 * 1024)) {
+    clear();
+}
+
+TranspositionTable::~TranspositionTable() {
+    unmapFile();
+}
+
+void TranspositionTable::resize(size_t newMegabytes, LargePages::Mode request) {
+    uint64_t count = slotCount(newMegabytes, sizeof(Slot));
+    unmapFile();
+    memory = LargePages::Buffer();
+    memory = LargePages::Buffer(count * sizeof(Slot), request);
+    slots = static_cast<Slot*>(memory.data());
+    mask = count - 1;
+    megabytes = newMegabytes;
+    clear();
+}
+
+bool TranspositionTable::mapFile(const std::string& path, size_t newMegabytes, std::string& error) {
+    // Held while the header is checked or replaced, so processes starting together agree.
+    // A process that waited for the lock while the file was replaced holds the old inode,
+    // so it checks the path still names what it opened and starts over if not.
+    int fd = -1;
+    FileHeader header{};
+    struct stat status{};
+    for (;;) {
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd < 0) {
+            error = path + ": " + std::strerror(errno);
+            return false;
+        }
+        struct stat current{};
+        if (::flock(fd, LOCK_EX) != 0 || ::fstat(fd, &status) != 0) {
+            error = path + ": " + std::strerror(errno);
+            ::close(fd);
+            return false;
+        }
+        if (::stat(path.c_str(), &current) == 0 && current.st_dev == status.st_dev && current.st_ino == status.st_ino) {
+            break;
+        }
+        ::close(fd);
+    }
+
+    bool valid = ::pread(fd, &header, sizeof(header), 0) == sizeof(header)
+              && std::memcmp(header.magic, FileMagic, sizeof(FileMagic)) == 0 && header.version == FileVersion
+              && header.slotBytes == sizeof(Slot) && header.keyCheck == zobristCheck()
+              && header.slotCount && (header.slotCount & (header.slotCount - 1)) == 0
+              && static_cast<uint64_t>(status.st_size) == HeaderBytes + header.slotCount * sizeof(Slot);
+
+    int mapFd = fd;
+    if (!valid) {
+        // Never shrink a file in place: other processes may still have it mapped and would
+        // fault on the lost pages. A fresh zero-filled file is built beside it and renamed
+        // over the path; old mappings keep the old inode.
+        header = FileHeader{};
+        std::memcpy(header.magic, FileMagic, sizeof(FileMagic));
+        header.version = FileVersion;
+        header.slotBytes = sizeof(Slot);
+        header.slotCount = slotCount(newMegabytes, sizeof(Slot));
+        header.keyCheck = zobristCheck();
+        off_t size = static_cast<off_t>(HeaderBytes + header.slotCount * sizeof(Slot));
+        std::string fresh = path + ".tmp." + std::to_string(::getpid());
+        mapFd = ::open(fresh.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (mapFd < 0 || ::ftruncate(mapFd, size) != 0
+            || ::pwrite(mapFd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header))
+            || ::rename(fresh.c_str(), path.c_str()) != 0) {
+            error = path + ": " + std::strerror(errno);
+            if (mapFd >= 0) {
+                ::close(mapFd);
+                ::unlink(fresh.c_str());
+            }
+            ::close(fd);
+            return false;
+        }
+    }
+
+    size_t bytes = HeaderBytes + header.slotCount * sizeof(Slot);
+    void* mapped = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, mapFd, 0);
+    int mapError = errno;
+    if (mapFd != fd) {
+        ::close(mapFd);
+    }
+    // Unlocked explicitly: the mapping keeps the open file, and with it the lock, past close()
+    ::flock(fd, LOCK_UN);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        error = path + ": " + std::strerror(mapError);
+        return false;
+    }
+
+    unmapFile();
+    memory = LargePages::Buffer();
+    mapping = mapped;
+    mappingBytes = bytes;
+    slots = reinterpret_cast<Slot*>(static_cast<char*>(mapped) + HeaderBytes);
+    mask = header.slotCount - 1;
+    megabytes = std::max<size_t>(1, header.slotCount * sizeof(Slot) / (1024 * 1024));
+    return true;
+}
+
+void TranspositionTable::unmapFile() {
+    if (mapping) {
+        ::munmap(mapping, mappingBytes);
+        mapping = nullptr;
+        mappingBytes = 0;
+        slots = nullptr;
+    }
+}
+
+void TranspositionTable::clear() {
+    for (uint64_t i = 0; i <= mask; ++i) {
+        slots[i].check.store(0, std::memory_order_relaxed);
+        slots[i].data.store(0, std::memory_order_relaxed);
+    }
+}
+
+bool TranspositionTable::probe(uint64_t key, TTEntry& entry) const {
+    const Slot& slot = slots[key & mask];
+    uint64_t data = slot.data.load(std::memory_order_relaxed);
+    uint64_t check = slot.check.load(std::memory_order_relaxed);
+    if (data == 0 || (check ^ data) != key) {
+        return false;
+    }
+    entry = unpackEntry(data);
+    return true;
+}
+
+void TranspositionTable::store(uint64_t key, int depth, int score, Bound bound, uint16_t move) {
+    Slot& slot = slots[key & mask];
+
+    // Keep the old move when the new result has none for the same position
+    uint64_t oldData = slot.data.load(std::memory_order_relaxed);
+    bool samePosition = (slot.check.load(std::memory_order_relaxed) ^ oldData) == key;
+    if (samePosition && move == 0) {
+        move = unpackEntry(oldData).move;
+    }
+
+    // Depth-preferred for the same position, always replace otherwise
+    if (samePosition && bound != BoundExact && depth < unpackEntry(oldData).depth) {
+        return;
+    }
+
+    uint64_t data = packEntry(TTEntry{move, static_cast<int16_t>(score), static_cast<int8_t>(depth), bound});
+    slot.check.store(key ^ data, std::memory_order_relaxed);
+    slot.data.store(data, std::memory_order_relaxed);
+}
+
+int TranspositionTable::hashfull() const {
+    uint64_t sample = std::min<uint64_t>(1000, mask + 1);
+    int used = 0;
+    for (uint64_t i = 0; i < sample; ++i) {
+        used += slots[i].data.load(std::memory_order_relaxed) != 0;
+    }
+    return static_cast<int>(used * 1000 / sample);
+}
@@ -0,0 +1,496 @@
+#include "tune.h"
+#include "datagen.h"
+#include "evaluate.h"
+#include "evaluate_params.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#ifdef ENGINE_AVX2
+#include <immintrin.h>
+#endif
+
+namespace Tune {
+    namespace {
+        constexpr size_t Lanes = Dataset::Lanes;
+        constexpr int FeatureCount = Dataset::FeatureCount;
+
+        // Tables indexed by PieceType, as positions in the flattened weights
+        const int MgTable[7] = {0, 0, 2, 3, 4, 5, 6};
+        const int EgTable[7] = {0, 1, 2, 3, 4, 5, 7};
+        const char* const TableNames[TableCount] = {"PawnMgPst", "PawnEgPst", "KnightPst", "BishopPst",
+                                                    "RookPst", "QueenPst", "KingMgPst", "KingEgPst"};
+
+        int tableIndex(int table, int square) {
+            return 2 * MaterialTerms + table * 64 + square;
+        }
+
+        // Game result from a token such as 1-0, "0.5" or [1/2-1/2]; false if it is not one
+        bool parseResult(std::string token, float& result) {
+            token.erase(std::remove_if(token.begin(), token.end(),
+                                       [](char c) { return c == '"' || c == '[' || c == ']' || c == ';'; }),
+                        token.end());
+            if (token == "1-0" || token == "1.0" || token == "1") {
+                result = 1.0f;
+            } else if (token == "0-1" || token == "0.0" || token == "0") {
+                result = 0.0f;
+            } else if (token == "1/2-1/2" || token == "0.5" || token == "1/2") {
+                result = 0.5f;
+            } else {
+                return false;
+            }
+            return true;
+        }
+
+        bool loadRecords(Dataset& data, const std::string& path, std::string& error) {
+            Datagen::Reader reader(path);
+            if (!reader.isOpen()) {
+                error = "cannot open " + path;
+                return false;
+            }
+            Board board;
+            const Datagen::PackedPosition* record;
+            while (reader.next(record)) {
+                Datagen::unpack(*record, board);
+                data.add(board, std::min<int>(record->result, Datagen::WhiteWin) / 2.0f);
+            }
+            return true;
+        }
+    }
+
+    std::vector<double> defaultParameters() {
+        using namespace Evaluation::Params;
+        const int* const tables[TableCount] = {PawnMgPst, PawnEgPst, KnightPst, BishopPst,
+                                               RookPst, QueenPst, KingMgPst, KingEgPst};
+        std::vector<double> parameters(ParameterCount);
+        for (int piece = Pawn; piece <= Queen; ++piece) {
+            parameters[piece - Pawn] = MaterialMg[piece];
+            parameters[MaterialTerms + piece - Pawn] = MaterialEg[piece];
+        }
+        for (int table = 0; table < TableCount; ++table) {
+            for (int square = 0; square < 64; ++square) {
+                parameters[tableIndex(table, square)] = tables[table][square];
+            }
+        }
+        return parameters;
+    }
+
+    void writeHeader(std::ostream& out, const std::vector<double>& parameters) {
+        auto value = [&parameters](int index) { return static_cast<int>(std::lround(parameters[index])); };
+        auto material = [&](const char* name, int first) {
+            out << "        constexpr int " << name << "[7] = {0";
+            for (int piece = Pawn; piece <= Queen; ++piece) {
+                out << ", " << value(first + piece - Pawn);
+            }
+            out << ", 0};\n";
+        };
+
+        out << "#ifndef EVALUATE_PARAMS_H\n"
+               "#define EVALUATE_PARAMS_H\n"
+               "\n"
+               "// Evaluation weights read by evaluate.cpp. \"ChessEngine tune\" writes this file in the same\n"
+               "// layout, so tuned values are compiled in by replacing it.\n"
+               "namespace Evaluation {\n"
+               "    namespace Params {\n"
+               "        // Material indexed by PieceType\n";
+        material("MaterialMg", 0);
+        material("MaterialEg", MaterialTerms);
+        out << "\n"
+               "        // Piece-square tables from White's point of view, laid out as the board is drawn\n"
+               "        // (a8 first, h1 last). White squares are mirrored with square ^ 56 to index them.\n"
+               "        // Knights, bishops, rooks and queens use one table for both phases.\n";
+        for (int table = 0; table < TableCount; ++table) {
+            out << "        constexpr int " << TableNames[table] << "[64] = {\n";
+            for (int row = 0; row < 8; ++row) {
+                out << "            ";
+                for (int file = 0; file < 8; ++file) {
+                    out << std::setw(3) << value(tableIndex(table, row * 8 + file)) << (file < 7 ? ", " : "");
+                }
+                out << (row < 7 ? ",\n" : "\n");
+            }
+            out << "        };\n";
+        }
+        out << "    }\n"
+               "}\n"
+               "\n"
+               "#endif // EVALUATE_PARAMS_H\n";
+    }
+
+    void Dataset::add(const Board& board, float result) {
+        // Net count per feature; a white and a black piece on mirrored squares cancel out
+        int8_t net[FeatureCount] = {0};
+        int16_t used[64];
+        int usedCount = 0;
+        int phase = 0;
+        for (int color = White; color <= Black; ++color) {
+            for (int piece = Pawn; piece <= King; ++piece) {
+                uint64_t pieces = board.getPieces(static_cast<PieceColor>(color), piece);
+                phase += Evaluation::PhaseWeight[piece] * __builtin_popcountll(pieces);
+                for (; pieces; pieces &= pieces - 1) {
+                    int square = __builtin_ctzll(pieces);
+                    int feature = (piece - Pawn) * 64 + (color == White ? square ^ 56 : square);
+                    if (net[feature] == 0 && usedCount < 64) {
+                        used[usedCount++] = static_cast<int16_t>(feature);
+                    }
+                    net[feature] += color == White ? 1 : -1;
+                }
+            }
+        }
+
+        if (blocks.empty() || blocks.back().lanes == Lanes) {
+            Block block = {};
+            block.offset = features.size();
+            blocks.push_back(block);
+        }
+        Block& block = blocks.back();
+        size_t lane = block.lanes++;
+        block.phase[lane] = static_cast<float>(std::min(phase, Evaluation::MaxPhase)) / Evaluation::MaxPhase;
+        block.result[lane] = result;
+
+        // The open block is always the last, so it grows by appending rows
+        uint32_t row = 0;
+        for (int i = 0; i < usedCount; ++i) {
+            if (net[used[i]] == 0) {
+                continue;
+            }
+            if (row == block.rows) {
+                features.resize(features.size() + Lanes, 0);
+                counts.resize(counts.size() + Lanes, 0);
+                ++block.rows;
+            }
+            features[block.offset + row * Lanes + lane] = used[i];
+            counts[block.offset + row * Lanes + lane] = net[used[i]];
+            ++row;
+        }
+        ++count;
+    }
+
+    bool Dataset::load(const std::string& path, size_t& skipped, std::string& error) {
+        skipped = 0;
+        if (path.size() > 4 && path.compare(path.size() - 4, 4, ".bin") == 0) {
+            return loadRecords(*this, path, error);
+        }
+
+        std::ifstream file(path);
+        if (!file) {
+            error = "cannot open " + path;
+            return false;
+        }
+        Board board;
+        std::string line;
+        while (std::getline(file, line)) {
+            size_t end = line.find_last_not_of(" \t\r");
+            if (end == std::string::npos) {
+                continue;
+            }
+            // The result is the last token; loadFen ignores whatever follows its fields
+            size_t start = line.find_last_of(" \t", end);
+            float result;
+            if (start == std::string::npos || !parseResult(line.substr(start + 1, end - start), result)
+                || !board.loadFen(line.substr(0, start))) {
+                ++skipped;
+                continue;
+            }
+            add(board, result);
+        }
+        return true;
+    }
+
+    size_t Dataset::bytes() const {
+        return blocks.size() * sizeof(Block) + features.size() * sizeof(int16_t) + counts.size() * sizeof(int8_t);
+    }
+
+    struct Tuner::Accumulator {
+        double loss;
+        double mg[FeatureCount];
+        double eg[FeatureCount];
+    };
+
+    Tuner::Tuner(const Dataset& data, std::vector<double> parameters, int threads)
+        : data(data), weights(std::move(parameters)), gradients(ParameterCount, 0.0),
+          featureMg(FeatureCount, 0.0f), featureEg(FeatureCount, 0.0f),
+          moment(ParameterCount, 0.0), variance(ParameterCount, 0.0), steps(0), threads(std::max(1, threads)) {}
+
+    void Tuner::refreshFeatures() {
+        for (int piece = Pawn; piece <= King; ++piece) {
+            double materialMg = piece <= Queen ? weights[piece - Pawn] : 0.0;
+            double materialEg = piece <= Queen ? weights[MaterialTerms + piece - Pawn] : 0.0;
+            for (int square = 0; square < 64; ++square) {
+                int feature = (piece - Pawn) * 64 + square;
+                featureMg[feature] = static_cast<float>(materialMg + weights[tableIndex(MgTable[piece], square)]);
+                featureEg[feature] = static_cast<float>(materialEg + weights[tableIndex(EgTable[piece], square)]);
+            }
+        }
+    }
+
+    namespace {
+        // Middlegame and endgame sums of a block's lanes, tapered by phase
+#ifdef ENGINE_AVX2
+        void blockEvaluations(const int16_t* features, const int8_t* counts, uint32_t rows, const float* phase,
+                              const float* weightsMg, const float* weightsEg, float* evaluations) {
+            __m256 mg = _mm256_setzero_ps();
+            __m256 eg = _mm256_setzero_ps();
+            for (uint32_t row = 0; row < rows; ++row) {
+                __m256i index = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(features + row * Lanes)));
+                __m256 count = _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(
+                    _mm_loadl_epi64(reinterpret_cast<const __m128i*>(counts + row * Lanes))));
+                mg = _mm256_add_ps(mg, _mm256_mul_ps(count, _mm256_i32gather_ps(weightsMg, index, 4)));
+                eg = _mm256_add_ps(eg, _mm256_mul_ps(count, _mm256_i32gather_ps(weightsEg, index, 4)));
+            }
+            __m256 share = _mm256_loadu_ps(phase);
+            _mm256_storeu_ps(evaluations, _mm256_add_ps(eg, _mm256_mul_ps(share, _mm256_sub_ps(mg, eg))));
+        }
+#else
+        void blockEvaluations(const int16_t* features, const int8_t* counts, uint32_t rows, const float* phase,
+                              const float* weightsMg, const float* weightsEg, float* evaluations) {
+            float mg[Lanes] = {0}, eg[Lanes] = {0};
+            for (uint32_t row = 0; row < rows; ++row) {
+                for (size_t lane = 0; lane < Lanes; ++lane) {
+                    float count = counts[row * Lanes + lane];
+                    mg[lane] += count * weightsMg[features[row * Lanes + lane]];
+                    eg[lane] += count * weightsEg[features[row * Lanes + lane]];
+                }
+            }
+            for (size_t lane = 0; lane < Lanes; ++lane) {
+                evaluations[lane] = eg[lane] + phase[lane] * (mg[lane] - eg[lane]);
+            }
+        }
+#endif
+    }
+
+    void Tuner::passRange(size_t firstBlock, size_t lastBlock, double k, bool gradient, Accumulator& sum) const {
+        sum.loss = 0.0;
+        if (gradient) {
+            std::fill(sum.mg, sum.mg + FeatureCount, 0.0);
+            std::fill(sum.eg, sum.eg + FeatureCount, 0.0);
+        }
+
+        for (size_t index = firstBlock; index < lastBlock; ++index) {
+            const Dataset::Block& block = data.blocks[index];
+            const int16_t* features = data.features.data() + block.offset;
+            const int8_t* counts = data.counts.data() + block.offset;
+            float evaluations[Lanes];
+            blockEvaluations(features, counts, block.rows, block.phase, featureMg.data(), featureEg.data(), evaluations);
+
+            // d(loss)/d(eval) per lane, split into its middlegame and endgame shares
+            double slopeMg[Lanes] = {0}, slopeEg[Lanes] = {0};
+            for (size_t lane = 0; lane < block.lanes; ++lane) {
+                double predicted = 1.0 / (1.0 + std::exp(-k * evaluations[lane]));
+                double error = block.result[lane] - predicted;
+                sum.loss += error * error;
+                double slope = -2.0 * error * predicted * (1.0 - predicted) * k;
+                slopeMg[lane] = slope * block.phase[lane];
+                slopeEg[lane] = slope - slopeMg[lane];
+            }
+            if (!gradient) {
+                continue;
+            }
+            for (uint32_t row = 0; row < block.rows; ++row) {
+                for (size_t lane = 0; lane < block.lanes; ++lane) {
+                    int feature = features[row * Lanes + lane];
+                    int count = counts[row * Lanes + lane];
+                    sum.mg[feature] += count * slopeMg[lane];
+                    sum.eg[feature] += count * slopeEg[lane];
+                }
+            }
+        }
+    }
+
+    double Tuner::loss(double scale, bool gradient) {
+        refreshFeatures();
+        double k = scale * std::log(10.0) / 400.0;
+        size_t blockCount = data.blocks.size();
+        size_t workers = std::max<size_t>(1, std::min<size_t>(threads, blockCount));
+
+        std::vector<Accumulator> sums(workers);
+        auto work = [&](size_t worker) {
+            passRange(blockCount * worker / workers, blockCount * (worker + 1) / workers, k, gradient, sums[worker]);
+        };
+        std::vector<std::thread> pool;
+        for (size_t worker = 1; worker < workers; ++worker) {
+            pool.emplace_back(work, worker);
+        }
+        work(0);
+        for (std::thread& thread : pool) {
+            thread.join();
+        }
+
+        double total = 0.0;
+        double positions = std::max<size_t>(1, data.size());
+        for (const Accumulator& sum : sums) {
+            total += sum.loss;
+        }
+        if (gradient) {
+            std::fill(gradients.begin(), gradients.end(), 0.0);
+            for (const Accumulator& sum : sums) {
+                for (int piece = Pawn; piece <= King; ++piece) {
+                    for (int square = 0; square < 64; ++square) {
+                        int feature = (piece - Pawn) * 64 + square;
+                        if (piece <= Queen) {
+                            gradients[piece - Pawn] += sum.mg[feature];
+                            gradients[MaterialTerms + piece - Pawn] += sum.eg[feature];
+                        }
+                        gradients[tableIndex(MgTable[piece], square)] += sum.mg[feature];
+                        gradients[tableIndex(EgTable[piece], square)] += sum.eg[feature];
+                    }
+                }
+            }
+            for (double& value : gradients) {
+                value /= positions;
+            }
+        }
+        return total / positions;
+    }
+
+    double Tuner::fitScale() {
+        const double ratio = (std::sqrt(5.0) - 1.0) / 2.0;
+        double low = 0.05, high = 4.0;
+        double left = high - ratio * (high - low), right = low + ratio * (high - low);
+        double leftLoss = loss(left), rightLoss = loss(right);
+        for (int iteration = 0; iteration < 40; ++iteration) {
+            if (leftLoss < rightLoss) {
+                high = right;
+                right = left;
+                rightLoss = leftLoss;
+                left = high - ratio * (high - low);
+                leftLoss = loss(left);
+            } else {
+                low = left;
+                left = right;
+                leftLoss = rightLoss;
+                right = low + ratio * (high - low);
+                rightLoss = loss(right);
+            }
+        }
+        return (low + high) / 2.0;
+    }
+
+    double Tuner::stepAdam(double scale, double learningRate) {
+        const double beta1 = 0.9, beta2 = 0.999, epsilon = 1e-8;
+        double before = loss(scale, true);
+        ++steps;
+        double correction1 = 1.0 - std::pow(beta1, steps);
+        double correction2 = 1.0 - std::pow(beta2, steps);
+        for (int i = 0; i < ParameterCount; ++i) {
+            moment[i] = beta1 * moment[i] + (1.0 - beta1) * gradients[i];
+            variance[i] = beta2 * variance[i] + (1.0 - beta2) * gradients[i] * gradients[i];
+            weights[i] -= learningRate * (moment[i] / correction1) / (std::sqrt(variance[i] / correction2) + epsilon);
+        }
+        return before;
+    }
+
+    double Tuner::stepGradientDescent(double scale, double learningRate) {
+        double before = loss(scale, true);
+        for (int i = 0; i < ParameterCount; ++i) {
+            weights[i] -= learningRate * gradients[i];
+        }
+        return before;
+    }
+
+    double Tuner::evaluate(size_t index) {
+        refreshFeatures();
+        const Dataset::Block& block = data.blocks[index / Lanes];
+        float evaluations[Lanes];
+        blockEvaluations(data.features.data() + block.offset, data.counts.data() + block.offset, block.rows,
+                         block.phase, featureMg.data(), featureEg.data(), evaluations);
+        return evaluations[index % Lanes];
+    }
+
+    int runCommand(const std::vector<std::string>& args) {
+        std::vector<std::string> paths;
+        int threads = std::max(1u, std::thread::hardware_concurrency());
+        int epochs = 500;
+        int report = 50;
+        bool adam = true;
+        double learningRate = 0.0;  // 0 picks the optimiser's default
+        double scale = 0.0;         // 0 fits it to the data
+        std::string output = "evaluate_params.h";
+
+        for (size_t i = 0; i < args.size(); ++i) {
+            bool hasValue = i + 1 < args.size();
+            if (args[i] == "--data" && hasValue) {
+                paths.push_back(args[++i]);
+            } else if (args[i] == "--threads" && hasValue) {
+                threads = std::max(1, std::stoi(args[++i]));
+            } else if (args[i] == "--epochs" && hasValue) {
+                epochs = std::max(0, std::stoi(args[++i]));
+            } else if (args[i] == "--optimizer" && hasValue && (args[i + 1] == "adam" || args[i + 1] == "gd")) {
+                adam = args[++i] == "adam";
+            } else if (args[i] == "--lr" && hasValue) {
+                learningRate = std::stod(args[++i]);
+            } else if (args[i] == "--scale" && hasValue) {
+                scale = std::stod(args[++i]);
+            } else if (args[i] == "--report" && hasValue) {
+                report = std::max(1, std::stoi(args[++i]));
+            } else if (args[i] == "--out" && hasValue) {
+                output = args[++i];
+            } else {
+                std::cerr << "tune: unknown option " << args[i] << std::endl;
+                return 1;
+            }
+        }
+        if (paths.empty()) {
+            std::cerr << "tune: no --data file given" << std::endl;
+            return 1;
+        }
+        if (learningRate <= 0.0) {
+            learningRate = adam ? 1.0 : 100000.0;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        auto secondsSince = [](std::chrono::steady_clock::time_point since) {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - since).count();
+        };
+        Dataset data;
+        size_t skipped = 0;
+        for (const std::string& path : paths) {
+            size_t fileSkipped;
+            std::string error;
+            if (!data.load(path, fileSkipped, error)) {
+                std::cerr << "tune: " << error << std::endl;
+                return 1;
+            }
+            skipped += fileSkipped;
+        }
+        if (data.size() == 0) {
+            std::cerr << "tune: no positions loaded" << std::endl;
+            return 1;
+        }
+        std::cout << "positions " << data.size() << " skipped " << skipped << std::fixed << std::setprecision(1)
+                  << " memory " << data.bytes() / (1024.0 * 1024.0) << " MB" << std::setprecision(3)
+                  << " load " << secondsSince(start) << " s" << std::endl;
+
+        Tuner tuner(data, defaultParameters(), threads);
+        if (scale <= 0.0) {
+            scale = tuner.fitScale();
+        }
+        std::cout << std::setprecision(6) << "scale " << scale << " loss " << tuner.loss(scale) << std::endl;
+
+        start = std::chrono::steady_clock::now();
+        for (int epoch = 1; epoch <= epochs; ++epoch) {
+            double before = adam ? tuner.stepAdam(scale, learningRate) : tuner.stepGradientDescent(scale, learningRate);
+            if (epoch % report == 0 || epoch == epochs) {
+                double seconds = secondsSince(start);
+                std::cout << "epoch " << epoch << std::setprecision(6) << " loss " << before
+                          << std::setprecision(3) << " time " << seconds << std::setprecision(0)
+                          << " positions/s " << (seconds > 0 ? data.size() * static_cast<double>(epoch) / seconds : 0.0)
+                          << std::endl;
+            }
+        }
+        std::cout << std::setprecision(6) << "final loss " << tuner.loss(scale) << std::endl;
+
+        std::ofstream out(output);
+        writeHeader(out, tuner.parameters());
+        if (!out) {
+            std::cerr << "tune: cannot write " << output << std::endl;
+            return 1;
+        }
+        std::cout << "wrote " << output << std::endl;
+        return 0;
+    }
+}
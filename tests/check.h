@@ -0,0 +1,23 @@
+#ifndef TESTS_CHECK_H
+#define TESTS_CHECK_H
+
+#include <iostream>
+#include <string>
+
+// Shared by the test programs: check() prints each failed condition and counts it, and
+// finish() prints the verdict for the suite and returns the exit code for main()
+inline int failures = 0;
+
+inline void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cout << "FAIL " << what << std::endl;
+        ++failures;
+    }
+}
+
+inline int finish(const std::string& suite) {
+    std::cout << suite << (failures ? " tests failed" : " tests passed") << std::endl;
+    return failures ? 1 : 0;
+}
+
+#endif // TESTS_CHECK_H
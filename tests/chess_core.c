@@ -0,0 +1,181 @@
+#define _POSIX_C_SOURCE 200809L
+#include "chess_core.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+static int failures = 0;
+
+static void check(int condition, const char* what) {
+    if (!condition) {
+        printf("FAIL %s\n", what);
+        ++failures;
+    }
+}
+
+static int hasMove(const chess_move* moves, int count, const char* name) {
+    char buffer[CHESS_MOVE_STRING_SIZE];
+    for (int i = 0; i < count; ++i) {
+        if (chess_move_to_string(moves[i], buffer, sizeof(buffer)) > 0 && strcmp(buffer, name) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int legalCount(const chess_engine* engine) {
+    chess_move moves[CHESS_MAX_MOVES];
+    return chess_engine_legal_moves(engine, moves, CHESS_MAX_MOVES);
+}
+
+static int countIterations(const chess_search_info* info, void* user_data) {
+    int* iterations = (int*)user_data;
+    ++*iterations;
+    return info->pv_length == 0;  // Every completed iteration has a line
+}
+
+static int stopAfterFirst(const chess_search_info* info, void* user_data) {
+    (void)info;
+    (void)user_data;
+    return 1;
+}
+
+// One handle per thread, each searching its own position to a fixed depth
+struct Job {
+    const char* fen;
+    chess_search_result result;
+    chess_status status;
+};
+
+static void* runJob(void* argument) {
+    struct Job* job = (struct Job*)argument;
+    chess_engine* engine = chess_engine_create(4);
+    chess_limits limits;
+    chess_limits_init(&limits);
+    limits.depth = 5;
+    job->status = engine ? chess_engine_set_position(engine, job->fen, NULL) : CHESS_OUT_OF_MEMORY;
+    if (job->status == CHESS_OK) {
+        job->status = chess_engine_search(engine, &limits, NULL, NULL, &job->result);
+    }
+    chess_engine_destroy(engine);
+    return NULL;
+}
+
+struct Unlimited {
+    chess_engine* engine;
+    chess_search_result result;
+    chess_status status;
+};
+
+static void* runUnlimited(void* argument) {
+    struct Unlimited* search = (struct Unlimited*)argument;
+    search->status = chess_engine_search(search->engine, NULL, NULL, NULL, &search->result);
+    return NULL;
+}
+
+int main(void) {
+    check(chess_core_api_version() == CHESS_CORE_API_VERSION, "library matches the header");
+
+    chess_engine* engine = chess_engine_create(0);
+    check(engine != NULL, "create");
+
+    // Legal moves into caller buffers
+    chess_move moves[CHESS_MAX_MOVES];
+    int count = chess_engine_legal_moves(engine, moves, CHESS_MAX_MOVES);
+    check(count == 20, "20 moves from the start position");
+    check(hasMove(moves, count, "e2e4") && hasMove(moves, count, "g1f3"), "start moves named");
+    check(chess_engine_legal_moves(engine, moves, 19) == CHESS_BUFFER_TOO_SMALL, "short buffer rejected");
+    check(chess_engine_legal_moves(NULL, moves, CHESS_MAX_MOVES) == CHESS_INVALID_ARGUMENT, "null handle rejected");
+
+    char name[CHESS_MOVE_STRING_SIZE];
+    check(chess_move_to_string(0, name, sizeof(name)) == CHESS_INVALID_ARGUMENT, "no move has no name");
+    check(chess_move_to_string(moves[0], name, 3) == CHESS_INVALID_ARGUMENT, "short name buffer rejected");
+
+    // Positions, with errors leaving the previous one in place
+    check(chess_engine_set_position(engine, "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", NULL) == CHESS_OK,
+          "set kiwipete");
+    check(legalCount(engine) == 48, "48 moves in kiwipete");
+    check(chess_engine_set_position(engine, "not a fen", NULL) == CHESS_INVALID_FEN, "bad fen rejected");
+    check(chess_engine_set_position(engine, NULL, "e2e4 e2e4") == CHESS_ILLEGAL_MOVE, "illegal move rejected");
+    check(legalCount(engine) == 48, "position kept after errors");
+
+    check(chess_engine_set_position(engine, NULL, "e2e4 e7e5 g1f3") == CHESS_OK, "start position and moves");
+    check(!chess_engine_white_to_move(engine), "black to move after three plies");
+    check(legalCount(engine) == 29, "29 replies to the king's knight");
+
+    check(chess_engine_set_position(engine, "4k3/P7/8/8/8/8/8/4K3 w - - 0 1", NULL) == CHESS_OK, "set promotion");
+    count = chess_engine_legal_moves(engine, moves, CHESS_MAX_MOVES);
+    check(hasMove(moves, count, "a7a8q") && hasMove(moves, count, "a7a8n"), "promotions named");
+    int played = 0;
+    for (int i = 0; i < count; ++i) {
+        if (chess_move_to_string(moves[i], name, sizeof(name)) > 0 && strcmp(name, "a7a8q") == 0) {
+            played = chess_engine_make_move(engine, moves[i]) == CHESS_OK;
+        }
+    }
+    check(played && !chess_engine_white_to_move(engine), "make a packed move");
+    check(chess_engine_make_move(engine, moves[0]) == CHESS_ILLEGAL_MOVE, "white's move refused on black's turn");
+
+    // Search with limits and callbacks
+    chess_limits limits;
+    chess_limits_init(&limits);
+    limits.depth = 4;
+    int iterations = 0;
+    chess_search_result result;
+    check(chess_engine_set_position(engine, "6k1/5ppp/8/8/8/8/5PPP/R5K1 w - - 0 1", NULL) == CHESS_OK, "set back rank");
+    check(chess_engine_search(engine, &limits, countIterations, &iterations, &result) == CHESS_OK, "search");
+    check(chess_move_to_string(result.best_move, name, sizeof(name)) == 4 && strcmp(name, "a1a8") == 0, "finds the back rank mate");
+    check(result.mate == 1 && result.depth == 4, "mate in 1 at depth 4");
+    check(iterations == 4, "one report per iteration");
+
+    chess_engine_clear(engine);
+    check(chess_engine_search(engine, &limits, stopAfterFirst, NULL, &result) == CHESS_OK, "search stopped by callback");
+    check(result.depth == 1 && result.best_move != 0, "callback stop keeps the first iteration");
+
+    check(chess_engine_set_position(engine, "7k/5Q2/6K1/8/8/8/8/8 b - - 0 1", NULL) == CHESS_OK, "set stalemate");
+    check(chess_engine_search(engine, &limits, NULL, NULL, &result) == CHESS_OK && result.best_move == 0, "no move in stalemate");
+
+    // Stop from another thread ends a search without limits
+    check(chess_engine_set_position(engine, NULL, NULL) == CHESS_OK, "back to the start");
+    struct Unlimited unlimited = {engine, {0}, CHESS_INTERNAL_ERROR};
+    pthread_t searchThread;
+    pthread_create(&searchThread, NULL, runUnlimited, &unlimited);
+    struct timespec pause = {0, 100 * 1000 * 1000};
+    nanosleep(&pause, NULL);
+    chess_engine_stop(engine);
+    pthread_join(searchThread, NULL);
+    check(unlimited.status == CHESS_OK && unlimited.result.best_move != 0, "stopped from another thread");
+    chess_engine_destroy(engine);
+
+    // Handles on different threads at once give the same results as one after another
+    enum { Jobs = 4 };
+    const char* fens[Jobs] = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    };
+    struct Job sequential[Jobs], concurrent[Jobs];
+    pthread_t threads[Jobs];
+    for (int i = 0; i < Jobs; ++i) {
+        sequential[i].fen = concurrent[i].fen = fens[i];
+        runJob(&sequential[i]);
+    }
+    for (int i = 0; i < Jobs; ++i) {
+        pthread_create(&threads[i], NULL, runJob, &concurrent[i]);
+    }
+    for (int i = 0; i < Jobs; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    int same = 1;
+    for (int i = 0; i < Jobs; ++i) {
+        same = same && sequential[i].status == CHESS_OK && concurrent[i].status == CHESS_OK
+               && sequential[i].result.best_move == concurrent[i].result.best_move
+               && sequential[i].result.nodes == concurrent[i].result.nodes
+               && sequential[i].result.score_cp == concurrent[i].result.score_cp;
+    }
+    check(same, "concurrent handles match sequential searches");
+
+    printf("%s\n", failures ? "chess core tests failed" : "chess core tests passed");
+    return failures ? 1 : 0;
+}
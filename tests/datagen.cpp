@@ -0,0 +1,71 @@
+#include "board.h"
+#include "check.h"
+#include "datagen.h"
+#include "move_generation.h"
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Every field the record carries survives a round trip
+static void checkRoundTrip(const Board& board, const std::string& name) {
+    Datagen::PackedPosition record = Datagen::pack(board, -123, Datagen::WhiteWin);
+    Board decoded;
+    Datagen::unpack(record, decoded);
+    check(decoded.getKey() == board.getKey(), name + ": key");
+    check(decoded.getHalfmoveClock() == board.getHalfmoveClock(), name + ": halfmove clock");
+    check(decoded.getEnPassantSquare() == board.getEnPassantSquare(), name + ": en passant");
+    for (PieceColor color : {White, Black}) {
+        for (int pieceType = Pawn; pieceType <= King; ++pieceType) {
+            check(decoded.getPieces(color, pieceType) == board.getPieces(color, pieceType), name + ": bitboards");
+        }
+    }
+    check(record.score == -123 && record.result == Datagen::WhiteWin, name + ": score and result");
+}
+
+int main() {
+    const char* fens[] = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 b - - 37 60",
+    };
+    for (const char* fen : fens) {
+        Board board;
+        check(board.loadFen(fen), std::string("load ") + fen);
+        checkRoundTrip(board, fen);
+    }
+
+    // A short run on two threads: the file holds exactly the reported records, all decodable
+    const std::string path = "datagen_test.bin";
+    std::remove(path.c_str());
+    Datagen::Options options;
+    options.games = 4;
+    options.threads = 2;
+    options.nodes = 300;
+    options.maxPlies = 60;
+    options.hashMegabytes = 1;
+    options.output = path;
+    Datagen::Summary summary;
+    check(Datagen::generate(options, summary), "generate writes the file");
+    check(summary.games == 4, "every game is played");
+    check(summary.positions > 0, "games produce positions");
+    check(summary.results[0] + summary.results[1] + summary.results[2] == 4, "every game has a result");
+
+    uint64_t records = 0;
+    Datagen::Reader reader(path);
+    check(reader.isOpen(), "reader opens the file");
+    for (const Datagen::PackedPosition* record; reader.next(record);) {
+        Board board;
+        Datagen::unpack(*record, board);
+        ++records;
+        check(__builtin_popcountll(board.getWhiteKing()) == 1 && __builtin_popcountll(board.getBlackKing()) == 1,
+              "decoded positions have one king each");
+        check(record->result <= Datagen::WhiteWin, "result is in range");
+        check(MoveGeneration::isKingSafe(board, board.isWhiteToMove()), "no recorded position is in check");
+    }
+    check(records == summary.positions, "file holds every reported record");
+    std::remove(path.c_str());
+
+    return finish("datagen");
+}
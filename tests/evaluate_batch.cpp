@@ -0,0 +1,56 @@
+#include "board.h"
+#include "evaluate.h"
+#include "move_generation.h"
+#include <iostream>
+#include <vector>
+
+// Every position up to two plies from a few varied roots
+static void collect(Board& board, int depth, std::vector<Board>& positions) {
+    positions.push_back(board);
+    if (depth == 0) {
+        return;
+    }
+    bool isWhite = board.isWhiteToMove();
+    for (const Move& move : MoveGeneration::filterLegalMoves(board, board.generateMoves(isWhite), isWhite)) {
+        board.makeMove(move);
+        collect(board, depth - 1, positions);
+        board.undoMove(move);
+    }
+}
+
+int main() {
+    const char* fens[] = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "QQQQQQQQ/QQQQQQQQ/8/8/8/2k5/8/K7 b - - 0 1",
+    };
+
+    std::vector<Board> positions;
+    for (const char* fen : fens) {
+        Board board;
+        board.loadFen(fen);
+        collect(board, 2, positions);
+    }
+
+    int failures = 0;
+    for (int threads : {1, 3}) {
+        // An odd count leaves a partial final block
+        size_t count = positions.size() | 1;
+        positions.resize(count, positions.front());
+        std::vector<int> scores(count, 0);
+        Evaluation::evaluateBatch(positions.data(), count, scores.data(), threads);
+        for (size_t i = 0; i < count; ++i) {
+            if (scores[i] != Evaluation::evaluate(positions[i])) {
+                std::cout << "FAIL position " << i << " with " << threads << " threads: batch " << scores[i]
+                          << ", scalar " << Evaluation::evaluate(positions[i]) << std::endl;
+                ++failures;
+                break;
+            }
+        }
+    }
+
+    std::cout << (failures ? "evaluate batch tests failed" : "evaluate batch tests passed") << std::endl;
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,64 @@
+#include "check.h"
+#include "game_host.h"
+#include <iostream>
+#include <string>
+
+int main() {
+    // The pool hands out every table once, cleared, and takes them back
+    GameHost::TablePool pool(3, 16);
+    TranspositionTable* first = pool.acquire();
+    first->store(0x1234, 5, 10, BoundExact, 77);
+    TranspositionTable* second = pool.acquire();
+    TranspositionTable* third = pool.acquire();
+    check(first && second && third && first != second && second != third, "three distinct tables");
+    check(!pool.acquire() && pool.available() == 0, "exhausted pool");
+    pool.release(first);
+    TTEntry entry;
+    TranspositionTable* again = pool.acquire();
+    check(again == first && !again->probe(0x1234, entry), "recycled table comes back cleared");
+    check(second->probe(0x1234, entry) == false, "tables do not share slots");
+
+    // Without deadline pressure every move reaches the target depth, and the games end the
+    // same whatever the thread count, the number in flight or the order they are stepped in
+    GameHost::Options options;
+    options.games = 12;
+    options.concurrent = 5;
+    options.depth = 3;
+    options.moveTimeMs = 60000;
+    options.sliceNodes = 1024;
+    options.tableKilobytes = 32;
+    options.maxPlies = 40;
+    options.threads = 1;
+    GameHost::Summary one = GameHost::play(options);
+    check(one.games == 12 && one.whiteWins + one.draws + one.blackWins == 12, "every game finished");
+    check(one.moves > 12 && one.steps >= one.moves, "moves played in steps");
+    check(one.cutShort == 0 && one.late == 0, "no move cut short");
+    check(one.p50Ms <= one.p90Ms && one.p90Ms <= one.p99Ms && one.p99Ms <= one.maxMs, "ordered percentiles");
+
+    options.threads = 3;
+    options.concurrent = 12;
+    GameHost::Summary three = GameHost::play(options);
+    check(three.signature == one.signature && three.moves == one.moves && three.nodes == one.nodes,
+          "same games on three threads");
+
+    // Slices smaller than an iteration: the move is resumed over several steps
+    options.games = 4;
+    options.threads = 2;
+    options.concurrent = 2;
+    options.depth = 4;
+    options.maxPlies = 20;
+    options.sliceNodes = 1;
+    GameHost::Summary sliced = GameHost::play(options);
+    check(sliced.games == 4 && sliced.cutShort == 0 && sliced.steps > 2 * sliced.moves, "moves resumed across steps");
+
+    // With no time at all a move is played as soon as a step completes an iteration, almost
+    // always the first, and mostly short of the target depth
+    options.moveTimeMs = 0;
+    options.sliceNodes = 1024;
+    options.depth = 8;
+    GameHost::Summary rushed = GameHost::play(options);
+    check(rushed.games == 4 && rushed.steps < rushed.moves + rushed.moves / 10, "about one step per move at the deadline");
+    check(rushed.late == rushed.moves && rushed.cutShort > rushed.moves * 9 / 10, "moves cut short at the deadline");
+
+    return finish("game host");
+}
@@ -0,0 +1,38 @@
+#include "check.h"
+#include "large_pages.h"
+#include "transposition_table.h"
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <utility>
+
+int main() {
+    const size_t bytes = 5 * 1024 * 1024 + 123;
+    for (LargePages::Mode request : {LargePages::Mode::Explicit, LargePages::Mode::Transparent, LargePages::Mode::Normal}) {
+        std::string name = LargePages::modeName(request);
+        LargePages::Buffer buffer(bytes, request);
+        check(buffer.data() != nullptr && buffer.size() == bytes, name + ": allocated");
+        check(static_cast<int>(buffer.mode()) >= static_cast<int>(request), name + ": never better than requested");
+        check(reinterpret_cast<uintptr_t>(buffer.data()) % (2 * 1024 * 1024) == 0, name + ": 2MB aligned");
+
+        const unsigned char* memory = static_cast<const unsigned char*>(buffer.data());
+        bool zeroed = true;
+        for (size_t i = 0; i < bytes; i += 4093) {
+            zeroed &= memory[i] == 0;
+        }
+        check(zeroed && memory[bytes - 1] == 0, name + ": zero filled");
+        static_cast<unsigned char*>(buffer.data())[bytes - 1] = 1;
+
+        LargePages::Buffer moved(std::move(buffer));
+        check(buffer.data() == nullptr && moved.size() == bytes && moved.mode() >= request, name + ": move transfers ownership");
+
+        TranspositionTable table(4, request);
+        TTEntry entry;
+        table.store(0x123456789ULL, 5, -42, BoundLower, 0x1234);
+        check(table.probe(0x123456789ULL, entry) && entry.score == -42 && entry.move == 0x1234, name + ": table round trip");
+        check(!table.probe(0x987654321ULL, entry), name + ": table miss");
+    }
+    check(LargePages::Buffer(bytes, LargePages::Mode::Normal).mode() == LargePages::Mode::Normal, "normal stays normal");
+
+    return finish("large page");
+}
@@ -0,0 +1,97 @@
+#include "board.h"
+#include "check.h"
+#include "leaf_kernel.h"
+#include "move_generation.h"
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct PerftCase {
+    const char* fen;
+    int depth;
+    uint64_t nodes;
+};
+
+// Standard suite (chessprogramming.org/Perft_Results) plus en passant edge cases:
+// a capture that exposes the king along the rank, and one that removes a checking pawn
+static const PerftCase kCases[] = {
+    {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 4, 197281},
+    {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 3, 97862},
+    {"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 5, 674624},
+    {"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 4, 422333},
+    {"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 3, 62379},
+    {"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 3, 89890},
+};
+
+static const char* const kEnPassantFens[] = {
+    "8/8/8/K2pP2r/8/8/8/7k w - d6 0 1",
+    "8/8/8/2k5/3pP3/8/8/4K3 b - e3 0 1",
+    "8/8/8/8/k2Pp2Q/8/8/3K4 b - d3 0 1",
+    "8/8/8/1k6/3Pp3/8/8/4KQ2 b - d3 0 1",
+};
+
+// Every position of a tree, so the kernel sees checks, pins and promotions in context
+static void collect(Board& board, int depth, std::vector<Board>& positions) {
+    positions.push_back(board);
+    if (depth == 0) {
+        return;
+    }
+    bool isWhite = board.isWhiteToMove();
+    for (const Move& move : MoveGeneration::filterLegalMoves(board, board.generateMoves(isWhite), isWhite)) {
+        Board child = board;
+        child.makeMove(move);
+        collect(child, depth - 1, positions);
+    }
+}
+
+int main() {
+    std::vector<Board> positions;
+    for (const PerftCase& test : kCases) {
+        Board board;
+        board.loadFen(test.fen);
+        collect(board, 2, positions);
+    }
+    for (const char* fen : kEnPassantFens) {
+        Board board;
+        board.loadFen(fen);
+        collect(board, 2, positions);
+    }
+    std::vector<uint32_t> expected;
+    for (const Board& board : positions) {
+        bool isWhite = board.isWhiteToMove();
+        expected.push_back(static_cast<uint32_t>(
+            MoveGeneration::filterLegalMoves(board, board.generateMoves(isWhite), isWhite).size()));
+    }
+
+    for (LeafKernel::Path path : {LeafKernel::Path::Scalar, LeafKernel::Path::Avx2, LeafKernel::Path::Avx512}) {
+        if (!LeafKernel::available(path)) {
+            continue;
+        }
+        std::string name = LeafKernel::pathName(path);
+
+        // Odd count, so the last block is partly empty
+        std::vector<uint32_t> counts(positions.size() - 1);
+        LeafKernel::countLegalMoves(positions.data(), counts.size(), counts.data(), path);
+        size_t mismatches = 0;
+        for (size_t i = 0; i < counts.size(); ++i) {
+            if (counts[i] != expected[i]) {
+                if (++mismatches <= 5) {
+                    check(false, name + ": position " + std::to_string(i) + " counts " + std::to_string(counts[i]) + ", expected "
+                                 + std::to_string(expected[i]));
+                }
+            }
+        }
+        check(mismatches == 0, name + ": " + std::to_string(mismatches) + " mismatched counts");
+
+        for (const PerftCase& test : kCases) {
+            Board board;
+            board.loadFen(test.fen);
+            uint64_t nodes = LeafKernel::perft(board, test.depth, path);
+            check(nodes == test.nodes, name + " perft " + test.fen + ": " + std::to_string(nodes));
+        }
+    }
+    check(LeafKernel::available(LeafKernel::widest()), "widest path is available");
+
+    return finish("leaf kernel");
+}
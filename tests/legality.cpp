@@ -0,0 +1,125 @@
+#include "board.h"
+#include "check.h"
+#include "move_generation.h"
+#include "move.h"
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+static bool sameMove(const Move& a, const Move& b) {
+    return a.sourceSquare == b.sourceSquare && a.targetSquare == b.targetSquare
+        && a.promotionPiece == b.promotionPiece && a.isCapture == b.isCapture && a.isEnPassant == b.isEnPassant
+        && a.isCastling == b.isCastling && a.isPromotion == b.isPromotion && a.isDoublePawnPush == b.isDoublePawnPush
+        && a.previousEnPassantSquare == b.previousEnPassantSquare && a.capturedPiece == b.capturedPiece
+        && a.previousCastlingRights == b.previousCastlingRights && a.previousHalfmoveClock == b.previousHalfmoveClock;
+}
+
+// Every one of the 2^16 packed codes against the generated and filtered move lists, and
+// givesCheck against playing each legal move
+static void checkAllCodes(const Board& board, const std::string& where) {
+    bool isWhite = board.isWhiteToMove();
+    MoveList moves;
+    board.generateMoves(isWhite, moves);
+    std::vector<int> generated(1 << 16, -1);
+    std::vector<bool> legal(1 << 16, false);
+    CheckInfo info = board.checkInfo();
+    for (int i = 0; i < moves.size(); ++i) {
+        generated[moves[i].pack()] = i;
+        legal[moves[i].pack()] = MoveGeneration::isMoveLegal(board, moves[i], isWhite);
+        if (legal[moves[i].pack()]) {
+            Board child = board;
+            child.makeMove(moves[i]);
+            check(board.givesCheck(moves[i], info) == child.isInCheck(), where + ": " + moves[i].toString() + " gives check");
+        }
+    }
+    for (int code = 0; code < (1 << 16); ++code) {
+        uint16_t move = static_cast<uint16_t>(code);
+        if (board.isPseudoLegal(move) != (generated[code] >= 0) || board.isLegal(move) != legal[code]) {
+            check(false, where + ": packed move " + std::to_string(code));
+            return;
+        }
+        if (generated[code] >= 0 && !sameMove(board.decodeMove(move), moves[generated[code]])) {
+            check(false, where + ": decoded " + moves[generated[code]].toString());
+            return;
+        }
+    }
+}
+
+int main() {
+    // Parsing: UCI and long algebraic names of the same packed move
+    Move push(12, 28);
+    Move promotion(52, 60, Queen, false, false, false, true);
+    Move knightPromotion(52, 59, Knight, true, false, false, true);
+    check(parseMove("e2e4") == push.pack() && parseMove("e2-e4") == push.pack(), "pawn push");
+    check(parseMove("e7e8q") == promotion.pack() && parseMove("e7-e8=Q+") == promotion.pack(), "promotion");
+    check(parseMove("e7xd8n") == knightPromotion.pack() && parseMove("e7xd8=N#") == knightPromotion.pack(), "capture promotion");
+    check(parseMove("Ng1-f3") == Move(6, 21).pack() && parseMove("Ke1g1") == Move(4, 6).pack(), "piece letters");
+    for (const char* bad : {"", "e2", "e2e", "e2e2", "i2e4", "e2e9", "e7e8k", "e7e8=", "e2e4x", "O-O", "e2e4 "}) {
+        check(parseMove(bad) == 0, std::string("rejects \"") + bad + "\"");
+    }
+
+    // Positions with castling through attacks, pins, checks, en passant and promotions
+    const char* fens[] = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        "8/8/8/KPp4r/8/8/8/6k1 w - c6 0 2",         // En passant would expose the king along the rank
+        "4k3/8/8/8/8/8/4r3/R3K2R w KQ - 0 1",       // In check: no castling, block or capture
+        "4k3/8/8/8/1b6/8/8/4K2r w - - 0 1",         // Double check: king moves only
+        "4k3/8/8/8/8/8/8/r3K3 w - - 0 1",           // The king may not retreat along the checking rank
+        "4k3/4r3/8/8/8/8/4R3/4K3 w - - 0 1",        // Pinned rook moving along the pin
+        "3qk3/8/8/8/8/8/3P4/2B1K3 b - - 0 1",
+        "1n2k3/2P5/8/8/1B6/8/8/R3K2R w KQ - 0 1",   // Checks by promotion
+        "6B1/8/8/2Pp4/8/1k6/8/4K3 w - d6 0 1",      // En passant opening the bishop's diagonal
+        "5k2/8/8/8/8/8/8/4K2R w K - 0 1",           // Castling gives check with the rook
+    };
+    std::mt19937 random(2024);
+    int positions = 0;
+    for (const char* fen : fens) {
+        Board board;
+        check(board.loadFen(fen), std::string("load ") + fen);
+        checkAllCodes(board, fen);
+        ++positions;
+
+        // Random games from each, to reach positions no one wrote down
+        for (int game = 0; game < 4; ++game) {
+            Board walk = board;
+            for (int ply = 0; ply < 40; ++ply) {
+                bool isWhite = walk.isWhiteToMove();
+                std::vector<Move> legal = MoveGeneration::filterLegalMoves(walk, walk.generateMoves(isWhite), isWhite);
+                if (legal.empty()) {
+                    break;
+                }
+                walk.makeMove(legal[random() % legal.size()]);
+                checkAllCodes(walk, std::string(fen) + " after " + std::to_string(ply + 1) + " random plies");
+                ++positions;
+            }
+        }
+    }
+    check(positions > 1000, "enough positions checked");
+
+    // The special cases above, one by one
+    const char* checks[][3] = {
+        {"1n2k3/2P5/8/8/1B6/8/8/R3K2R w KQ - 0 1", "c7c8q", "1"},
+        {"1n2k3/2P5/8/8/1B6/8/8/R3K2R w KQ - 0 1", "c7b8r", "1"},
+        {"1n2k3/2P5/8/8/1B6/8/8/R3K2R w KQ - 0 1", "c7c8n", "0"},
+        {"6B1/8/8/2Pp4/8/1k6/8/4K3 w - d6 0 1", "c5d6", "1"},
+        {"6B1/8/8/2Pp4/8/1k6/8/4K3 w - d6 0 1", "c5c6", "0"},
+        {"5k2/8/8/8/8/8/8/4K2R w K - 0 1", "e1g1", "1"},
+        {"4k3/4r3/8/8/8/8/4R3/4K3 w - - 0 1", "e2e7", "1"},
+    };
+    for (const auto& entry : checks) {
+        Board board;
+        board.loadFen(entry[0]);
+        uint16_t move = parseMove(entry[1]);
+        check(board.isLegal(move) && board.givesCheck(board.decodeMove(move)) == (entry[2][0] == '1'),
+              std::string(entry[1]) + (entry[2][0] == '1' ? " checks" : " does not check"));
+    }
+
+    return finish("legality");
+}
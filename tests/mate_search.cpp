@@ -0,0 +1,93 @@
+#include "board.h"
+#include "check.h"
+#include "mate_search.h"
+#include "move_generation.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+static std::vector<Move> legalMoves(const Board& board) {
+    bool isWhite = board.isWhiteToMove();
+    return MoveGeneration::filterLegalMoves(board, board.generateMoves(isWhite), isWhite);
+}
+
+// The line is made of legal moves and ends with the side to move checkmated
+static bool endsInMate(Board board, const std::vector<Move>& pv) {
+    for (const Move& move : pv) {
+        bool found = false;
+        for (const Move& legal : legalMoves(board)) {
+            found = found || legal.pack() == move.pack();
+        }
+        if (!found) {
+            return false;
+        }
+        board.makeMove(move);
+    }
+    return legalMoves(board).empty() && board.isInCheck();
+}
+
+int main() {
+    MateSearch::Solver solver(16);
+
+    // Every suite problem is proven within its bound, along a line that really mates
+    for (const MateSearch::Problem& problem : MateSearch::suite()) {
+        Board board;
+        check(board.loadFen(problem.fen), std::string("load ") + problem.name);
+        check(MoveGeneration::isKingSafe(board, !board.isWhiteToMove()), std::string(problem.name) + ": legal position");
+        MateSearch::Limits limits;
+        limits.mateIn = problem.mateIn;
+        solver.clear();
+        MateSearch::Result result = solver.solve(board, limits);
+        check(result.proven && !result.disproven, std::string(problem.name) + ": proven");
+        check(result.mateIn >= 1 && result.mateIn <= problem.mateIn, std::string(problem.name) + ": within bound");
+        check(static_cast<int>(result.pv.size()) == 2 * result.mateIn - 1, std::string(problem.name) + ": pv length");
+        check(endsInMate(board, result.pv), std::string(problem.name) + ": pv mates");
+    }
+
+    // No mate: refuted rather than left open
+    Board start;
+    start.initializePosition();
+    MateSearch::Limits one;
+    one.mateIn = 1;
+    MateSearch::Result none = solver.solve(start, one);
+    check(none.disproven && !none.proven, "no mate in 1 from the start position");
+
+    Board rook;
+    rook.loadFen("8/8/8/3k4/8/8/8/K6R w - - 0 1");
+    MateSearch::Limits two;
+    two.mateIn = 2;
+    solver.clear();
+    check(solver.solve(rook, two).disproven, "no mate in 2 with a rook against a central king");
+
+    // The rook corner needs a quiet king move, so checks alone cannot mate
+    Board corner;
+    corner.loadFen("k7/8/8/3K4/8/8/8/7R w - - 0 1");
+    MateSearch::Limits checks;
+    checks.mateIn = 3;
+    checks.checksOnly = true;
+    solver.clear();
+    check(solver.solve(corner, checks).disproven, "checks only: rook corner refuted");
+    checks.checksOnly = false;
+    solver.clear();
+    check(solver.solve(corner, checks).proven, "all moves: rook corner proven");
+
+    // Running out of nodes leaves the question open
+    Board lasker;
+    lasker.loadFen("rn3rk1/pbppq1pp/1p2pb2/4N2Q/3PN3/3B4/PPP2PPP/R3K2R w KQ - 1 11");
+    MateSearch::Limits budget;
+    budget.nodes = 1;
+    solver.clear();
+    MateSearch::Result open = solver.solve(lasker, budget);
+    check(!open.proven && !open.disproven, "node limit leaves the result open");
+
+    // Proofs left in the table are reused, and the mate found does not change
+    MateSearch::Limits seven;
+    seven.mateIn = 7;
+    solver.clear();
+    MateSearch::Result first = solver.solve(lasker, seven);
+    MateSearch::Result again = solver.solve(lasker, seven);
+    check(first.proven && again.proven && again.nodes < first.nodes, "second solve reuses the table");
+    check(again.mateIn == first.mateIn, "same mate length on the second solve");
+
+    return finish("mate search");
+}
@@ -0,0 +1,62 @@
+#include "board.h"
+#include "check.h"
+#include "move_generation.h"
+#include "search.h"
+#include "transposition_table.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Fixed-depth search from a clean table; every reported line is collected
+static Search::Result run(const Board& board, int depth, int multiPV, std::vector<Search::Info>& infos) {
+    TranspositionTable table(16);
+    Search::Searcher searcher(table);
+    Search::Limits limits;
+    limits.depth = depth;
+    limits.multiPV = multiPV;
+    infos.clear();
+    return searcher.search(board, limits, [&](const Search::Info& info) { infos.push_back(info); });
+}
+
+int main() {
+    const char* fens[] = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    };
+    const int depth = 4, lines = 3;
+
+    for (const char* fen : fens) {
+        Board board;
+        board.loadFen(fen);
+        std::vector<Search::Info> single, multi;
+        Search::Result one = run(board, depth, 1, single);
+        check(one.bestMove.pack() == single.back().pv.front().pack(), std::string(fen) + ": single line reports its best move");
+        Search::Result three = run(board, depth, lines, multi);
+
+        check(multi.size() == static_cast<size_t>(depth * lines), std::string(fen) + ": one report per line per depth");
+        for (int d = 1; d <= depth && multi.size() == static_cast<size_t>(depth * lines); ++d) {
+            const Search::Info* reports = &multi[(d - 1) * lines];
+            for (int line = 0; line < lines; ++line) {
+                check(reports[line].depth == d && reports[line].multiPV == line + 1, std::string(fen) + ": report order");
+                check(!reports[line].pv.empty(), std::string(fen) + ": every line has a move");
+                for (int earlier = 0; earlier < line; ++earlier) {
+                    check(reports[line].pv.front().pack() != reports[earlier].pv.front().pack(),
+                          std::string(fen) + ": lines start with different moves");
+                    check(reports[line].score <= reports[earlier].score, std::string(fen) + ": lines come best first");
+                }
+            }
+        }
+        check(three.bestMove.pack() == multi[(depth - 1) * lines].pv.front().pack(), std::string(fen) + ": best move is line 1");
+    }
+
+    // More lines than legal moves: only the legal ones are reported
+    {
+        Board board;
+        board.loadFen("k7/8/1K6/8/8/8/8/1R6 b - - 0 1");
+        std::vector<Search::Info> infos;
+        run(board, 2, 5, infos);
+        check(infos.size() == 2, "a lone legal move gives one line per depth");
+    }
+
+    return finish("multipv");
+}
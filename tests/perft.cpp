@@ -0,0 +1,131 @@
+#include "attacks.h"
+#include "board.h"
+#include "key_history.h"
+#include "move_generation.h"
+#include "perft.h"
+#include <cstdint>
+#include <iostream>
+
+// Reference perft counts for the standard suite (chessprogramming.org/Perft_Results)
+struct PerftCase {
+    const char* fen;
+    int depth;
+    uint64_t nodes;
+};
+
+static const PerftCase kCases[] = {
+    {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 4, 197281},
+    {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 3, 97862},
+    {"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 4, 43238},
+    {"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 3, 9467},
+    {"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 3, 62379},
+    {"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 3, 89890},
+};
+
+// Attacker counts against a square-by-square recount
+static bool attackCountsConsistent(const Board& board) {
+    uint64_t occupied = board.getOccupiedSquares();
+    for (PieceColor side : {White, Black}) {
+        uint64_t diagonal = board.getPieces(side, Bishop) | board.getPieces(side, Queen);
+        uint64_t straight = board.getPieces(side, Rook) | board.getPieces(side, Queen);
+        for (int square = 0; square < 64; ++square) {
+            uint64_t bit = 1ULL << square;
+            uint64_t pawnSources = side == White ? MoveGeneration::pawnAttacks<Black>(bit) : MoveGeneration::pawnAttacks<White>(bit);
+            int expected = __builtin_popcountll(pawnSources & board.getPieces(side, Pawn))
+                         + __builtin_popcountll(MoveGeneration::knightAttacks[square] & board.getPieces(side, Knight))
+                         + __builtin_popcountll(MoveGeneration::generateBishopMovesFromSquare(square, occupied) & diagonal)
+                         + __builtin_popcountll(MoveGeneration::generateRookMovesFromSquare(square, occupied) & straight)
+                         + __builtin_popcountll(MoveGeneration::generateKingMovesFromSquare(square, 0ULL) & board.getPieces(side, King));
+            if (board.getAttackerCount(side, square) != expected || board.isAttacked(square, side) != (expected > 0)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// The incrementally updated key and attack maps must match a from-scratch computation at
+// every node, after makeMove and after undoMove
+static bool keysConsistent(Board& board, int depth) {
+    if (board.getKey() != board.computeKey() || !attackCountsConsistent(board)) {
+        return false;
+    }
+    if (depth == 0) {
+        return true;
+    }
+    bool isWhite = board.isWhiteToMove();
+    for (const Move& move : MoveGeneration::filterLegalMoves(board, board.generateMoves(isWhite), isWhite)) {
+        board.makeMove(move);
+        bool ok = keysConsistent(board, depth - 1);
+        board.undoMove(move);
+        if (!ok) {
+            return false;
+        }
+    }
+    return board.getKey() == board.computeKey() && attackCountsConsistent(board);
+}
+
+// Set-wise attack maps (SIMD and scalar) must match the square-by-square ray walkers
+static bool attacksConsistent(const Board& board) {
+    uint64_t occupied = board.getOccupiedSquares();
+    for (PieceColor side : {White, Black}) {
+        uint64_t expected[7] = {0};
+        for (int square = 0; square < 64; ++square) {
+            uint64_t bit = 1ULL << square;
+            if (board.getPieces(side, Knight) & bit) expected[Knight] |= MoveGeneration::knightAttacks[square];
+            if (board.getPieces(side, Bishop) & bit) expected[Bishop] |= MoveGeneration::generateBishopMovesFromSquare(square, occupied);
+            if (board.getPieces(side, Rook) & bit) expected[Rook] |= MoveGeneration::generateRookMovesFromSquare(square, occupied);
+            if (board.getPieces(side, Queen) & bit) expected[Queen] |= MoveGeneration::generateQueenMovesFromSquare(square, occupied);
+            if (board.getPieces(side, King) & bit) expected[King] |= MoveGeneration::generateKingMovesFromSquare(square, 0ULL);
+        }
+
+        Attacks::AttackMap map = Attacks::attackMap(board, side);
+        uint64_t bishops, rooks, queens;
+        Attacks::sliderAttacksScalar(board.getPieces(side, Bishop), board.getPieces(side, Rook),
+                                     board.getPieces(side, Queen), occupied, bishops, rooks, queens);
+        for (int pieceType = Knight; pieceType <= King; ++pieceType) {
+            if (map.byPiece[pieceType] != expected[pieceType]) {
+                return false;
+            }
+        }
+        if (bishops != expected[Bishop] || rooks != expected[Rook] || queens != expected[Queen] ||
+            Attacks::allAttacks(board, side) != map.all) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main() {
+    int failures = 0;
+
+    for (const PerftCase& test : kCases) {
+        Board board;
+        board.loadFen(test.fen);
+        uint64_t key = board.getKey();
+
+        uint64_t serial = Perft::perft(board, test.depth);
+        uint64_t copyMake = Perft::perftCopyMake(board, test.depth);
+
+        // Threads sharing a hash table must give the same count, and leave a history attached
+        // to the position alone
+        KeyHistory history;
+        history.push(key);
+        board.setKeyHistory(&history);
+        Perft::HashTable table(4);
+        uint64_t parallel = Perft::parallelPerft(board, test.depth, 3, 2, &table);
+        board.setKeyHistory(nullptr);
+
+        bool ok = serial == test.nodes && copyMake == test.nodes && parallel == test.nodes && board.getKey() == key &&
+                  history.size() == 1 &&
+                  keysConsistent(board, 2) && attacksConsistent(board);
+        if (!ok) {
+            std::cout << "FAIL " << test.fen << " depth " << test.depth << ": expected " << test.nodes
+                      << ", serial " << serial << ", copy-make " << copyMake << ", parallel " << parallel << std::endl;
+            ++failures;
+        }
+    }
+
+    std::cout << (failures ? "perft tests failed" : "perft tests passed") << std::endl;
+    return failures ? 1 : 0;
+}
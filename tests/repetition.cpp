@@ -0,0 +1,95 @@
+#include "board.h"
+#include "check.h"
+#include "cuckoo.h"
+#include "key_history.h"
+#include "move_generation.h"
+#include "search.h"
+#include "transposition_table.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Plays a move given in long algebraic notation; returns false if it is not legal
+static bool play(Board& board, const std::string& name) {
+    bool isWhite = board.isWhiteToMove();
+    for (const Move& move : MoveGeneration::filterLegalMoves(board, board.generateMoves(isWhite), isWhite)) {
+        if (move.toString() == name) {
+            board.makeMove(move);
+            return true;
+        }
+    }
+    return false;
+}
+
+int main() {
+    check(Cuckoo::entryCount() == 3668, "cuckoo table holds every reversible move");
+
+    // Knights out and back: the start position repeats after four plies
+    {
+        Board board;
+        KeyHistory history;
+        board.initializePosition();
+        board.setKeyHistory(&history);
+        const char* shuffle[] = {"g1f3", "g8f6", "f3g1"};
+        for (const char* move : shuffle) {
+            check(play(board, move), std::string("legal ") + move);
+        }
+        check(!board.isRepetition(), "no repetition after three plies");
+        check(board.hasUpcomingRepetition(4), "f6g8 is an upcoming repetition");
+        check(!board.hasUpcomingRepetition(3), "cycles reaching back past the root do not count");
+        check(play(board, "f6g8"), "legal f6g8");
+        check(board.isRepetition(), "start position repeated");
+        check(board.getHalfmoveClock() == 4 && history.size() == 4, "clock and history after four plies");
+    }
+
+    // A pawn move is irreversible: the scan stops there
+    {
+        Board board;
+        KeyHistory history;
+        board.initializePosition();
+        board.setKeyHistory(&history);
+        const char* moves[] = {"g1f3", "g8f6", "e2e4", "f6g8", "f3g1", "g8f6", "g1f3", "f6g8"};
+        for (const char* move : moves) {
+            check(play(board, move), std::string("legal ") + move);
+        }
+        check(board.getHalfmoveClock() == 5, "clock reset by the pawn move");
+        check(board.isRepetition(), "repetition after the pawn move");
+    }
+
+    // make/undo keeps the clock and the history balanced
+    {
+        Board board;
+        KeyHistory history;
+        board.loadFen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 7 20");
+        board.setKeyHistory(&history);
+        for (const Move& move : board.generateMoves(true)) {
+            board.makeMove(move);
+            board.undoMove(move);
+        }
+        check(board.getHalfmoveClock() == 7 && history.size() == 0, "make/undo restores clock and history");
+        check(!board.isFiftyMoveDraw(), "no 50-move draw at 7 plies");
+        board.loadFen("8/8/4k3/8/8/4K3/4R3/8 w - - 100 90");
+        check(board.isFiftyMoveDraw(), "50-move draw at 100 plies");
+    }
+
+    // Search works on its own copy of the history, with make/unmake and with copy-make
+    for (bool copyMake : {false, true}) {
+        TranspositionTable table(4);
+        Search::Searcher searcher(table);
+        searcher.setCopyMake(copyMake);
+        Board board;
+        KeyHistory history;
+        board.initializePosition();
+        board.setKeyHistory(&history);
+        const char* moves[] = {"g1f3", "g8f6", "f3g1", "f6g8"};
+        for (const char* move : moves) {
+            play(board, move);
+        }
+        Search::Limits limits;
+        limits.depth = 5;
+        Search::Result result = searcher.search(board, limits);
+        check(result.hasMove && history.size() == 4, "search leaves the game history untouched");
+    }
+
+    return finish("repetition");
+}
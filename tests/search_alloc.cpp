@@ -0,0 +1,100 @@
+#include "board.h"
+#include "check.h"
+#include "key_history.h"
+#include "move_generation.h"
+#include "search.h"
+#include "transposition_table.h"
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+// Counts every allocation made while counting is on. The array forms forward to the scalar
+// ones, and libstdc++'s nothrow forms call them too.
+static std::atomic<bool> counting(false);
+static std::atomic<long> allocations(0);
+
+void* operator new(std::size_t size) {
+    if (counting.load(std::memory_order_relaxed)) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (void* memory = std::malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    if (counting.load(std::memory_order_relaxed)) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    std::size_t align = static_cast<std::size_t>(alignment);
+    if (void* memory = std::aligned_alloc(align, (size + align - 1) / align * align)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return operator new(size, alignment); }
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept { std::free(memory); }
+
+// Allocations made by one search on a freshly constructed searcher
+static long countSearchAllocations(const Board& board, bool copyMake, int multiPV) {
+    TranspositionTable table(4);
+    Search::Searcher searcher(table);
+    searcher.setCopyMake(copyMake);
+    Search::Limits limits;
+    limits.depth = 6;
+    limits.multiPV = multiPV;
+    int reports = 0;
+    auto onIteration = [&reports](const Search::Info& info) { reports += info.pv.empty() ? 0 : 1; };
+    std::function<void(const Search::Info&)> callback(onIteration);
+
+    allocations = 0;
+    counting = true;
+    Search::Result result = searcher.search(board, limits, callback);
+    counting = false;
+
+    check(result.hasMove && reports > 0, "search produced a move and reports");
+    return allocations;
+}
+
+int main() {
+    // The hook itself sees allocations
+    allocations = 0;
+    counting = true;
+    std::vector<Move> probe = Board().generateMoves(true);
+    counting = false;
+    check(allocations > 0, "allocation counter works");
+
+    const char* fens[] = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    };
+    for (const char* fen : fens) {
+        Board board;
+        KeyHistory history;
+        board.loadFen(fen);
+        board.setKeyHistory(&history);
+        for (bool copyMake : {false, true}) {
+            for (int multiPV : {1, 3}) {
+                long count = countSearchAllocations(board, copyMake, multiPV);
+                check(count == 0, std::string(fen) + (copyMake ? " copy-make" : " make/unmake") + " multipv "
+                                  + std::to_string(multiPV) + ": " + std::to_string(count) + " allocations");
+            }
+        }
+    }
+
+    return finish("search allocation");
+}
@@ -0,0 +1,69 @@
+#include "board.h"
+#include "check.h"
+#include "search.h"
+#include "search_profile.h"
+#include "transposition_table.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+
+int main() {
+    Board board;
+    board.loadFen("r1bq1rk1/pp2b1pp/n1pp1n2/3P1p2/2P1p3/2N1P2N/PP2BPPP/R1BQ1RK1 b - - 2 10");
+    Search::Limits limits;
+    limits.depth = 6;
+
+    // The profile only watches: the same tree is searched with and without it
+    TranspositionTable table(4);
+    Search::Searcher searcher(table);
+    Search::Result plain = searcher.search(board, limits);
+
+    table.clear();
+    searcher.clear();
+    Search::Profile profile;
+    searcher.setProfile(&profile);
+    Search::Result profiled = searcher.search(board, limits);
+    check(profiled.nodes == plain.nodes && profiled.bestMove.pack() == plain.bestMove.pack(), "same search when profiled");
+
+    // Every node is counted once, by ply and by iteration
+    Search::PlyProfile total = profile.total();
+    check(profile.searches == 1, "one search");
+    check(total.nodes + total.qnodes == profiled.nodes, "plies add up to the nodes searched");
+    uint64_t depthNodes = 0, depthQNodes = 0;
+    for (int depth = 1; depth <= 6; ++depth) {
+        check(profile.depths[depth].searches == 1, "iteration " + std::to_string(depth) + " recorded");
+        depthNodes += profile.depths[depth].nodes;
+        depthQNodes += profile.depths[depth].qnodes;
+    }
+    check(profile.depths[7].searches == 0, "no iteration past the limit");
+    check(depthNodes == profiled.nodes && depthQNodes == total.qnodes, "iterations add up to the nodes searched");
+    check(profile.plies[0].nodes == 6 && profile.plies[0].qnodes == 0, "one root node per iteration");
+    check(profile.depthBranchingFactor(6) > 1.0 && profile.plyBranchingFactor(0) > 1.0, "trees grow");
+
+    uint64_t histogram = 0;
+    for (uint64_t count : profile.cutoffIndex) {
+        histogram += count;
+    }
+    check(total.cutoffs > 0 && histogram == total.cutoffs, "every cutoff has an index");
+    check(profile.cutoffIndex[0] == total.firstMoveCutoffs, "first slot holds the first-move cutoffs");
+    check(total.ttCuts <= total.ttHits && total.ttHits <= total.ttProbes && total.ttProbes <= total.nodes,
+          "at most one probe per main node");
+    check(total.researches <= total.reductions && total.nullMoveCuts <= total.nullMoves, "rates at most one");
+    check(total.reductions > 0 && total.nullMoves > 0 && total.qnodes > 0, "tree shape recorded");
+
+    // Profiles accumulate over searches until cleared
+    table.clear();
+    searcher.clear();
+    searcher.search(board, limits);
+    check(profile.searches == 2 && profile.total().nodes == 2 * total.nodes, "second search added");
+    std::ostringstream json;
+    profile.writeJson(json);
+    std::string text = json.str();
+    check(text.front() == '{' && text.back() == '}' && text.find("\"depths\": [{\"depth\": 1,") != std::string::npos
+          && text.find("\"plies\": [{\"ply\": 0,") != std::string::npos && text.find("\"cutoff_index\": [") != std::string::npos,
+          "json export");
+    profile.clear();
+    check(profile.searches == 0 && profile.total().nodes == 0, "cleared");
+
+    return finish("search profile");
+}
@@ -0,0 +1,170 @@
+#include "check.h"
+#include "move_generation.h"
+#include "server.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Minimal blocking line client over the Unix socket
+class Client {
+public:
+    explicit Client(const std::string& path) : fd(::socket(AF_UNIX, SOCK_STREAM, 0)) {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    ~Client() {
+        if (fd >= 0) ::close(fd);
+    }
+
+    bool connected() const { return fd >= 0; }
+
+    void send(const std::string& line) {
+        std::string data = line + "\n";
+        if (::send(fd, data.data(), data.size(), 0) != static_cast<ssize_t>(data.size())) {
+            std::cout << "FAIL send" << std::endl;
+            ++failures;
+        }
+    }
+
+    // Next response line parsed into fields; false if the connection closed
+    bool receive(std::map<std::string, std::string>& fields) {
+        while (pending.find('\n') == std::string::npos) {
+            char buffer[4096];
+            ssize_t received = ::recv(fd, buffer, sizeof(buffer), 0);
+            if (received <= 0) return false;
+            pending.append(buffer, static_cast<size_t>(received));
+        }
+        std::string line = pending.substr(0, pending.find('\n'));
+        pending.erase(0, line.size() + 1);
+        return Server::parseJsonObject(line, fields);
+    }
+
+    // Skips info lines; returns the final response for any request
+    std::map<std::string, std::string> final(int& infoLines) {
+        std::map<std::string, std::string> fields;
+        while (receive(fields) && fields["type"] == "info") {
+            ++infoLines;
+        }
+        return fields;
+    }
+
+private:
+    int fd;
+    std::string pending;
+};
+
+int main() {
+    std::map<std::string, std::string> fields;
+    check(Server::parseJsonObject("{\"id\": \"a\\\"b\", \"depth\": 12, \"stats\": true}", fields), "parse flat object");
+    check(fields["id"] == "a\"b" && fields["depth"] == "12" && fields["stats"] == "true", "parsed values");
+    check(!Server::parseJsonObject("{\"id\": }", fields), "reject malformed object");
+    check(Server::parseJsonObject("{\"id\": \"\\u00e9\\u20ac\\ud83d\\ude00\\r\\b\\f\\/\"}", fields)
+          && fields["id"] == "\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80\r\b\f/", "decode escapes");
+    check(!Server::parseJsonObject("{\"id\": \"\\x\"}", fields) && !Server::parseJsonObject("{\"id\": \"\\u12\"}", fields)
+          && !Server::parseJsonObject("{\"id\": \"\\udc00\"}", fields), "reject bad escapes");
+
+    Server::Options options;
+    options.socketPath = "server_test.sock";
+    options.threads = 2;
+    options.maxQueued = 0;
+    options.hashMegabytes = 4;
+    Server::AnalysisServer server(options);
+    std::string error;
+    check(server.start(error), "server starts: " + error);
+
+    // A second server on the same path leaves the live one alone
+    {
+        Server::AnalysisServer rival(options);
+        std::string rivalError;
+        check(!rival.start(rivalError) && !rivalError.empty(), "path in use is an error");
+    }
+
+    Client client(options.socketPath);
+    check(client.connected(), "client connects");
+
+    // Two searches on two workers; both stream info lines, then answer
+    client.send("{\"id\":\"a\",\"depth\":3}");
+    client.send("{\"id\":\"b\",\"fen\":\"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1\",\"depth\":3,\"multipv\":2}");
+    int infoLines = 0;
+    std::map<std::string, std::string> first = client.final(infoLines);
+    std::map<std::string, std::string> second = client.final(infoLines);
+    check(first["type"] == "bestmove" && second["type"] == "bestmove", "both requests answered");
+    check(first["id"] != second["id"], "answers carry their ids");
+    check(infoLines >= 3 + 6, "info lines stream per depth and line");
+
+    // An id escaped the way JSON encoders escape non-ASCII comes back as the same string
+    client.send("{\"id\":\"caf\\u00e9\\r1\",\"depth\":1}");
+    std::map<std::string, std::string> escaped = client.final(infoLines);
+    check(escaped["type"] == "bestmove" && escaped["id"] == "caf\xC3\xA9\r1", "escaped id echoed");
+
+    client.send("not json");
+    check(client.final(infoLines)["type"] == "error", "malformed request is an error");
+    client.send("{\"id\":\"c\",\"fen\":\"8/8/8/8/8/8/8/8 w - - 0 1\"}");
+    check(client.final(infoLines)["type"] == "error", "position without kings is an error");
+
+    // Admission: with no queue, a third request while both workers search is rejected
+    client.send("{\"id\":\"long1\",\"depth\":60,\"movetime\":5000}");
+    client.send("{\"id\":\"long2\",\"depth\":60,\"movetime\":5000}");
+    client.send("{\"id\":\"long3\",\"depth\":60,\"movetime\":5000}");
+    std::map<std::string, std::string> rejected = client.final(infoLines);
+    check(rejected["type"] == "rejected" && rejected["id"] == "long3", "third request rejected");
+
+    // Cancelling ends a running search early with its best move so far; a request still
+    // waiting for a worker is answered "cancelled" instead
+    auto start = std::chrono::steady_clock::now();
+    client.send("{\"cancel\":\"long1\"}");
+    client.send("{\"cancel\":\"long2\"}");
+    std::map<std::string, std::string> cancelled1 = client.final(infoLines);
+    std::map<std::string, std::string> cancelled2 = client.final(infoLines);
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    for (auto* response : {&cancelled1, &cancelled2}) {
+        check((*response)["type"] == "cancelled" || ((*response)["type"] == "bestmove" && (*response)["cancelled"] == "true"),
+              "cancelled request answers");
+    }
+    check(elapsed < 4000, "cancellation stops the search before its time is up");
+    client.send("{\"cancel\":\"nothing\"}");
+    check(client.final(infoLines)["type"] == "error", "cancelling an unknown id is an error");
+
+    client.send("{\"stats\":true}");
+    std::map<std::string, std::string> stats = client.final(infoLines);
+    check(stats["type"] == "stats", "stats answered");
+
+    Server::Metrics metrics = server.metrics();
+    check(metrics.accepted == 5 && metrics.rejected == 1, "admission counters");
+    check(metrics.cancelled == 2 && metrics.completed >= 2, "completion counters");
+    check(metrics.queued == 0 && metrics.running == 0, "nothing left in flight");
+    check(metrics.p99Ms >= metrics.p50Ms && metrics.p50Ms > 0, "latency percentiles");
+    server.stop();
+
+    // Only sockets are cleared from the path, and only when no server answers on them
+    {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::strcpy(address.sun_path, options.socketPath.c_str());
+        int leftover = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        ::bind(leftover, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+        ::close(leftover);
+        Server::AnalysisServer restarted(options);
+        check(restarted.start(error), "leftover socket replaced: " + error);
+    }
+    std::ofstream("server_test.txt") << "keep";
+    Server::Options fileOptions = options;
+    fileOptions.socketPath = "server_test.txt";
+    Server::AnalysisServer onFile(fileOptions);
+    check(!onFile.start(error) && std::ifstream("server_test.txt").good(), "regular file is not removed");
+    std::remove("server_test.txt");
+
+    return finish("server");
+}
@@ -0,0 +1,101 @@
+#include "check.h"
+#include "transposition_table.h"
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static bool has(const TranspositionTable& table, uint64_t key, int score) {
+    TTEntry entry;
+    return table.probe(key, entry) && entry.score == score && entry.depth == 7 && entry.bound == BoundExact;
+}
+
+// Overwrites bytes of the file in place
+static void patch(const std::string& path, long offset, const std::string& bytes) {
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(offset);
+    file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+int main() {
+    const std::string path = "tt_file_test.tt";
+    const size_t headerBytes = 4096, slotBytes = 16;
+    const uint64_t keys[] = {0x0123456789ABCDEFULL, 0xFEDCBA9876543210ULL, 0x0F0F0F0F12345678ULL};
+    std::remove(path.c_str());
+    std::string error;
+
+    {
+        TranspositionTable first(1), second(1);
+        check(first.mapFile(path, 4, error) && first.isMapped(), "new file maps: " + error);
+        check(first.sizeInMegabytes() == 4, "new file takes the requested size");
+        for (int i = 0; i < 3; ++i) {
+            first.store(keys[i], 7, 100 + i, BoundExact, 0);
+        }
+
+        // A second mapping of the same file sees the entries, and its writes are seen back
+        check(second.mapFile(path, 64, error), "second mapping: " + error);
+        check(second.sizeInMegabytes() == 4, "valid file keeps its own size");
+        check(has(second, keys[0], 100) && has(second, keys[2], 102), "entries shared between mappings");
+        second.store(keys[1], 7, -5, BoundExact, 0);
+        check(has(first, keys[1], -5), "writes shared between mappings");
+    }
+
+    // Another process writes to the same file
+    pid_t child = fork();
+    if (child == 0) {
+        TranspositionTable table(1);
+        std::string childError;
+        bool ok = table.mapFile(path, 4, childError) && has(table, keys[0], 100);
+        table.store(0x1111222233334444ULL, 7, 42, BoundExact, 0);
+        _exit(ok ? 0 : 1);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    check(WIFEXITED(status) && WEXITSTATUS(status) == 0, "child process reads the file");
+
+    {
+        // Entries survive the processes that wrote them
+        TranspositionTable table(1);
+        check(table.mapFile(path, 4, error), "remap: " + error);
+        check(has(table, keys[0], 100) && has(table, keys[1], -5) && has(table, 0x1111222233334444ULL, 42),
+              "entries persist across runs and processes");
+        uint64_t mask = 4 * 1024 * 1024 / slotBytes - 1;
+
+        // A damaged slot misses instead of returning garbage
+        patch(path, static_cast<long>(headerBytes + (keys[0] & mask) * slotBytes), "garbage!");
+        check(!has(table, keys[0], 100), "damaged slot misses");
+        TTEntry entry;
+        check(!table.probe(keys[0], entry), "damaged slot is not a hit");
+        check(has(table, keys[2], 102), "undamaged slots still hit");
+
+        table.resize(1);
+        check(!table.isMapped(), "resize returns to private memory");
+    }
+
+    // A header from another format version discards the file. It is replaced, not shrunk,
+    // so a table still mapping the old one keeps its entries instead of faulting.
+    {
+        TranspositionTable stale(1);
+        check(stale.mapFile(path, 4, error) && has(stale, keys[2], 102), "stale mapping: " + error);
+        patch(path, 8, std::string("\x7F\x00\x00\x00", 4));
+        TranspositionTable table(1);
+        check(table.mapFile(path, 2, error), "mismatched version remaps: " + error);
+        check(table.sizeInMegabytes() == 2 && !has(table, keys[2], 102), "mismatched version starts empty");
+        check(has(stale, keys[2], 102), "old mapping survives the replacement");
+        table.store(keys[1], 7, 201, BoundExact, 0);
+        check(!has(stale, keys[1], 201), "old mapping is no longer shared");
+        TranspositionTable again(1);
+        check(again.mapFile(path, 8, error) && again.sizeInMegabytes() == 2 && has(again, keys[1], 201),
+              "replacement is the file at the path");
+    }
+
+    TranspositionTable table(1);
+    check(!table.mapFile("no_such_directory/table.tt", 1, error) && !error.empty(), "unopenable path is an error");
+    check(!table.isMapped() && (table.store(keys[0], 7, 1, BoundExact, 0), has(table, keys[0], 1)), "failed map keeps the table");
+
+    std::remove(path.c_str());
+    return finish("tt file");
+}
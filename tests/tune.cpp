@@ -0,0 +1,138 @@
+#include "board.h"
+#include "check.h"
+#include "evaluate.h"
+#include "move_generation.h"
+#include "tune.h"
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Positions from random games, labelled by a material count the default weights disagree
+// with (knights worth a rook), so tuning has something to find
+static void randomPositions(Tune::Dataset& data, int games) {
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+    for (int game = 0; game < games; ++game) {
+        Board board;
+        board.initializePosition();
+        for (int ply = 0; ply < 80; ++ply) {
+            std::vector<Move> moves = board.generateMoves(board.isWhiteToMove());
+            moves = MoveGeneration::filterLegalMoves(board, moves, board.isWhiteToMove());
+            if (moves.empty()) {
+                break;
+            }
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            board.makeMove(moves[state % moves.size()]);
+            if (ply % 4 == 3) {
+                const int values[7] = {0, 100, 500, 330, 500, 900, 0};
+                int material = 0;
+                for (int piece = Pawn; piece <= Queen; ++piece) {
+                    material += values[piece] * (__builtin_popcountll(board.getPieces(White, piece))
+                                                 - __builtin_popcountll(board.getPieces(Black, piece)));
+                }
+                data.add(board, static_cast<float>(1.0 / (1.0 + std::pow(10.0, -material / 400.0))));
+            }
+        }
+    }
+}
+
+int main() {
+    // The header written for the default weights is the one the engine compiles
+    std::ostringstream written;
+    Tune::writeHeader(written, Tune::defaultParameters());
+    std::ifstream source(std::string(ENGINE_SOURCE_DIR) + "/include/evaluate_params.h");
+    std::stringstream checkedIn;
+    checkedIn << source.rdbuf();
+    check(source && written.str() == checkedIn.str(), "default weights reproduce evaluate_params.h");
+
+    // Result formats; unparsable lines are skipped
+    const std::string path = "tune_test.epd";
+    {
+        std::ofstream file(path);
+        file << "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 1/2-1/2\n"
+             << "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1 [1.0]\n"
+             << "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 b - - c9 \"0-1\";\n"
+             << "rnbqkb1r/pp1p1ppp/5n2/2pPp3/8/8/PPP1PPPP/RNBQKBNR w KQkq e6 0 4 0.5\n"
+             << "4k3/8/8/8/8/8/8/4K2R w K - 0 1 draw\n"
+             << "\n";
+    }
+    Tune::Dataset data;
+    size_t skipped = 0;
+    std::string error;
+    check(data.load(path, skipped, error), "load text positions: " + error);
+    check(data.size() == 4 && skipped == 1, "four positions, one line skipped");
+    std::remove(path.c_str());
+    check(!data.load("no/such/file.epd", skipped, error), "missing file is an error");
+
+    // The sparse features reproduce the engine's evaluation, up to its integer rounding
+    const char* fens[] = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 b - - 0 1",
+        "rnbqkb1r/pp1p1ppp/5n2/2pPp3/8/8/PPP1PPPP/RNBQKBNR w KQkq e6 0 4",
+    };
+    Tune::Tuner exact(data, Tune::defaultParameters());
+    for (size_t i = 0; i < 4; ++i) {
+        Board board;
+        board.loadFen(fens[i]);
+        int engine = Evaluation::evaluate(board) * (board.isWhiteToMove() ? 1 : -1);
+        check(std::fabs(exact.evaluate(i) - engine) < 1.0, std::string("evaluation matches: ") + fens[i]);
+    }
+
+    Tune::Dataset games;
+    randomPositions(games, 60);
+    check(games.size() > 500, "random positions collected");
+
+    // Analytic gradient against central differences
+    Tune::Tuner tuner(games, Tune::defaultParameters(), 1);
+    const double scale = 1.0;
+    tuner.loss(scale, true);
+    std::vector<double> analytic = tuner.gradient();
+    for (int index : {1, Tune::MaterialTerms + 1, 10 + 64 + 20, 10 + 2 * 64 + 27, 10 + 6 * 64 + 6}) {
+        std::vector<double> shifted = Tune::defaultParameters();
+        shifted[index] += 0.5;
+        tuner.setParameters(shifted);
+        double above = tuner.loss(scale);
+        shifted[index] -= 1.0;
+        tuner.setParameters(shifted);
+        double below = tuner.loss(scale);
+        double numeric = above - below;
+        check(std::fabs(numeric - analytic[index]) <= 1e-3 * std::fabs(analytic[index]) + 1e-9,
+              "gradient of weight " + std::to_string(index));
+    }
+
+    // The split over threads only changes the summation order
+    Tune::Tuner threaded(games, Tune::defaultParameters(), 3);
+    double oneThread = Tune::Tuner(games, Tune::defaultParameters(), 1).loss(scale);
+    check(std::fabs(threaded.loss(scale, true) - oneThread) < 1e-9, "threaded loss");
+    bool same = true;
+    for (int i = 0; i < Tune::ParameterCount; ++i) {
+        same = same && std::fabs(threaded.gradient()[i] - analytic[i]) <= 1e-9 + 1e-6 * std::fabs(analytic[i]);
+    }
+    check(same, "threaded gradient");
+
+    // Both optimisers lower the loss, and Adam moves the knight towards the labels' value
+    Tune::Tuner adam(games, Tune::defaultParameters(), 2);
+    double fitted = adam.fitScale();
+    check(fitted > 0.05 && fitted < 4.0, "scale inside the search range");
+    double first = adam.stepAdam(fitted, 2.0);
+    for (int step = 0; step < 60; ++step) {
+        adam.stepAdam(fitted, 2.0);
+    }
+    check(adam.loss(fitted) < 0.9 * first, "adam lowers the loss");
+    check(adam.parameters()[Knight - Pawn] > Tune::defaultParameters()[Knight - Pawn], "knight value rises");
+
+    Tune::Tuner descent(games, Tune::defaultParameters(), 2);
+    double start = descent.stepGradientDescent(fitted, 100000.0);
+    for (int step = 0; step < 20; ++step) {
+        descent.stepGradientDescent(fitted, 100000.0);
+    }
+    check(descent.loss(fitted) < start, "gradient descent lowers the loss");
+
+    return finish("tune");
+}